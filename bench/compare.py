@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# -*- mode:python; indent-tabs-mode:nil; -*-
+#
+# Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+# All rights reserved.
+#
+# You should have received a copy of the FreeBSD license, if not see:
+# <http://www.freebsd.org/copyright/freebsd-license.html>.
+
+"""Compare two vincenty.bench JSON outputs.
+
+Prints the change of every benchmark found in both runs, with a 95%
+confidence interval computed from the repetitions of each run (Welch's
+t-interval of the difference of the means, relative to the baseline mean).
+
+A gated benchmark is a regression when the whole confidence interval of its
+slowdown is above the threshold, and the exit status is then 1. The status is
+2 for usage errors and missing baselines. The interval only covers the noise
+within each run, a machine which is busy during one of the runs shifts all
+results alike; store baselines from, and compare on, an idle machine.
+
+Baselines are kept per machine in bench/baselines/<tag>.json, the tag is
+made from the CPU model and the instruction set recorded in the run:
+
+  vincenty.bench --json new.json --repetitions 10
+  bench/compare.py new.json              # against the baseline of the tag
+  bench/compare.py old.json new.json     # against any other run
+  bench/compare.py --update new.json     # store new.json as the baseline
+"""
+
+import argparse
+import json
+import math
+import os
+import re
+import shutil
+import sys
+
+BASELINES = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                         "baselines")
+
+# The kernels, and the grid split, are gated by default.
+GATE = r"^(inverse|inverse_batch|direct|direct_batch|grid_split)/"
+
+# Two sided 95% quantiles of Student's t distribution, by degrees of freedom.
+T95 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+       2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101,
+       2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052,
+       2.048, 2.045, 2.042]
+
+
+def t95(df):
+    if df < 1:
+        return float("inf")
+    if df > len(T95):
+        return 1.960
+    return T95[int(math.floor(df)) - 1]
+
+
+def machine_tag(run):
+    context = run["context"]
+    cpu = re.sub(r"\((r|tm)\)", "", context["cpu"].lower())
+    cpu = re.sub(r"[^a-z0-9]+", "-", cpu).strip("-")
+    return "%s-%s" % (cpu, context["isa"])
+
+
+def mean_var(samples):
+    n = len(samples)
+    m = sum(samples) / n
+    v = sum((x - m) ** 2 for x in samples) / (n - 1) if n > 1 else 0.0
+    return n, m, v
+
+
+def compare(base, new):
+    """Relative change of the mean and its confidence interval."""
+    n1, m1, v1 = mean_var(base)
+    n2, m2, v2 = mean_var(new)
+    se2 = v1 / n1 + v2 / n2
+    if se2 > 0 and n1 > 1 and n2 > 1:
+        # Welch-Satterthwaite degrees of freedom.
+        df = se2 ** 2 / ((v1 / n1) ** 2 / (n1 - 1) + (v2 / n2) ** 2 / (n2 - 1))
+        half = t95(df) * math.sqrt(se2)
+    else:
+        half = float("inf") if n1 < 2 or n2 < 2 else 0.0
+    delta = m2 - m1
+    return delta / m1, (delta - half) / m1, (delta + half) / m1
+
+
+def load(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__.splitlines()[0],
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="\n".join(__doc__.splitlines()[2:]))
+    parser.add_argument("runs", nargs="+", metavar="run.json",
+                        help="baseline and new run, or the new run only")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="allowed slowdown in percent (default 5)")
+    parser.add_argument("--metric", default="ns_per_op",
+                        choices=["ns_per_op", "cycles_per_op"])
+    parser.add_argument("--gate", default=GATE,
+                        help="regex of the gated benchmark ids")
+    parser.add_argument("--baselines", default=BASELINES,
+                        help="directory of the machine baselines")
+    parser.add_argument("--update", action="store_true",
+                        help="store the run as the baseline of its machine")
+    args = parser.parse_args()
+
+    if len(args.runs) > 2 or (args.update and len(args.runs) != 1):
+        parser.print_usage(sys.stderr)
+        return 2
+
+    new_path = args.runs[-1]
+    new = load(new_path)
+    tag = machine_tag(new)
+
+    if args.update:
+        os.makedirs(args.baselines, exist_ok=True)
+        path = os.path.join(args.baselines, tag + ".json")
+        shutil.copyfile(new_path, path)
+        print("stored %s" % path)
+        return 0
+
+    if len(args.runs) == 2:
+        base_path = args.runs[0]
+    else:
+        base_path = os.path.join(args.baselines, tag + ".json")
+        if not os.path.exists(base_path):
+            print("no baseline for %s, store one with --update" % tag,
+                  file=sys.stderr)
+            return 2
+    base = load(base_path)
+
+    print("baseline %s (%s)" % (base_path, machine_tag(base)))
+    print("new      %s (%s)" % (new_path, tag))
+    if machine_tag(base) != tag:
+        print("warning: the runs are from different machines")
+
+    gate = re.compile(args.gate)
+    base_results = dict((b["id"], b) for b in base["benchmarks"])
+    regressions = []
+    print("%-32s %12s %12s %9s  %-19s" %
+          ("benchmark", "baseline", "new", "change", "95% interval"))
+    for b in new["benchmarks"]:
+        old = base_results.get(b["id"])
+        if old is None:
+            continue
+        rel, lo, hi = compare(old[args.metric]["samples"],
+                              b[args.metric]["samples"])
+        gated = gate.search(b["id"]) is not None
+        regressed = gated and lo * 100 > args.threshold
+        if regressed:
+            regressions.append(b["id"])
+        print("%-32s %12.1f %12.1f %+8.1f%%  [%+7.1f%%, %+7.1f%%] %s" %
+              (b["id"], old[args.metric]["mean"], b[args.metric]["mean"],
+               100 * rel, 100 * lo, 100 * hi,
+               "REGRESSION" if regressed else ("gated" if gated else "")))
+
+    if regressions:
+        print("%d regression(s) above %.1f%%: %s" %
+              (len(regressions), args.threshold, ", ".join(regressions)))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
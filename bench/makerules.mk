@@ -0,0 +1,14 @@
+# -*- mode:make; tab-width:2; -*-
+
+include $(HEADER)
+
+# Build with "make BENCH=1", without the address sanitizer, for timings that
+# mean anything.
+TARGETS := vincenty.bench
+
+_LDFLAGS := -Wl,-rpath=$(TGTDIR)
+_LINK := vincenty
+
+vincenty.bench_SRCS := vincenty_bench.cpp perf_counters.cpp
+
+include $(FOOTER)
@@ -0,0 +1,197 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "perf_counters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <cpuid.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const names[perf_counters::num_events] = {
+  "cycles",
+  "instructions",
+  "branch_misses",
+  "l1d_misses",
+  "llc_misses",
+  "fp_assists"
+};
+
+// The floating point assist event of Intel CPUs, ASSISTS.FP since Ice Lake
+// and FP_ASSIST.ANY before. Zero if unknown.
+uint64_t
+default_fp_assist_config() {
+  unsigned int eax, ebx, ecx, edx;
+  if ( !__get_cpuid( 0, &eax, &ebx, &ecx, &edx ) ||
+       ebx != 0x756e6547 || edx != 0x49656e69 || ecx != 0x6c65746e ) {
+    return 0;
+  }
+  __get_cpuid( 1, &eax, &ebx, &ecx, &edx );
+  const unsigned int family = ( eax >> 8 ) & 0xf;
+  const unsigned int model  = ( ( eax >> 4 ) & 0xf ) | ( ( eax >> 12 ) & 0xf0 );
+  if ( family != 6 ) {
+    return 0;
+  }
+  return model >= 0x6a ? 0x02c1 : 0x1eca;
+}
+
+int
+open_event( const uint32_t type, const uint64_t config ) {
+  perf_event_attr attr;
+  std::memset( &attr, 0, sizeof(attr) );
+  attr.size           = sizeof(attr);
+  attr.type           = type;
+  attr.config         = config;
+  attr.disabled       = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  attr.read_format    =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 );
+}
+
+} // namespace end
+
+
+perf_counters::perf_counters( const uint64_t fp_assist_config )
+    : _error()
+{
+  const uint64_t cache_read_miss =
+      ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) |
+      ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 );
+  const uint64_t fp_assist =
+      fp_assist_config ? fp_assist_config : default_fp_assist_config();
+
+  for ( int e=0; e<num_events; ++e ) {
+    _value[e] = 0;
+    switch ( e ) {
+      case cycles:
+        _fd[e] = open_event( PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES );
+        break;
+      case instructions:
+        _fd[e] = open_event( PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS );
+        break;
+      case branch_misses:
+        _fd[e] = open_event( PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES );
+        break;
+      case l1d_misses:
+        _fd[e] = open_event( PERF_TYPE_HW_CACHE,
+                             PERF_COUNT_HW_CACHE_L1D | cache_read_miss );
+        break;
+      case llc_misses:
+        _fd[e] = open_event( PERF_TYPE_HW_CACHE,
+                             PERF_COUNT_HW_CACHE_LL | cache_read_miss );
+        break;
+      case fp_assists:
+        _fd[e] = fp_assist ? open_event( PERF_TYPE_RAW, fp_assist ) : -1;
+        if ( !fp_assist ) {
+          errno = ENOENT;
+        }
+        break;
+    }
+    if ( _fd[e] < 0 ) {
+      _error += std::string( _error.empty() ? "" : ", " ) +
+          names[e] + ": " + std::strerror(errno);
+    }
+  }
+}
+
+perf_counters::~perf_counters()
+{
+  for ( int e=0; e<num_events; ++e ) {
+    if ( _fd[e] >= 0 ) {
+      close( _fd[e] );
+    }
+  }
+}
+
+void
+perf_counters::start()
+{
+  for ( int e=0; e<num_events; ++e ) {
+    if ( _fd[e] >= 0 ) {
+      ioctl( _fd[e], PERF_EVENT_IOC_RESET, 0 );
+      ioctl( _fd[e], PERF_EVENT_IOC_ENABLE, 0 );
+    }
+  }
+}
+
+void
+perf_counters::stop()
+{
+  for ( int e=0; e<num_events; ++e ) {
+    if ( _fd[e] >= 0 ) {
+      ioctl( _fd[e], PERF_EVENT_IOC_DISABLE, 0 );
+    }
+  }
+  // Value, time enabled and time running. The counters share the hardware
+  // with other users and run part of the time only if there are too many,
+  // the value is then scaled up to the whole time.
+  for ( int e=0; e<num_events; ++e ) {
+    uint64_t data[3] = { 0, 0, 0 };
+    _value[e] = 0;
+    if ( _fd[e] >= 0 &&
+         read( _fd[e], data, sizeof(data) ) == sizeof(data) &&
+         data[2] > 0 ) {
+      _value[e] = double(data[0]) * data[1] / data[2];
+    }
+  }
+}
+
+bool
+perf_counters::available( const event e ) const
+{
+  return _fd[e] >= 0;
+}
+
+bool
+perf_counters::any_available() const
+{
+  for ( int e=0; e<num_events; ++e ) {
+    if ( _fd[e] >= 0 ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+double
+perf_counters::value( const event e ) const
+{
+  return _value[e];
+}
+
+const char*
+perf_counters::name( const event e )
+{
+  return names[e];
+}
+
+const std::string&
+perf_counters::error() const
+{
+  return _error;
+}
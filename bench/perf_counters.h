@@ -0,0 +1,88 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+/*
+  Hardware performance counters of the benchmarks, read with
+  perf_event_open(2). Every event is opened on its own, the events the
+  kernel, the hypervisor or the permissions do not allow are left out and
+  the others are still counted.
+*/
+
+#ifndef __perf_counters_h__
+#define __perf_counters_h__
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+class perf_counters
+{
+ public:
+  enum event {
+    cycles        = 0,
+    instructions  = 1,
+    branch_misses = 2,
+    l1d_misses    = 3,
+    llc_misses    = 4,
+    fp_assists    = 5,
+    num_events    = 6
+  };
+
+  /*!
+   * @brief Opens the counters of the calling thread.
+   *
+   * @param fp_assist_config Raw event config of the floating point assists,
+   * zero for the default of the CPU model. The event is model specific.
+   */
+  explicit perf_counters( const uint64_t fp_assist_config = 0 );
+  ~perf_counters();
+
+  //! Reset and start all open counters.
+  void start();
+
+  //! Stop all open counters, the values are then read with value().
+  void stop();
+
+  //! True if the event could be opened.
+  bool available( const event e ) const;
+
+  //! True if any event could be opened.
+  bool any_available() const;
+
+  //! Count of the last start() to stop(), scaled if it was multiplexed.
+  double value( const event e ) const;
+
+  //! Name used in the output, e.g. "branch_misses".
+  static const char* name( const event e );
+
+  //! Why the events which are not available could not be opened.
+  const std::string& error() const;
+
+ private:
+  perf_counters( const perf_counters& );
+  perf_counters& operator=( const perf_counters& );
+
+  int _fd[num_events];
+  double _value[num_events];
+  std::string _error;
+};
+
+#endif
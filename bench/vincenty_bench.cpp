@@ -0,0 +1,902 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+/*
+  Benchmark suite. Every benchmark runs on fixed seed datasets and reports
+  the time and the time stamp counter cycles per operation, the iteration
+  histograms of the datasets are reported as well. The hardware counters in
+  perf_counters.h are read around every repetition, those available are
+  reported per operation next to the time. With --json the results are also
+  written as JSON, for comparison between runs.
+
+  Usage: vincenty.bench [--json file] [--repetitions n] [--size n]
+                        [--filter substring] [--all-isa] [--no-counters]
+                        [--fp-assist-event config]
+
+  Build the library without the address sanitizer, make BENCH=1, or the
+  numbers are meaningless.
+*/
+
+#include "vincenty/vincenty.h"
+#include "vincenty/approximate.h"
+#include "vincenty/coordinate_grid.h"
+#include "vincenty/distance_matrix.h"
+#include "vincenty/geodesic_index.h"
+#include "vincenty/geodesic_line.h"
+#include "vincenty/parallel.h"
+
+// The polynomial kernels are internal to the library and only available as
+// inlined templates, at the baseline vector width.
+#include "../src/vincenty_math.h"
+
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <time.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+using namespace vincenty;
+
+namespace {
+
+// Datasets
+// ------------------------------------------------------------------------
+
+//! Pairs of positions and the directions between them.
+struct dataset
+{
+  std::string name;
+  std::vector<double> lat1, lon1, lat2, lon2;
+  std::vector<double> bearing1, distance, bearing2;
+  std::vector<vposition> pos1, pos2;
+};
+
+double
+uniform( const double lo, const double hi ) {
+  return lo + ( hi - lo ) * drand48();
+}
+
+// Uniform on the sphere between the two latitudes.
+double
+random_latitude( const double lo, const double hi ) {
+  return std::asin( uniform( std::sin(lo), std::sin(hi) ) );
+}
+
+void
+add_pair( dataset& d,
+          const double lat1, const double lon1,
+          const double lat2, const double lon2 ) {
+  d.lat1.push_back(lat1);
+  d.lon1.push_back(lon1);
+  d.lat2.push_back(lat2);
+  d.lon2.push_back(lon2);
+}
+
+// The second position at a log-uniform distance in a random direction.
+void
+add_ranged( dataset& d, const double min_distance, const double max_distance ) {
+  const double lat = random_latitude( to_rad(-70), to_rad(70) );
+  const double lon = uniform( -M_PI, M_PI );
+  const double s   =
+      min_distance * std::exp( drand48() * std::log(max_distance/min_distance) );
+  const vposition p = direct( lat, lon, uniform( 0, 2*M_PI ), s );
+  add_pair( d, lat, lon, p.coords.a[0], p.coords.a[1] );
+}
+
+// Generates n pairs, the seed is fixed per dataset.
+dataset
+generate( const std::string& name, const size_t n, const long seed ) {
+  dataset d;
+  d.name = name;
+  srand48(seed);
+  for ( size_t i=0; i<n; ++i ) {
+    if ( name == "short" ) {
+      add_ranged( d, 1.0, 1e4 );
+    } else if ( name == "continental" ) {
+      add_ranged( d, 1e5, 5e6 );
+    } else if ( name == "antipodal" ) {
+      // Within half a degree of the antipode.
+      const double lat = random_latitude( -M_PI/2, M_PI/2 );
+      const double lon = uniform( -M_PI, M_PI );
+      add_pair( d, lat, lon,
+                -lat + to_rad( uniform( -0.5, 0.5 ) ),
+                lon + M_PI + to_rad( uniform( -0.5, 0.5 ) ) );
+    } else {
+      // Both positions poleward of 80 degrees, in the same hemisphere.
+      const double sign = drand48() < 0.5 ? -1 : 1;
+      add_pair( d,
+                sign * random_latitude( to_rad(80), M_PI/2 ),
+                uniform( -M_PI, M_PI ),
+                sign * random_latitude( to_rad(80), M_PI/2 ),
+                uniform( -M_PI, M_PI ) );
+    }
+    d.pos1.push_back( vposition( d.lat1[i], d.lon1[i] ) );
+    d.pos2.push_back( vposition( d.lat2[i], d.lon2[i] ) );
+  }
+  d.bearing1.resize(n);
+  d.distance.resize(n);
+  d.bearing2.resize(n);
+  inverse_batch( &d.lat1[0], &d.lon1[0], &d.lat2[0], &d.lon2[0],
+                 &d.bearing1[0], &d.distance[0], &d.bearing2[0], n );
+  return d;
+}
+
+
+// Benchmarks
+// ------------------------------------------------------------------------
+
+// Output buffers of the batches.
+std::vector<double> out1, out2, out3;
+
+// Every benchmark returns the number of operations done. The results are
+// added to sink to keep the calls from being removed.
+typedef size_t (*benchmark_fn)( const dataset& d, double& sink );
+
+size_t
+bench_inverse( const dataset& d, double& sink ) {
+  const size_t n = d.lat1.size();
+  for ( size_t i=0; i<n; ++i ) {
+    sink += inverse( d.lat1[i], d.lon1[i], d.lat2[i], d.lon2[i] ).distance;
+  }
+  return n;
+}
+
+size_t
+bench_inverse_batch( const dataset& d, double& sink ) {
+  const size_t n = d.lat1.size();
+  inverse_batch( &d.lat1[0], &d.lon1[0], &d.lat2[0], &d.lon2[0],
+                 &out1[0], &out2[0], &out3[0], n );
+  sink += out2[n/2];
+  return n;
+}
+
+// On one thread per online CPU.
+size_t
+bench_parallel_inverse( const dataset& d, double& sink ) {
+  const size_t n = d.lat1.size();
+  parallel::inverse( &d.lat1[0], &d.lon1[0], &d.lat2[0], &d.lon2[0],
+                     &out1[0], &out2[0], &out3[0], n );
+  sink += out2[n/2];
+  return n;
+}
+
+// The first 16 origins to every target, so that the matrix has as many
+// elements as the dataset has pairs. The pairs are not those of the dataset,
+// only the targets are. The sites are prepared by every call.
+size_t
+bench_distance_matrix( const dataset& d, double& sink ) {
+  static std::vector<double> matrix;
+  const size_t rows = std::min( d.lat1.size(), size_t(16) );
+  const size_t n    = d.lat2.size();
+  matrix.resize( rows * n );
+  distance_matrix( prepared_sites( &d.lat1[0], &d.lon1[0], rows ),
+                   prepared_sites( &d.lat2[0], &d.lon2[0], n ),
+                   &matrix[0] );
+  sink += matrix[matrix.size()/2];
+  return rows * n;
+}
+
+// The 10 targets nearest to each of the first 1000 origins. The index over
+// the targets is built once per dataset, outside of the timings.
+size_t
+bench_nearest( const dataset& d, double& sink ) {
+  static const dataset* indexed = 0;
+  static geodesic_index index;
+  if ( indexed != &d ) {
+    index   = geodesic_index( d.pos2 );
+    indexed = &d;
+  }
+  const size_t n = std::min( d.pos1.size(), size_t(1000) );
+  for ( size_t i=0; i<n; ++i ) {
+    sink += index.nearest( d.pos1[i], 10 ).back().distance;
+  }
+  return n;
+}
+
+size_t
+bench_direct( const dataset& d, double& sink ) {
+  const size_t n = d.lat1.size();
+  for ( size_t i=0; i<n; ++i ) {
+    sink += direct( d.lat1[i], d.lon1[i], d.bearing1[i], d.distance[i] )
+        .coords.a[0];
+  }
+  return n;
+}
+
+size_t
+bench_direct_batch( const dataset& d, double& sink ) {
+  const size_t n = d.lat1.size();
+  direct_batch( &d.lat1[0], &d.lon1[0], &d.bearing1[0], &d.distance[0],
+                &out1[0], &out2[0], n );
+  sink += out1[n/2];
+  return n;
+}
+
+size_t
+bench_get_distance( const dataset& d, double& sink ) {
+  const size_t n = d.lat1.size();
+  for ( size_t i=0; i<n; ++i ) {
+    sink += get_distance( d.lat1[i], d.lon1[i], d.lat2[i], d.lon2[i] );
+  }
+  return n;
+}
+
+size_t
+bench_midpoint( const dataset& d, double& sink ) {
+  const size_t n = d.pos1.size();
+  for ( size_t i=0; i<n; ++i ) {
+    sink += ( d.pos1[i] ^ d.pos2[i] ).coords.a[0];
+  }
+  return n;
+}
+
+// The error bound tiers of approximate_distance(), the same pairs for all.
+template <approximation M> size_t
+bench_approximate( const dataset& d, double& sink ) {
+  const size_t n = d.lat1.size();
+  for ( size_t i=0; i<n; ++i ) {
+    sink += approximate_distance( M, d.lat1[i], d.lon1[i],
+                                  d.lat2[i], d.lon2[i] );
+  }
+  return n;
+}
+
+// The line benchmarks do not use the pairs, they run on the "line" dataset
+// only. Positions every 100 m along one line, through direct() for each
+// distance and through the geodesic_line one at a time and as a batch.
+const vposition line_origin( to_rad(58.4), to_rad(15.6) );
+const double line_bearing = to_rad(73.0);
+const size_t line_size    = 1 << 16;
+
+const std::vector<double>&
+line_distances() {
+  static std::vector<double> distances;
+  if ( distances.empty() ) {
+    for ( size_t i=0; i<line_size; ++i ) {
+      distances.push_back( 100.0*i );
+    }
+  }
+  return distances;
+}
+
+size_t
+bench_line_direct( const dataset&, double& sink ) {
+  const std::vector<double>& distances = line_distances();
+  for ( size_t i=0; i<line_size; ++i ) {
+    sink += direct( line_origin, line_bearing, distances[i] ).coords.a[0];
+  }
+  return line_size;
+}
+
+size_t
+bench_line_position( const dataset&, double& sink ) {
+  const std::vector<double>& distances = line_distances();
+  const geodesic_line line( line_origin, line_bearing );
+  for ( size_t i=0; i<line_size; ++i ) {
+    sink += line.position( distances[i] ).coords.a[0];
+  }
+  return line_size;
+}
+
+size_t
+bench_line_positions( const dataset&, double& sink ) {
+  static std::vector<double> lat(line_size), lon(line_size);
+  const geodesic_line line( line_origin, line_bearing );
+  line.positions( &line_distances()[0], &lat[0], &lon[0], line_size );
+  sink += lat[line_size/2];
+  return line_size;
+}
+
+// The math benchmarks do not use the pairs, they run on the "math" dataset
+// only. The x87 instructions used before the polynomial kernels and the C
+// library are kept as a reference.
+inline void
+x87_sincos( const double a, double* sina, double* cosa ) {
+  asm ("fsincos;" : "=t" (*cosa), "=u" (*sina) : "0" (a));
+}
+
+inline double
+x87_atan2( const double y, double x ) {
+  asm ("fpatan;" : "=t" (x) : "0" (x), "u" (y) : "st(1)");
+  return x;
+}
+
+// Angles in [-M_PI,M_PI) and values in [-1,1), fixed seed.
+struct math_arguments
+{
+  std::vector<double> x;
+  std::vector<double> y;
+
+  math_arguments() : x(), y() {
+    srand48(123456789);
+    for ( size_t i=0; i<(1<<18); ++i ) {
+      x.push_back( uniform( -M_PI, M_PI ) );
+      y.push_back( uniform( -1, 1 ) );
+    }
+  }
+};
+
+const math_arguments&
+math_data() {
+  static const math_arguments data;
+  return data;
+}
+
+size_t
+bench_sincos_x87( const dataset&, double& sink ) {
+  const std::vector<double>& x = math_data().x;
+  for ( size_t i=0; i<x.size(); ++i ) {
+    double s, c;
+    x87_sincos( x[i], &s, &c );
+    sink += s + c;
+  }
+  return x.size();
+}
+
+size_t
+bench_sincos_libm( const dataset&, double& sink ) {
+  const std::vector<double>& x = math_data().x;
+  for ( size_t i=0; i<x.size(); ++i ) {
+    double s, c;
+    ::sincos( x[i], &s, &c );
+    sink += s + c;
+  }
+  return x.size();
+}
+
+size_t
+bench_sincos_poly( const dataset&, double& sink ) {
+  const std::vector<double>& x = math_data().x;
+  for ( size_t i=0; i<x.size(); ++i ) {
+    double s, c;
+    vmath::sincos( x[i], &s, &c );
+    sink += s + c;
+  }
+  return x.size();
+}
+
+size_t
+bench_sincos_vector( const dataset&, double& sink ) {
+  const std::vector<double>& x = math_data().x;
+  vdf sum = simd::set1(0.0);
+  for ( size_t i=0; i+VINCENTY_LANES<=x.size(); i+=VINCENTY_LANES ) {
+    vdf s, c;
+    vmath::sincos( simd::load( &x[i], VINCENTY_LANES ), &s, &c );
+    sum += s + c;
+  }
+  sink += sum[0];
+  return x.size();
+}
+
+size_t
+bench_atan2_x87( const dataset&, double& sink ) {
+  const std::vector<double>& x = math_data().x;
+  const std::vector<double>& y = math_data().y;
+  for ( size_t i=0; i<x.size(); ++i ) {
+    sink += x87_atan2( y[i], x[i] );
+  }
+  return x.size();
+}
+
+size_t
+bench_atan2_libm( const dataset&, double& sink ) {
+  const std::vector<double>& x = math_data().x;
+  const std::vector<double>& y = math_data().y;
+  for ( size_t i=0; i<x.size(); ++i ) {
+    sink += ::atan2( y[i], x[i] );
+  }
+  return x.size();
+}
+
+size_t
+bench_atan2_poly( const dataset&, double& sink ) {
+  const std::vector<double>& x = math_data().x;
+  const std::vector<double>& y = math_data().y;
+  for ( size_t i=0; i<x.size(); ++i ) {
+    sink += vmath::atan2( y[i], x[i] );
+  }
+  return x.size();
+}
+
+size_t
+bench_atan2_vector( const dataset&, double& sink ) {
+  const std::vector<double>& x = math_data().x;
+  const std::vector<double>& y = math_data().y;
+  vdf sum = simd::set1(0.0);
+  for ( size_t i=0; i+VINCENTY_LANES<=x.size(); i+=VINCENTY_LANES ) {
+    sum += vmath::atan2( simd::load( &y[i], VINCENTY_LANES ),
+                         simd::load( &x[i], VINCENTY_LANES ) );
+  }
+  sink += sum[0];
+  return x.size();
+}
+
+// The grid benchmarks do not use the pairs, they run on the "grid" dataset
+// only. A split of a 3x3 grid six times computes 129*129-9 positions.
+const vposition grid_sw( to_rad(55.0), to_rad(16.0) );
+const vposition grid_ne( to_rad(59.5), to_rad(16.5) );
+
+size_t
+bench_grid_split( const dataset&, double& sink ) {
+  coordinate::CoordinateGrid cg( grid_sw, grid_ne );
+  cg.split(6);
+  sink += cg.getCenter().coords.a[0];
+  const size_t size = cg.getGridSize();
+  return size*size - 9;
+}
+
+size_t
+bench_grid_lookup( const dataset&, double& sink ) {
+  static coordinate::CoordinateGrid cg =
+      coordinate::CoordinateGrid( grid_sw, grid_ne ).split(4);
+  const unsigned int size = 256;
+  cg.setVirtualGridSize(size);
+  for ( unsigned int i=0; i<size; ++i ) {
+    for ( unsigned int j=0; j<size; ++j ) {
+      sink += cg(i,j).coords.a[0];
+    }
+  }
+  return size*size;
+}
+
+struct benchmark
+{
+  const char* name;
+  benchmark_fn run;
+  //! The dataset of its own the benchmark runs on, 0 for every pair dataset.
+  const char* own;
+};
+
+const benchmark benchmarks[] = {
+  { "inverse",          &bench_inverse,          0      },
+  { "inverse_batch",    &bench_inverse_batch,    0      },
+  { "parallel_inverse", &bench_parallel_inverse, 0      },
+  { "distance_matrix",  &bench_distance_matrix,  0      },
+  { "nearest",          &bench_nearest,          0      },
+  { "direct",           &bench_direct,           0      },
+  { "direct_batch",     &bench_direct_batch,     0      },
+  { "get_distance",     &bench_get_distance,     0      },
+  { "midpoint",         &bench_midpoint,         0      },
+  { "tangent_plane",    &bench_approximate<approx_tangent_plane>,   0 },
+  { "haversine",        &bench_approximate<approx_haversine>,       0 },
+  { "andoyer_lambert",  &bench_approximate<approx_andoyer_lambert>, 0 },
+  { "approx_vincenty",  &bench_approximate<approx_vincenty>,        0 },
+  { "line_direct",      &bench_line_direct,      "line" },
+  { "line_position",    &bench_line_position,    "line" },
+  { "line_positions",   &bench_line_positions,   "line" },
+  { "sincos_x87",       &bench_sincos_x87,       "math" },
+  { "sincos_libm",      &bench_sincos_libm,      "math" },
+  { "sincos_poly",      &bench_sincos_poly,      "math" },
+  { "sincos_vector",    &bench_sincos_vector,    "math" },
+  { "atan2_x87",        &bench_atan2_x87,        "math" },
+  { "atan2_libm",       &bench_atan2_libm,       "math" },
+  { "atan2_poly",       &bench_atan2_poly,       "math" },
+  { "atan2_vector",     &bench_atan2_vector,     "math" },
+  { "grid_split",       &bench_grid_split,       "grid" },
+  { "grid_lookup",      &bench_grid_lookup,      "grid" }
+};
+
+const char* const dataset_names[] = {
+  "short", "continental", "antipodal", "polar"
+};
+
+
+// Measurement
+// ------------------------------------------------------------------------
+
+//! Samples of one quantity, one per repetition.
+struct samples
+{
+  std::vector<double> values;
+
+  double median() const {
+    std::vector<double> v(values);
+    std::sort( v.begin(), v.end() );
+    const size_t n = v.size();
+    return n % 2 ? v[n/2] : ( v[n/2-1] + v[n/2] ) / 2;
+  }
+
+  double mean() const {
+    double sum = 0;
+    for ( size_t i=0; i<values.size(); ++i ) {
+      sum += values[i];
+    }
+    return sum / values.size();
+  }
+
+  double stddev() const {
+    if ( values.size() < 2 ) {
+      return 0;
+    }
+    const double m = mean();
+    double sum = 0;
+    for ( size_t i=0; i<values.size(); ++i ) {
+      sum += ( values[i] - m ) * ( values[i] - m );
+    }
+    return std::sqrt( sum / ( values.size() - 1 ) );
+  }
+
+  double min() const {
+    return *std::min_element( values.begin(), values.end() );
+  }
+};
+
+struct result
+{
+  std::string name;
+  std::string dataset;
+  std::string isa;
+  size_t ops;
+  samples ns;
+  samples cycles;
+  //! Hardware counters per operation, empty if not available.
+  samples counters[perf_counters::num_events];
+};
+
+double
+now_ns() {
+  timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// One untimed run to warm the caches, then the timed repetitions. The
+// counters, if not null, are read around the repetitions.
+result
+measure( const benchmark& b, const dataset& d, const unsigned int repetitions,
+         perf_counters* counters, double& sink ) {
+  result r;
+  r.name    = b.name;
+  r.dataset = d.name;
+  r.isa     = isa_name( get_isa() );
+  r.ops     = b.run( d, sink );
+  for ( unsigned int i=0; i<repetitions; ++i ) {
+    if ( counters ) {
+      counters->start();
+    }
+    const double t0 = now_ns();
+    const unsigned long long c0 = __rdtsc();
+    const size_t ops = b.run( d, sink );
+    const unsigned long long c1 = __rdtsc();
+    const double t1 = now_ns();
+    if ( counters ) {
+      counters->stop();
+      for ( int e=0; e<perf_counters::num_events; ++e ) {
+        const perf_counters::event ev = perf_counters::event(e);
+        if ( counters->available(ev) ) {
+          r.counters[e].values.push_back( counters->value(ev) / ops );
+        }
+      }
+    }
+    r.ns.values.push_back( ( t1 - t0 ) / ops );
+    r.cycles.values.push_back( double( c1 - c0 ) / ops );
+  }
+  return r;
+}
+
+struct histograms
+{
+  std::string dataset;
+  iteration_histogram inverse;
+  iteration_histogram direct;
+};
+
+histograms
+iterations( const dataset& d ) {
+  histograms h;
+  h.dataset = d.name;
+  const size_t n = d.lat1.size();
+  inverse_batch( &d.lat1[0], &d.lon1[0], &d.lat2[0], &d.lon2[0],
+                 &out1[0], &out2[0], &out3[0], n, default_accuracy,
+                 &h.inverse );
+  direct_batch( &d.lat1[0], &d.lon1[0], &d.bearing1[0], &d.distance[0],
+                &out1[0], &out2[0], n, default_accuracy, &h.direct );
+  return h;
+}
+
+
+// Output
+// ------------------------------------------------------------------------
+
+std::string
+cpu_model() {
+  std::ifstream in("/proc/cpuinfo");
+  std::string line;
+  while ( std::getline( in, line ) ) {
+    if ( line.compare( 0, 10, "model name" ) == 0 ) {
+      const size_t colon = line.find(':');
+      if ( colon != std::string::npos && colon + 2 <= line.size() ) {
+        return line.substr( colon + 2 );
+      }
+    }
+  }
+  return "unknown";
+}
+
+std::string
+host_name() {
+  char name[256] = "";
+  gethostname( name, sizeof(name) - 1 );
+  return name;
+}
+
+std::string
+utc_date() {
+  char date[32] = "";
+  const time_t t = time(0);
+  strftime( date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&t) );
+  return date;
+}
+
+// Quoted JSON string, the names here need no escapes but the context might.
+std::string
+quote( const std::string& s ) {
+  std::string q = "\"";
+  for ( size_t i=0; i<s.size(); ++i ) {
+    if ( s[i] == '"' || s[i] == '\\' ) {
+      q += '\\';
+    }
+    q += s[i] < ' ' ? ' ' : s[i];
+  }
+  return q + "\"";
+}
+
+void
+write_samples( std::ostream& os, const samples& s ) {
+  os << "{\"median\": " << s.median()
+     << ", \"mean\": " << s.mean()
+     << ", \"stddev\": " << s.stddev()
+     << ", \"min\": " << s.min()
+     << ", \"samples\": [";
+  for ( size_t i=0; i<s.values.size(); ++i ) {
+    os << ( i ? ", " : "" ) << s.values[i];
+  }
+  os << "]}";
+}
+
+void
+write_histogram( std::ostream& os, const iteration_histogram& h ) {
+  os << "{\"converged\": [";
+  for ( size_t i=0; i<iteration_histogram::bins; ++i ) {
+    os << ( i ? ", " : "" ) << h.converged[i];
+  }
+  os << "], \"capped\": " << h.capped << ", \"mean\": " << h.mean() << "}";
+}
+
+void
+write_json( std::ostream& os,
+            const std::vector<result>& results,
+            const std::vector<histograms>& hists,
+            const size_t size,
+            const unsigned int repetitions,
+            const std::string& counters_error ) {
+  os.precision(6);
+  os << "{\n"
+     << "  \"context\": {\n"
+     << "    \"date\": " << quote( utc_date() ) << ",\n"
+     << "    \"host\": " << quote( host_name() ) << ",\n"
+     << "    \"cpu\": " << quote( cpu_model() ) << ",\n"
+     << "    \"compiler\": " << quote( __VERSION__ ) << ",\n"
+     << "    \"isa\": " << quote( isa_name( get_isa() ) ) << ",\n"
+     << "    \"size\": " << size << ",\n"
+     << "    \"repetitions\": " << repetitions << ",\n"
+     << "    \"counters_error\": " << quote( counters_error ) << "\n"
+     << "  },\n"
+     << "  \"benchmarks\": [";
+  for ( size_t i=0; i<results.size(); ++i ) {
+    const result& r = results[i];
+    os << ( i ? ",\n" : "\n" )
+       << "    {\"id\": " << quote( r.name + "/" + r.dataset + "/" + r.isa )
+       << ", \"name\": " << quote( r.name )
+       << ", \"dataset\": " << quote( r.dataset )
+       << ", \"isa\": " << quote( r.isa )
+       << ", \"ops\": " << r.ops << ",\n"
+       << "     \"ns_per_op\": ";
+    write_samples( os, r.ns );
+    os << ",\n     \"cycles_per_op\": ";
+    write_samples( os, r.cycles );
+    os << ",\n     \"counters\": {";
+    const char* separator = "";
+    for ( int e=0; e<perf_counters::num_events; ++e ) {
+      if ( !r.counters[e].values.empty() ) {
+        os << separator << "\n       "
+           << quote( perf_counters::name( perf_counters::event(e) ) ) << ": ";
+        write_samples( os, r.counters[e] );
+        separator = ",";
+      }
+    }
+    os << "}}";
+  }
+  os << "\n  ],\n"
+     << "  \"iterations\": [";
+  for ( size_t i=0; i<hists.size(); ++i ) {
+    os << ( i ? ",\n" : "\n" )
+       << "    {\"dataset\": " << quote( hists[i].dataset ) << ",\n"
+       << "     \"inverse\": ";
+    write_histogram( os, hists[i].inverse );
+    os << ",\n     \"direct\": ";
+    write_histogram( os, hists[i].direct );
+    os << "}";
+  }
+  os << "\n  ]\n"
+     << "}\n";
+}
+
+void
+print_result( const result& r ) {
+  std::cout << std::left
+            << std::setw(17) << r.name
+            << std::setw(12) << r.dataset
+            << std::setw(7)  << r.isa
+            << std::right << std::fixed << std::setprecision(1)
+            << std::setw(10) << r.ns.median() << " ns/op"
+            << std::setw(10) << r.cycles.median() << " cycles/op"
+            << "  +-" << std::setprecision(1)
+            << 100 * r.ns.stddev() / r.ns.mean() << "%" << std::endl;
+
+  // The counters per operation on a second line, and the instructions per
+  // cycle.
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(2);
+  for ( int e=0; e<perf_counters::num_events; ++e ) {
+    if ( !r.counters[e].values.empty() ) {
+      line << "  " << perf_counters::name( perf_counters::event(e) ) << " "
+           << r.counters[e].median();
+    }
+  }
+  const samples& cycles = r.counters[perf_counters::cycles];
+  const samples& instructions = r.counters[perf_counters::instructions];
+  if ( !cycles.values.empty() && !instructions.values.empty() ) {
+    line << "  ipc " << instructions.median() / cycles.median();
+  }
+  if ( !line.str().empty() ) {
+    std::cout << "  per op:" << line.str() << std::endl;
+  }
+}
+
+void
+print_histograms( const histograms& h ) {
+  std::cout << std::left << std::setw(12) << h.dataset << std::right
+            << std::fixed << std::setprecision(2)
+            << " inverse mean " << h.inverse.mean()
+            << " capped " << h.inverse.capped
+            << ", direct mean " << h.direct.mean()
+            << " capped " << h.direct.capped << std::endl;
+}
+
+void
+usage( const char* name ) {
+  std::cerr << "Usage: " << name << " [--json file] [--repetitions n]"
+            << " [--size n] [--filter substring] [--all-isa]"
+            << " [--no-counters] [--fp-assist-event config]" << std::endl;
+}
+
+} // namespace end
+
+
+int
+main( int argc, char** argv )
+{
+  std::string json;
+  std::string filter;
+  unsigned int repetitions = 5;
+  size_t size = 1 << 16;
+  bool all_isa = false;
+  bool use_counters = true;
+  uint64_t fp_assist_config = 0;
+
+  for ( int i=1; i<argc; ++i ) {
+    const std::string arg = argv[i];
+    if ( arg == "--json" && i+1 < argc ) {
+      json = argv[++i];
+    } else if ( arg == "--filter" && i+1 < argc ) {
+      filter = argv[++i];
+    } else if ( arg == "--repetitions" && i+1 < argc ) {
+      repetitions = std::max( 1, atoi( argv[++i] ) );
+    } else if ( arg == "--size" && i+1 < argc ) {
+      size = std::max( 16L, atol( argv[++i] ) );
+    } else if ( arg == "--all-isa" ) {
+      all_isa = true;
+    } else if ( arg == "--no-counters" ) {
+      use_counters = false;
+    } else if ( arg == "--fp-assist-event" && i+1 < argc ) {
+      fp_assist_config = strtoull( argv[++i], 0, 0 );
+    } else {
+      usage( argv[0] );
+      return 2;
+    }
+  }
+
+  std::vector<dataset> datasets;
+  std::vector<histograms> hists;
+  out1.resize(size);
+  out2.resize(size);
+  out3.resize(size);
+  for ( size_t i=0; i<sizeof(dataset_names)/sizeof(dataset_names[0]); ++i ) {
+    // Nearly all antipodal pairs take the slow fallback, fewer of them keeps
+    // the run time of the suite down.
+    const size_t n = std::strcmp( dataset_names[i], "antipodal" ) == 0 ?
+        size/64 : size;
+    datasets.push_back( generate( dataset_names[i], n, 123456789 + i ) );
+    hists.push_back( iterations( datasets.back() ) );
+    print_histograms( hists.back() );
+  }
+  // Named only, the benchmarks on them bring their own data.
+  dataset own;
+
+  const isa_level initial = get_isa();
+  const isa_level first   = all_isa ? isa_sse2 : initial;
+  const isa_level last    = all_isa ? get_best_isa() : initial;
+
+  // Without any counters the benchmarks run on with the times only.
+  perf_counters counters( fp_assist_config );
+  std::string counters_error = use_counters ? counters.error() : "disabled";
+  if ( use_counters && !counters.error().empty() ) {
+    std::cerr << "Counters not available: " << counters.error() << std::endl;
+  }
+  perf_counters* active =
+      use_counters && counters.any_available() ? &counters : 0;
+
+  std::vector<result> results;
+  double sink = 0;
+  for ( int level=first; level<=last; ++level ) {
+    set_isa( isa_level(level) );
+    for ( size_t b=0; b<sizeof(benchmarks)/sizeof(benchmarks[0]); ++b ) {
+      const benchmark& bench = benchmarks[b];
+      const size_t num_sets = bench.own ? 1 : datasets.size();
+      own.name = bench.own ? bench.own : "";
+      for ( size_t k=0; k<num_sets; ++k ) {
+        const dataset& d = bench.own ? own : datasets[k];
+        const std::string id = std::string(bench.name) + "/" + d.name;
+        if ( !filter.empty() && id.find(filter) == std::string::npos ) {
+          continue;
+        }
+        results.push_back( measure( bench, d, repetitions, active, sink ) );
+        print_result( results.back() );
+      }
+    }
+  }
+  set_isa(initial);
+
+  if ( !json.empty() ) {
+    std::ofstream os( json.c_str() );
+    write_json( os, results, hists, size, repetitions, counters_error );
+    if ( !os ) {
+      std::cerr << "Could not write " << json << std::endl;
+      return 1;
+    }
+  }
+
+  // Printed so that the sink is used.
+  std::cout << "checksum " << std::setprecision(6) << sink << std::endl;
+  return 0;
+}
@@ -0,0 +1,134 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#ifndef __approximate_h__
+#define __approximate_h__
+
+#include "vincenty.h"
+
+namespace vincenty {
+
+/*!
+ * @defgroup vincenty_approximations Approximate distances
+ * @brief Cheaper distance methods with known error bounds.
+ *
+ * @details Vincenty's inverse formula is accurate to fractions of a
+ * millimeter, which most queries do not need. The methods below are not
+ * iterative and computes only the distance, in order of increasing cost:
+ *
+ * - tangent plane, the positions projected on the plane tangent to the
+ *   ellipsoid at the mid latitude, with the meridional and prime vertical
+ *   radii of curvature there. Exact in the limit, the error grows with the
+ *   cube of the distance and with the latitude.
+ * - haversine, the great circle distance on a sphere with the mean radius of
+ *   the ellipsoid. The error is a fixed fraction of the distance, it depends
+ *   on the direction and is at most half a percent.
+ * - Andoyer-Lambert, the great circle between the reduced latitudes with a
+ *   first order correction in the flattening. The error is of second order
+ *   in the flattening, tens of meters at most.
+ *
+ * The error bounds, approximation_error(), are maxima measured against the
+ * full inverse formula over random pairs, given as a function of the
+ * distance and the highest latitude of the two positions. They are for
+ * WGS84, like the methods themselves.
+ */
+
+//!@{
+
+//! The distance methods, cheapest first.
+enum approximation {
+  approx_tangent_plane   = 0,
+  approx_haversine       = 1,
+  approx_andoyer_lambert = 2,
+  approx_vincenty        = 3
+};
+
+/*!
+ * @brief Distance between two positions with the given method.
+ *
+ * @param method The method, approx_vincenty is get_distance().
+ * @param lat1   First position latitude [radians].
+ * @param lon1   First position longitude [radians].
+ * @param lat2   Second position latitude [radians].
+ * @param lon2   Second position longitude [radians].
+ *
+ * @return Distance between the positions [m].
+ */
+double approximate_distance(
+    const approximation method,
+    const double lat1,
+    const double lon1,
+    const double lat2,
+    const double lon2 );
+
+/*!
+ * @brief Upper bound of the error of a method.
+ *
+ * @param method   The method.
+ * @param distance Distance between the positions [m].
+ * @param lat      Highest absolute latitude of the positions [radians].
+ *
+ * @return Maximum absolute error of the method [m].
+ */
+double approximation_error(
+    const approximation method,
+    const double distance,
+    const double lat ) __attribute__ ((pure));
+
+/*!
+ * @brief The cheapest method whose error bound is within tolerance.
+ *
+ * @param distance  Distance between the positions, an estimate is enough
+ *                  [m].
+ * @param lat       Highest absolute latitude of the positions [radians].
+ * @param tolerance Largest acceptable error [m].
+ */
+approximation select_approximation(
+    const double distance,
+    const double lat,
+    const double tolerance ) __attribute__ ((pure));
+
+/*!
+ * @brief Distance within the given tolerance, by the cheapest method.
+ *
+ * The distance is estimated with the haversine method, padded with its
+ * error bound, and the cheapest method meeting the tolerance at that
+ * distance and latitude is used. A tolerance below the Andoyer-Lambert bound
+ * uses the full inverse formula.
+ *
+ * The inverse() overloads already takes the iteration accuracy as their last
+ * argument, this is the same as get_distance() but with a tolerance.
+ *
+ * @param tolerance Largest acceptable error [m].
+ *
+ * @return Distance between the positions [m].
+ */
+double get_distance(
+    const double lat1,
+    const double lon1,
+    const double lat2,
+    const double lon2,
+    const double tolerance );
+
+//!@}
+
+} // namespace end
+
+#endif
@@ -0,0 +1,166 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#ifndef __cells_h__
+#define __cells_h__
+
+#include "vincenty.h"
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace vincenty {
+
+/*!
+ * @defgroup vincenty_cells Vincenty cells
+ *
+ * A hierarchy of cells for bucketing positions. At level L the latitudes
+ * and the longitudes are each cut in 2^L equal ranges, a cell is one range
+ * of each. The cell_id interleaves the bits of the two range numbers
+ * (Z-order) behind a leading bit which marks the level, so that
+ *
+ * @li the cell of level L-1 holding a cell is its id shifted right by two,
+ * @li the cells below a cell are numbered next to each other, sorted ids
+ *     keeps close positions close and a range of sorted ids is a compact
+ *     region, for sharding work by cell,
+ * @li ids of different levels never collide.
+ *
+ * Level 0 is the whole globe, level max_cell_level cells are a few
+ * centimeters.
+ */
+//!@{
+
+//! Identifier of a cell, see @ref vincenty_cells.
+typedef uint64_t cell_id;
+
+//! Deepest level of the cells.
+static const unsigned int max_cell_level = 30;
+
+//! The cell of the level holding the position.
+cell_id to_cell( const vposition& pos, const unsigned int level );
+
+//! The cells of the level holding n positions.
+void to_cells(
+    const double* lat,
+    const double* lon,
+    cell_id* cells,
+    const size_t n,
+    const unsigned int level );
+
+//! Level of a cell.
+unsigned int cell_level( const cell_id cell );
+
+//! The cell of a lower level holding the cell.
+cell_id cell_parent( const cell_id cell, const unsigned int level );
+
+//! The south-west and north-east corners of a cell.
+void cell_bounds( const cell_id cell, vposition* sw, vposition* ne );
+
+//! The center of a cell.
+vposition cell_center( const cell_id cell );
+
+//! The centers of n cells.
+void cell_centers(
+    const cell_id* cells,
+    double* lat,
+    double* lon,
+    const size_t n );
+
+/*!
+ * @brief The cells sharing an edge or a corner with the cell, sorted.
+ *
+ * Eight cells, the longitudes wraps around. There are no cells beyond the
+ * poles, those of the first and last rows have five.
+ */
+std::vector<cell_id> cell_neighbours( const cell_id cell );
+
+/*!
+ * @brief The cells of the same level which may hold positions at most
+ * distance from a position in the cell, sorted and including the cell [m].
+ *
+ * The rows are bounded by the shortest meridian arc for the distance and
+ * the columns of each row by the shortest parallel, so every geodesic of
+ * the distance ends in one of the cells. The cells are more towards the
+ * poles, where a cell is narrower.
+ */
+std::vector<cell_id> cells_within( const cell_id cell, const double distance );
+
+//! The deepest level at which the cells are at least distance tall [m].
+unsigned int cell_level_for( const double distance );
+
+/*!
+ * @brief Positions bucketed by the cell they are in.
+ *
+ * @details The buckets are the cells holding at least one position, sorted
+ * by cell_id. The positions are given by their index in the vector the
+ * buckets were built from, in increasing order within a bucket.
+ */
+class cell_buckets
+{
+ public:
+  cell_buckets();
+  cell_buckets( const vposition_vector& positions, const unsigned int level );
+  cell_buckets( const double* lat,
+                const double* lon,
+                const size_t n,
+                const unsigned int level );
+
+  //! Level of the cells.
+  unsigned int level() const { return _level; }
+
+  //! Number of buckets.
+  size_t size() const { return _cells.size(); }
+
+  //! The cell of bucket k.
+  cell_id cell( const size_t k ) const { return _cells[k]; }
+
+  //! Number of positions in bucket k.
+  size_t count( const size_t k ) const {
+    return _offsets[k+1] - _offsets[k];
+  }
+
+  //!@{
+  //! The indexes of the positions in bucket k.
+  const size_t* begin( const size_t k ) const {
+    return &_positions[0] + _offsets[k];
+  }
+  const size_t* end( const size_t k ) const {
+    return &_positions[0] + _offsets[k+1];
+  }
+  //!@}
+
+  //! The bucket of a cell, size() if the cell holds no position.
+  size_t find( const cell_id cell ) const;
+
+ private:
+  void _build( const std::vector<cell_id>& cells );
+
+  unsigned int _level;
+  std::vector<cell_id> _cells;
+  std::vector<size_t> _offsets;
+  std::vector<size_t> _positions;
+};
+
+//!@}
+
+} // namespace end
+
+#endif
@@ -0,0 +1,107 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#ifndef __distance_join_h__
+#define __distance_join_h__
+
+#include "vincenty.h"
+
+#include <utility>
+#include <vector>
+
+namespace vincenty {
+
+/*!
+ * @defgroup vincenty_distance_join Vincenty distance join
+ *
+ * All pairs of positions, one from each of two sets, at most a distance
+ * apart. The pairs are exactly those for which
+ * inverse(pos1,pos2,accuracy).distance <= radius, as by trying every pair,
+ * without trying every pair:
+ *
+ * @li The second set is bucketed by cells at least radius tall, see
+ *     @ref vincenty_cells, and its Earth-centered Earth-fixed coordinates
+ *     are computed once.
+ * @li The first set is streamed in blocks of a few thousand positions,
+ *     shared by the workers of vincenty::parallel. A block is sorted by
+ *     cell and each of its cells is only compared to the buckets of
+ *     cells_within() the radius.
+ * @li The positions of those buckets are sorted out by the chord bounds of
+ *     @ref vincenty_ecef, the inverse formula only runs for those the
+ *     bounds do not decide.
+ *
+ * The memory used is that of the buckets of the second set and a block per
+ * worker, the first set may be any size. Give the larger set first.
+ */
+//!@{
+
+//! A pair of the join, the index in the first set and in the second.
+typedef std::pair<size_t,size_t> join_match;
+
+/*!
+ * @brief Receives the pairs of a join as they are found.
+ *
+ * Called from the worker threads, one call at a time, with the pairs of a
+ * block in no particular order.
+ */
+typedef void (*join_callback)( void* context,
+                               const join_match* matches,
+                               size_t n );
+
+/*!
+ * @brief The pairs of positions at most radius apart, streamed [m].
+ *
+ * @param lat1     Latitudes of the first set [rad].
+ * @param lon1     Longitudes of the first set [rad].
+ * @param n1       Number of positions in the first set.
+ * @param lat2     Latitudes of the second set [rad].
+ * @param lon2     Longitudes of the second set [rad].
+ * @param n2       Number of positions in the second set.
+ * @param radius   Largest distance of a pair [m].
+ * @param callback Called with the pairs found.
+ * @param context  Passed on to callback.
+ * @return The number of pairs.
+ */
+size_t distance_join(
+    const double* lat1,
+    const double* lon1,
+    const size_t n1,
+    const double* lat2,
+    const double* lon2,
+    const size_t n2,
+    const double radius,
+    join_callback callback,
+    void* context,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+//! The pairs of positions at most radius apart, sorted [m].
+std::vector<join_match> distance_join(
+    const vposition_vector& set1,
+    const vposition_vector& set2,
+    const double radius,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+//!@}
+
+} // namespace end
+
+#endif
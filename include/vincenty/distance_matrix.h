@@ -0,0 +1,204 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#ifndef __distance_matrix_h__
+#define __distance_matrix_h__
+
+#include "vincenty.h"
+
+#include <string>
+#include <vector>
+
+namespace vincenty {
+
+/*!
+ * @brief A set of sites prepared once for distance_matrix().
+ *
+ * The reduced latitude terms of every site are computed by the constructor,
+ * as for prepared_position, and kept in separate arrays per term so that the
+ * matrix kernels loads a vector of sites at a time.
+ */
+class prepared_sites
+{
+ public:
+  prepared_sites();
+  explicit prepared_sites( const vposition_vector& sites );
+  prepared_sites( const vposition* sites, const size_t n );
+  prepared_sites( const double* lat, const double* lon, const size_t n );
+
+  //! Number of sites.
+  size_t size() const { return _lat.size(); }
+
+  //!@{
+  //! The terms of the sites, size() elements each, null if empty.
+  const double* lat()   const { return _data(_lat); }
+  const double* lon()   const { return _data(_lon); }
+  const double* sin_U() const { return _data(_sin_U); }
+  const double* cos_U() const { return _data(_cos_U); }
+  //!@}
+
+ private:
+  void _prepare();
+
+  static const double* _data( const std::vector<double>& v ) {
+    return v.empty() ? 0 : &v[0];
+  }
+
+  std::vector<double> _lat;
+  std::vector<double> _lon;
+  std::vector<double> _sin_U;
+  std::vector<double> _cos_U;
+};
+
+/*!
+ * @defgroup vincenty_distance_matrix Vincenty distance matrix
+ *
+ * Distances from every site of one set to every site of another, for route
+ * optimization and clustering of thousands of sites. The output is row-major,
+ * distance[i*to.size()+j] is the distance from site i of from to site j of
+ * to.
+ *
+ * The matrix is computed in tiles of a few rows by a few hundred columns,
+ * the columns of a tile stay in the L1 cache while its rows are computed and
+ * each row of a tile is a contiguous run of the output. The tiles are shared
+ * by the workers of vincenty::parallel, threads is the number of workers, 0
+ * for one per online CPU. The distances are the same as those of
+ * inverse_one_to_many(), whatever the number of threads.
+ */
+//!@{
+
+//! Distance matrix into from.size()*to.size() doubles [m].
+void distance_matrix(
+    const prepared_sites& from,
+    const prepared_sites& to,
+    double* distance,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+//! Distance matrix into from.size()*to.size() floats [m].
+void distance_matrix(
+    const prepared_sites& from,
+    const prepared_sites& to,
+    float* distance,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+/*!
+ * @brief Distance matrix into a file, for matrices larger than the memory.
+ *
+ * The file is created, or truncated, to from.size()*to.size() elements of T,
+ * float or double, and the matrix is written through a shared memory map of
+ * it. The file holds the raw row-major matrix in the byte order of the
+ * machine, without any header.
+ *
+ * @return False if the file could not be created, allocated or mapped.
+ */
+template <typename T> bool distance_matrix_file(
+    const prepared_sites& from,
+    const prepared_sites& to,
+    const std::string& path,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+//!@}
+
+/*!
+ * @defgroup vincenty_condensed_matrix Vincenty condensed distance matrix
+ *
+ * Every pair of one set of sites, for clustering. The inverse formula gives
+ * the same distance from a to b as from b to a, with the bearings swapped,
+ * so each unordered pair is computed once and only the upper triangle, the
+ * pairs i<j, is stored. The triangle is condensed row by row as by the
+ * clustering libraries, (0,1), (0,2), ..., (0,n-1), (1,2), ...,
+ * condensed_index() gives the position of a pair in either order.
+ *
+ * The triangle is computed in square tiles of a few hundred sites, which
+ * all are the same work but for the halves on the diagonal, shared by the
+ * workers of vincenty::parallel. The distances are the same as those of
+ * distance_matrix() on the same sites.
+ */
+//!@{
+
+//! Number of pairs of n sites, n*(n-1)/2.
+inline size_t condensed_size( const size_t n ) {
+  return n < 2 ? 0 : n*(n-1)/2;
+}
+
+//! Position of the pair of the sites i and j, i != j, of n sites.
+inline size_t condensed_index( const size_t i, const size_t j, const size_t n ) {
+  return i < j ?
+      i*n - i*(i+1)/2 + j - i - 1 :
+      j*n - j*(j+1)/2 + i - j - 1;
+}
+
+//! Distances of every pair into condensed_size(sites.size()) doubles [m].
+void pairwise_distances(
+    const prepared_sites& sites,
+    double* distance,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+//! Distances of every pair into condensed_size(sites.size()) floats [m].
+void pairwise_distances(
+    const prepared_sites& sites,
+    float* distance,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+/*!
+ * @brief The directions of every pair of a set of sites.
+ *
+ * Holds the condensed bearings and distances of the pairs i<j, the
+ * accessors gives either direction of a pair.
+ */
+class condensed_matrix
+{
+ public:
+  condensed_matrix();
+  explicit condensed_matrix( const prepared_sites& sites,
+                             const unsigned int threads = 0,
+                             const double accuracy = default_accuracy );
+
+  //! Number of sites.
+  size_t size() const { return _n; }
+
+  //! Distance between the sites i and j, in either order [m].
+  double distance( const size_t i, const size_t j ) const {
+    return i == j ? 0 : _distance[condensed_index(i,j,_n)];
+  }
+
+  //! Direction from site i towards site j, as inverse() would give it.
+  vdirection direction( const size_t i, const size_t j ) const;
+
+  //! The condensed distances, condensed_size(size()) elements.
+  const std::vector<double>& distances() const { return _distance; }
+
+ private:
+  size_t _n;
+  std::vector<double> _bearing1;
+  std::vector<double> _distance;
+  std::vector<double> _bearing2;
+};
+
+//!@}
+
+} // namespace end
+
+#endif
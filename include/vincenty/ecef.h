@@ -0,0 +1,130 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#ifndef __ecef_h__
+#define __ecef_h__
+
+#include "vincenty.h"
+
+#include <cmath>
+
+namespace vincenty {
+
+/*!
+ * @defgroup vincenty_ecef Vincenty ECEF bounds
+ *
+ * Earth-centered Earth-fixed coordinates and the bounds they give on the
+ * geodesic distance, to decide whether positions are within a distance
+ * without the inverse formula for most of them.
+ *
+ * The straight chord between two positions is never longer than the
+ * geodesic between them, which gives the lower bound. The geodesic curves no
+ * more than a circle with the smallest radius of curvature of the ellipsoid,
+ * which by Schur's comparison theorem makes it no longer than the arc of
+ * that circle over the same chord, which gives the upper bound. The bounds
+ * are a millimeter looser than that, more than the rounding of the
+ * coordinates and the error of the inverse formula at the default accuracy,
+ * so that they also hold for the computed distances.
+ *
+ * The bounds are a fraction of a percent apart up to some hundred
+ * kilometers, only positions within that fraction of the distance asked for
+ * needs the inverse formula. All on WGS84.
+ */
+//!@{
+
+/*!
+ * @brief Earth-centered Earth-fixed coordinates of n positions on the
+ * ellipsoid surface [m].
+ *
+ * The x axis points to latitude and longitude zero, the z axis to the north
+ * pole. The outputs are separate arrays of n elements each.
+ */
+void to_ecef(
+    const double* lat,
+    const double* lon,
+    double* x,
+    double* y,
+    double* z,
+    const size_t n );
+
+//! Earth-centered Earth-fixed coordinates of one position, x, y and z [m].
+void to_ecef( const vposition& pos, double* xyz );
+
+//! Straight distance between two Earth-centered Earth-fixed points [m].
+inline double chord( const double* xyz1, const double* xyz2 ) {
+  const double dx = xyz1[0] - xyz2[0];
+  const double dy = xyz1[1] - xyz2[1];
+  const double dz = xyz1[2] - xyz2[2];
+  return std::sqrt( dx*dx + dy*dy + dz*dz );
+}
+
+//! A distance never longer than the geodesic with the chord given [m].
+double distance_lower_bound( const double chord );
+
+//! A distance never shorter than the geodesic with the chord given [m].
+double distance_upper_bound( const double chord );
+
+//! A distance never longer than the geodesic between the positions [m].
+double distance_lower_bound( const vposition& pos1, const vposition& pos2 );
+
+//! A distance never shorter than the geodesic between the positions [m].
+double distance_upper_bound( const vposition& pos1, const vposition& pos2 );
+
+/*!
+ * @brief True if the positions are at most radius apart [m].
+ *
+ * The same as inverse(pos1,pos2,accuracy).distance <= radius, the inverse
+ * formula only runs if the bounds do not decide.
+ */
+bool within_distance(
+    const vposition& pos1,
+    const vposition& pos2,
+    const double radius,
+    const double accuracy = default_accuracy );
+
+/*!
+ * @brief Which of n positions are at most radius from a center [m].
+ *
+ * The positions are given both as latitudes and longitudes and as their
+ * coordinates from to_ecef(), typically computed once for a fixed set of
+ * positions. The chords to all positions are compared to the bounds first,
+ * the inverse formula only runs for those which the bounds do not decide.
+ *
+ * @param within Output, n elements, 1 for the positions within radius of
+ *               center and 0 for the others.
+ * @return The number of positions within radius.
+ */
+size_t within_distance(
+    const vposition& center,
+    const double* lat,
+    const double* lon,
+    const double* x,
+    const double* y,
+    const double* z,
+    const size_t n,
+    const double radius,
+    unsigned char* within,
+    const double accuracy = default_accuracy );
+
+//!@}
+
+} // namespace end
+
+#endif
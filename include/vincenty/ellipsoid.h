@@ -0,0 +1,129 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#ifndef __ellipsoid_h__
+#define __ellipsoid_h__
+
+namespace vincenty {
+
+/*!
+ * @defgroup vincenty_ellipsoids Ellipsoids
+ * @brief The reference ellipsoids the formulas can be computed on.
+ *
+ * @details An ellipsoid is given as a traits type with static members a()
+ * and b(), the flattening and the second eccentricity are derived from them.
+ * Datums only known at runtime uses an ellipsoid object, which has the same
+ * members but holds the values.
+ *
+ * The plain functions are always computed on WGS84. The formulas are also
+ * compiled with the constants of grs80 and bessel1841 folded, used by e.g.
+ * direct<grs80>() and inverse_batch<bessel1841>(). Other traits types are
+ * converted to an ellipsoid object and cost the same as the ellipsoid
+ * overloads.
+ */
+
+//!@{
+
+/*!
+ * @brief Constants derived from the semi-axes, inherited by the traits.
+ */
+template <typename E> struct ellipsoid_traits
+{
+  //! Flattening, (a-b)/a [-].
+  static double f() {
+    return ( E::a() - E::b() ) / E::a();
+  }
+
+  //! Second eccentricity squared, (a^2-b^2)/b^2 [-].
+  static double ep2() {
+    return ( E::a() * E::a() ) / ( E::b() * E::b() ) - 1;
+  }
+};
+
+//! World Geodetic System 1984, the default.
+struct wgs84 : ellipsoid_traits<wgs84>
+{
+  static double a() { return 6378137.0000; }
+  static double b() { return 6356752.3142; }
+};
+
+//! Geodetic Reference System 1980.
+struct grs80 : ellipsoid_traits<grs80>
+{
+  static double a() { return 6378137.0000; }
+  static double b() { return 6356752.3141; }
+};
+
+//! Bessel 1841.
+struct bessel1841 : ellipsoid_traits<bessel1841>
+{
+  static double a() { return 6377397.1550; }
+  static double b() { return 6356078.9628; }
+};
+
+/*!
+ * @brief An ellipsoid known at runtime.
+ *
+ * Same members as the traits types, but read from the object by the
+ * formulas.
+ */
+class ellipsoid
+{
+ public:
+  /*!
+   * @brief Constructor from the semi-axes.
+   *
+   * @param a Semi-major axis [m].
+   * @param b Semi-minor axis [m].
+   */
+  ellipsoid( double a, double b );
+
+  //! Constructor from one of the traits types, e.g. ellipsoid(grs80()).
+  template <typename E> explicit ellipsoid( const E& )
+      : _a(E::a()), _b(E::b()), _f(E::f()), _ep2(E::ep2())
+  {
+  }
+
+  /*!
+   * @brief Ellipsoid given by the semi-major axis and inverse flattening,
+   * the way most datums are published.
+   *
+   * @param a     Semi-major axis [m].
+   * @param inv_f Inverse flattening, 1/f [-].
+   */
+  static ellipsoid from_flattening( double a, double inv_f );
+
+  double a() const { return _a; }
+  double b() const { return _b; }
+  double f() const { return _f; }
+  double ep2() const { return _ep2; }
+
+ private:
+  double _a;
+  double _b;
+  double _f;
+  double _ep2;
+};
+
+//!@}
+
+} // namespace end
+
+#endif
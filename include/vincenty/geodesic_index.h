@@ -0,0 +1,130 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#ifndef __geodesic_index_h__
+#define __geodesic_index_h__
+
+#include "vincenty.h"
+
+#include <vector>
+
+namespace vincenty {
+
+/*!
+ * @brief A position found by geodesic_index, with its distance.
+ */
+class neighbour
+{
+ public:
+  neighbour();
+  neighbour( size_t index, double distance );
+
+  //! Closer first, the smaller index first at equal distances.
+  bool operator<( const neighbour& rhs ) const {
+    return distance < rhs.distance ||
+        ( distance == rhs.distance && index < rhs.index );
+  }
+
+  //! Index of the position in the vector the index was built from.
+  size_t index;
+
+  //! Distance from the query [m].
+  double distance;
+};
+
+//! Vector of neighbours.
+typedef std::vector<neighbour> neighbour_vector;
+
+/*!
+ * @brief A spatial index for nearest neighbour and radius searches with
+ * Vincenty's distances.
+ *
+ * @details The positions are put in a ball tree over their Earth-centered
+ * Earth-fixed coordinates. The straight chord between two positions is
+ * never longer than the geodesic between them, so the distance from a query
+ * to the ball of a node, a few multiplications, gives a lower bound of the
+ * distances to all positions below it, see @ref vincenty_ecef. Nodes and positions whose bound
+ * rules them out are skipped, the inverse formula is only run for the
+ * positions which remain. A query visits O(log n) nodes for a spread out set
+ * of positions.
+ *
+ * The results are the same as those of computing the distance to every
+ * position with inverse() and sorting. The index is not changed by the
+ * queries, any number of threads may query it at the same time. The
+ * distances are on WGS84.
+ */
+class geodesic_index
+{
+ public:
+  geodesic_index();
+  explicit geodesic_index( const vposition_vector& positions,
+                           const double accuracy = default_accuracy );
+
+  //! Number of positions.
+  size_t size() const { return _points.size(); }
+
+  /*!
+   * @brief The k positions nearest to pos, nearest first.
+   *
+   * Fewer than k if the index has fewer positions.
+   */
+  neighbour_vector nearest( const vposition& pos, const size_t k ) const;
+
+  //! The positions at most radius from pos [m], nearest first.
+  neighbour_vector within( const vposition& pos, const double radius ) const;
+
+ private:
+  //! Tree node, a ball holding the positions [begin,end).
+  struct node
+  {
+    double center[3];
+    double radius;
+    size_t begin;
+    size_t end;
+    size_t left;
+    size_t right;
+  };
+
+  size_t _build( const size_t begin, const size_t end );
+  void _nearest( const size_t n,
+                 const prepared_position& pos,
+                 const double* xyz,
+                 const size_t k,
+                 neighbour_vector& heap ) const;
+  void _within( const size_t n,
+                const prepared_position& pos,
+                const double* xyz,
+                const double radius,
+                neighbour_vector& found ) const;
+
+  double _accuracy;
+
+  // In tree order, the positions of a node are consecutive.
+  std::vector<prepared_position> _points;
+  std::vector<double> _xyz;
+  std::vector<size_t> _index;
+
+  // The root is the first node, a leaf has no children.
+  std::vector<node> _nodes;
+};
+
+} // namespace end
+
+#endif
@@ -0,0 +1,129 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+#ifndef __geodesic_line_h__
+#define __geodesic_line_h__
+
+#include "vincenty.h"
+
+#include <vector>
+
+namespace vincenty {
+
+/*!
+ * @brief A geodesic given by an origin and the bearing at the origin.
+ *
+ * Vincenty's direct formula for many distances along the same line. The
+ * terms which depends only on the origin and the bearing (the reduced
+ * latitude, sigma1, alpha and the A, B and C series) are computed once by the
+ * constructor. Each position along the line then costs only the sigma
+ * iteration and the final atan2s.
+ *
+ * Useful for densifying routes or placing markers every N meters. The
+ * positions are the same as from direct() with the same arguments.
+ */
+class geodesic_line
+{
+ public:
+  /*!
+   * @brief The origin terms of the direct formula.
+   *
+   * Filled in by the constructor, only of interest to the implementation.
+   */
+  struct state
+  {
+    double lat;
+    double lon;
+    double cos_U1;
+    double sin_U1;
+    double sin_alpha1;
+    double cos_alpha1;
+    double sigma1;
+    double sin_alpha;
+    double cos2_alpha;
+    double A;
+    double B;
+    double C;
+  };
+
+  /*!
+   * @param lat      Latitude of the origin [radians].
+   * @param lon      Longitude of the origin [radians].
+   * @param bearing  Direction at the origin [radians].
+   * @param accuracy Maximum error for the computations [-].
+   */
+  geodesic_line( const double lat,
+                 const double lon,
+                 const double bearing,
+                 const double accuracy = default_accuracy );
+
+  /*!
+   * @param origin   Origin of the line.
+   * @param bearing  Direction at the origin [radians].
+   * @param accuracy Maximum error for the computations [-].
+   */
+  geodesic_line( const vposition& origin,
+                 const double bearing,
+                 const double accuracy = default_accuracy );
+
+  /*!
+   * @brief Position at a distance along the line.
+   *
+   * @param distance Distance from the origin [m], negative values goes the
+   * other way.
+   */
+  vposition position( const double distance ) const;
+
+  /*!
+   * @brief Positions at many distances along the line, computed with the
+   * batch kernels.
+   *
+   * @param distance Input array, n distances from the origin [m].
+   * @param lat      Output array, n latitudes [radians].
+   * @param lon      Output array, n longitudes [radians].
+   * @param n        Number of positions.
+   */
+  void positions( const double* distance,
+                  double* lat,
+                  double* lon,
+                  const size_t n ) const;
+
+  /*!
+   * @brief Positions at many distances along the line.
+   *
+   * @param distances Distances from the origin [m].
+   * @return One position per distance.
+   */
+  vposition_vector positions( const std::vector<double>& distances ) const;
+
+  //! @return The origin of the line.
+  vposition origin() const;
+
+  //! @return The bearing at the origin [radians].
+  double bearing() const;
+
+ private:
+  state _state;
+  double _bearing;
+  double _accuracy;
+};
+
+} // namespace end
+
+#endif
@@ -0,0 +1,99 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#ifndef __metrics_h__
+#define __metrics_h__
+
+#include <iosfwd>
+#include <string>
+
+#include <stdint.h>
+
+namespace vincenty {
+
+/*!
+ * @defgroup vincenty_metrics Metrics
+ * @brief Counters of the work done by the library.
+ *
+ * @details Every thread counts in its own set of counters, with neither locks
+ * nor atomic read-modify-write, and metrics() adds the sets of all threads
+ * together. Counts of threads which have exited are kept.
+ *
+ * Iterations are counted by direct(), inverse() and the double precision
+ * WGS84 batches, the other methods count their calls only. The counters are
+ * compiled out when the library is built with VINCENTY_NO_METRICS defined,
+ * metrics() then returns zeros.
+ */
+
+//!@{
+
+//! All counters, summed over the threads, since the library was loaded.
+class metrics_snapshot
+{
+ public:
+  metrics_snapshot();
+
+  //! Direct problems solved, one per position of a batch.
+  uint64_t direct_calls;
+
+  //! Inverse problems solved, one per pair of a batch.
+  uint64_t inverse_calls;
+
+  //! Sigma and lambda iterations used.
+  uint64_t iterations;
+
+  //! Problems whose iteration stopped at the limit before the accuracy.
+  uint64_t not_converged;
+
+  //! Calls to CoordinateGrid::split().
+  uint64_t grid_splits;
+
+  //! Positions computed by the splits.
+  uint64_t grid_positions;
+
+  //! Positions interpolated by CoordinateGrid::operator().
+  uint64_t grid_lookups;
+};
+
+//! Merge the counters of all threads.
+metrics_snapshot metrics();
+
+/*!
+ * @brief Write a snapshot in the Prometheus text exposition format.
+ *
+ * All counters are named vincenty_*_total.
+ */
+std::ostream& write_prometheus( std::ostream& os, const metrics_snapshot& m );
+
+/*!
+ * @brief Write a snapshot to a file, for the node exporter textfile collector.
+ *
+ * The text is written to path.tmp which is then renamed to path, the
+ * collector never reads a partial file.
+ *
+ * @return False if the file could not be written.
+ */
+bool write_prometheus( const std::string& path, const metrics_snapshot& m );
+
+//!@}
+
+} // namespace end
+
+#endif
@@ -0,0 +1,120 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#ifndef __parallel_h__
+#define __parallel_h__
+
+#include "vincenty.h"
+
+namespace vincenty {
+
+/*!
+ * @brief Multi-threaded versions of the batch functions.
+ *
+ * @details The input is split in chunks of a few thousand elements, small
+ * enough for the inputs and outputs of a chunk to stay in the L2 cache. Each
+ * worker starts with a contiguous share of the chunks and takes them from the
+ * front. A worker which runs out steals chunks from the back of the others,
+ * so a share with slow, nearly antipodal, pairs does not keep the others
+ * idle. The calling thread is one of the workers.
+ *
+ * The worker threads are started on first use and kept for later calls.
+ * Only one call at a time runs on them, a call made while another one is
+ * running, or from within a worker, runs on its calling thread only.
+ *
+ * The results are the same as those of the batch functions. The argument
+ * threads is the number of workers, 0 for one per online CPU.
+ */
+namespace parallel {
+
+//!@{
+
+//! Number of workers used when threads is 0, the number of online CPUs.
+unsigned int default_threads();
+
+//! Elementwise inverse formula, as vincenty::inverse_batch().
+void inverse(
+    const double* lat1,
+    const double* lon1,
+    const double* lat2,
+    const double* lon2,
+    double* bearing1,
+    double* distance,
+    double* bearing2,
+    const size_t n,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+//! Elementwise direct formula, as vincenty::direct_batch().
+void direct(
+    const double* lat,
+    const double* lon,
+    const double* bearing,
+    const double* distance,
+    double* lat2,
+    double* lon2,
+    const size_t n,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+//! One origin to many targets, as vincenty::inverse_one_to_many().
+void inverse_one_to_many(
+    const vposition& origin,
+    const vposition* targets,
+    vdirection* dirs,
+    const size_t n,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+//! Distance only version of the one-to-many inverse formula.
+void inverse_one_to_many(
+    const vposition& origin,
+    const vposition* targets,
+    double* distance,
+    const size_t n,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+/*!
+ * @brief Distances from every position in from to every position in to.
+ *
+ * @param from     The m origins.
+ * @param m        Number of origins.
+ * @param to       The n targets.
+ * @param n        Number of targets.
+ * @param distance Output, m*n distances, row i holds the distances from
+ *                 from[i], i.e. distance[i*n+j] is from from[i] to to[j] [m].
+ */
+void inverse_pairwise(
+    const vposition* from,
+    const size_t m,
+    const vposition* to,
+    const size_t n,
+    double* distance,
+    const unsigned int threads = 0,
+    const double accuracy = default_accuracy );
+
+//!@}
+
+} // namespace parallel
+
+} // namespace end
+
+#endif
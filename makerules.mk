@@ -8,10 +8,19 @@ RELEASE  := 1
 REQUIRES := # Nothing
 $(call setup)
 
-CXXFLAGS += -march=native -fsanitize=address
+# The sanitizer makes the timings of bench/ meaningless, BENCH=1 leaves it out.
+ifndef BENCH
+CXXFLAGS += -fsanitize=address
+endif
+
+# Define VINCENTY_NO_METRICS to compile out the counters of vincenty/metrics.h.
+# CXXFLAGS += -DVINCENTY_NO_METRICS
 
 TARGETS := libvincenty.so
 
+# The metrics and the parallel batches use pthreads.
+_LDFLAGS := -pthread
+
 ifdef __bobBUILDSTAGE
 coverage: CXXFLAGS += --coverage
 coverage: check
@@ -0,0 +1,212 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "vincenty/approximate.h"
+#include "vincenty_internal.h"
+#include "vincenty_math.h"
+
+#include <algorithm>
+
+namespace {
+
+// The ellipsoid of the approximations, and the mean radius (2a+b)/3 of the
+// haversine sphere.
+const double a  = vincenty::wgs84::a();
+const double b  = vincenty::wgs84::b();
+const double f  = vincenty::wgs84::f();
+const double e2 = f*(2-f);
+const double R  = (2*a+b)/3;
+
+// Largest relative error of the haversine distance, the flattening.
+const double haversine_error = 0.0057;
+
+//! Longitude difference wrapped to [-pi,pi].
+inline double
+delta_lon( const double lon1, const double lon2 ) {
+  double d = lon2 - lon1;
+  if ( d > M_PI ) {
+    d -= 2*M_PI;
+  } else if ( d < -M_PI ) {
+    d += 2*M_PI;
+  }
+  return d;
+}
+
+//! Central angle between two points on a sphere, the haversine form.
+inline double
+central_angle( const double lat1, const double lat2, const double dlon ) {
+  const double s_lat = vmath::sin( (lat2-lat1)/2 );
+  const double s_lon = vmath::sin( dlon/2 );
+  const double h =
+      s_lat*s_lat + vmath::cos(lat1)*vmath::cos(lat2)*s_lon*s_lon;
+  return 2 * vmath::atan2( simd::sqrt(h), simd::sqrt(1-h) );
+}
+
+double
+tangent_plane( const double lat1,
+               const double lon1,
+               const double lat2,
+               const double lon2 ) {
+  double s_lat;
+  double c_lat;
+  vmath::sincos( (lat1+lat2)/2, &s_lat, &c_lat );
+
+  // Meridional (M) and prime vertical (N) radius of curvature.
+  const double w = 1 / simd::sqrt( 1 - e2*s_lat*s_lat );
+  const double N = a * w;
+  const double M = a * (1-e2) * w*w*w;
+
+  const double x = N * c_lat * delta_lon(lon1,lon2);
+  const double y = M * (lat2-lat1);
+  return simd::sqrt( x*x + y*y );
+}
+
+double
+haversine( const double lat1,
+           const double lon1,
+           const double lat2,
+           const double lon2 ) {
+  return R * central_angle( lat1, lat2, delta_lon(lon1,lon2) );
+}
+
+double
+andoyer_lambert( const double lat1,
+                 const double lon1,
+                 const double lat2,
+                 const double lon2 ) {
+  // Reduced latitudes.
+  const double U1 = vmath::atan( (1-f) * vmath::tan(lat1) );
+  const double U2 = vmath::atan( (1-f) * vmath::tan(lat2) );
+
+  const double sigma = central_angle( U1, U2, delta_lon(lon1,lon2) );
+  if ( sigma == 0 ) {
+    return 0;
+  }
+
+  double s_sigma;
+  double c_sigma;
+  vmath::sincos( sigma, &s_sigma, &c_sigma );
+
+  const double s_P = vmath::sin( (U1+U2)/2 );
+  const double c_Q = vmath::cos( (U2-U1)/2 );
+  const double s2_P = s_P*s_P;
+  const double c2_Q = c_Q*c_Q;
+
+  // cos^2(sigma/2) and sin^2(sigma/2), the first is zero at the antipode
+  // where the method is not valid anyway.
+  const double c2_half = ( 1 + c_sigma ) / 2;
+  const double s2_half = ( 1 - c_sigma ) / 2;
+
+  const double X = c2_half > 0 ?
+      ( sigma - s_sigma ) * s2_P * c2_Q / c2_half : 0;
+  const double Y =
+      ( sigma + s_sigma ) * ( 1-s2_P ) * ( 1-c2_Q ) / s2_half;
+
+  return a * ( sigma - f/2 * ( X + Y ) );
+}
+
+} // namespace end
+
+
+namespace vincenty
+{
+
+double approximate_distance( const approximation method,
+                             const double lat1,
+                             const double lon1,
+                             const double lat2,
+                             const double lon2 ) {
+  switch ( method ) {
+    case approx_tangent_plane:
+      return tangent_plane(lat1,lon1,lat2,lon2);
+    case approx_haversine:
+      return haversine(lat1,lon1,lat2,lon2);
+    case approx_andoyer_lambert:
+      return andoyer_lambert(lat1,lon1,lat2,lon2);
+    default:
+      return get_distance(lat1,lon1,lat2,lon2);
+  }
+}
+
+double approximation_error( const approximation method,
+                            const double distance,
+                            const double lat ) {
+  // The bounds are fitted to the largest errors against inverse() over
+  // millions of random pairs, with some margin. A millimeter is added to all
+  // of them for the rounding at short distances.
+  const double floor = 1e-3;
+
+  // Distance in radians of the mean sphere.
+  const double d = distance / R;
+  switch ( method ) {
+    case approx_tangent_plane: {
+      // Cubic in the distance, grows as tan^2 towards the poles. Not used
+      // beyond 0.1 radians (640 km).
+      if ( d > 0.1 ) {
+        return HUGE_VAL;
+      }
+      const double t = vmath::tan( simd::fabs(lat) );
+      return floor + distance * d*d * ( 0.02 + 0.2*t*t );
+    }
+    case approx_haversine:
+      return floor + distance * haversine_error;
+    case approx_andoyer_lambert: {
+      // 1.5e-6 of the distance up to a third of the circumference, then
+      // growing towards the antipode where the method breaks down.
+      if ( d > 3.0 ) {
+        return HUGE_VAL;
+      }
+      const double q2 = d*d/4;
+      const double q4 = q2*q2;
+      return floor + distance * ( 1.5e-6 + 2.5e-6*q4*q4 );
+    }
+    default:
+      return floor;
+  }
+}
+
+approximation select_approximation( const double distance,
+                                    const double lat,
+                                    const double tolerance ) {
+  for ( int m=approx_tangent_plane; m<approx_vincenty; ++m ) {
+    const approximation method = static_cast<approximation>(m);
+    if ( approximation_error(method,distance,lat) <= tolerance ) {
+      return method;
+    }
+  }
+  return approx_vincenty;
+}
+
+double get_distance( const double lat1,
+                     const double lon1,
+                     const double lat2,
+                     const double lon2,
+                     const double tolerance ) {
+  const double estimate = haversine(lat1,lon1,lat2,lon2);
+  const double lat = std::max( simd::fabs(lat1), simd::fabs(lat2) );
+  const approximation method =
+      select_approximation( estimate * (1+haversine_error), lat, tolerance );
+  if ( method == approx_haversine ) {
+    return estimate;
+  }
+  return approximate_distance(method,lat1,lon1,lat2,lon2);
+}
+
+} // namespace end
@@ -0,0 +1,312 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "vincenty/cells.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+// The bits of x in the even bits of the result.
+inline uint64_t
+spread( uint64_t x ) {
+  x &= 0xffffffffULL;
+  x = ( x | ( x << 16 ) ) & 0x0000ffff0000ffffULL;
+  x = ( x | ( x <<  8 ) ) & 0x00ff00ff00ff00ffULL;
+  x = ( x | ( x <<  4 ) ) & 0x0f0f0f0f0f0f0f0fULL;
+  x = ( x | ( x <<  2 ) ) & 0x3333333333333333ULL;
+  x = ( x | ( x <<  1 ) ) & 0x5555555555555555ULL;
+  return x;
+}
+
+// The even bits of x.
+inline uint64_t
+compact( uint64_t x ) {
+  x &= 0x5555555555555555ULL;
+  x = ( x | ( x >>  1 ) ) & 0x3333333333333333ULL;
+  x = ( x | ( x >>  2 ) ) & 0x0f0f0f0f0f0f0f0fULL;
+  x = ( x | ( x >>  4 ) ) & 0x00ff00ff00ff00ffULL;
+  x = ( x | ( x >>  8 ) ) & 0x0000ffff0000ffffULL;
+  x = ( x | ( x >> 16 ) ) & 0x00000000ffffffffULL;
+  return x;
+}
+
+// The longitudes in the even bits, the latitudes in the odd.
+inline vincenty::cell_id
+make_cell( const unsigned int level, const uint64_t row, const uint64_t col ) {
+  return ( uint64_t(1) << 2*level ) | spread(col) | ( spread(row) << 1 );
+}
+
+inline void
+split_cell( const vincenty::cell_id cell,
+            unsigned int* level,
+            uint64_t* row,
+            uint64_t* col ) {
+  *level = vincenty::cell_level(cell);
+  const uint64_t bits = cell & ~( uint64_t(1) << 2*(*level) );
+  *row = compact( bits >> 1 );
+  *col = compact( bits );
+}
+
+// Range number of x in [lo,lo+2^level*width), clamped to the first and last.
+inline uint64_t
+range( const double x, const double lo, const double width,
+       const unsigned int level ) {
+  const double t = ( x - lo ) / width;
+  const uint64_t last = ( uint64_t(1) << level ) - 1;
+  return t <= 0 ? 0 : std::min( uint64_t(t), last );
+}
+
+inline double
+row_height( const unsigned int level ) {
+  return M_PI / double( uint64_t(1) << level );
+}
+
+inline double
+col_width( const unsigned int level ) {
+  return 2*M_PI / double( uint64_t(1) << level );
+}
+
+// Smallest radius of curvature of the meridian, at the equator, and the
+// radius of the parallel at latitude lat.
+inline double
+meridian_radius() {
+  return vincenty::wgs84::b() * vincenty::wgs84::b() / vincenty::wgs84::a();
+}
+
+inline double
+parallel_radius( const double lat ) {
+  const double f  = vincenty::wgs84::f();
+  const double e2 = f * ( 2 - f );
+  const double s  = std::sin(lat);
+  return vincenty::wgs84::a() * std::cos(lat) / std::sqrt( 1 - e2 * s * s );
+}
+
+// Kept for distances computed by the inverse formula, as for the bounds of
+// vincenty/ecef.h [m].
+const double slack = 1e-3;
+} // namespace end
+
+namespace vincenty
+{
+
+// Cells
+// ------------------------------------------------------------------------
+cell_id to_cell( const vposition& pos, const unsigned int level ) {
+  cell_id cell;
+  to_cells( &pos.coords.a[0], &pos.coords.a[1], &cell, 1, level );
+  return cell;
+}
+
+void to_cells( const double* lat,
+               const double* lon,
+               cell_id* cells,
+               const size_t n,
+               const unsigned int level ) {
+  assert( level <= max_cell_level );
+  const double height = row_height(level);
+  const double width  = col_width(level);
+  for ( size_t i=0; i<n; ++i ) {
+    // Longitudes to [-pi,pi) first.
+    const double x = lon[i] - 2*M_PI * std::floor( ( lon[i] + M_PI ) / ( 2*M_PI ) );
+    cells[i] = make_cell( level,
+                          range( lat[i], -M_PI/2, height, level ),
+                          range( x, -M_PI, width, level ) );
+  }
+}
+
+unsigned int cell_level( const cell_id cell ) {
+  return ( 63 - __builtin_clzll(cell) ) / 2;
+}
+
+cell_id cell_parent( const cell_id cell, const unsigned int level ) {
+  assert( level <= cell_level(cell) );
+  return cell >> 2*( cell_level(cell) - level );
+}
+
+void cell_bounds( const cell_id cell, vposition* sw, vposition* ne ) {
+  unsigned int level;
+  uint64_t row, col;
+  split_cell( cell, &level, &row, &col );
+  const double height = row_height(level);
+  const double width  = col_width(level);
+  *sw = vposition( -M_PI/2 + row * height, -M_PI + col * width );
+  *ne = vposition( -M_PI/2 + ( row + 1 ) * height,
+                   -M_PI + ( col + 1 ) * width );
+}
+
+vposition cell_center( const cell_id cell ) {
+  unsigned int level;
+  uint64_t row, col;
+  split_cell( cell, &level, &row, &col );
+  return vposition( -M_PI/2 + ( row + 0.5 ) * row_height(level),
+                    -M_PI + ( col + 0.5 ) * col_width(level) );
+}
+
+void cell_centers( const cell_id* cells,
+                   double* lat,
+                   double* lon,
+                   const size_t n ) {
+  for ( size_t i=0; i<n; ++i ) {
+    const vposition center = cell_center( cells[i] );
+    lat[i] = center.coords.a[0];
+    lon[i] = center.coords.a[1];
+  }
+}
+
+std::vector<cell_id> cell_neighbours( const cell_id cell ) {
+  unsigned int level;
+  uint64_t row, col;
+  split_cell( cell, &level, &row, &col );
+  const int64_t n = int64_t(1) << level;
+
+  std::vector<cell_id> cells;
+  for ( int64_t r=int64_t(row)-1; r<=int64_t(row)+1; ++r ) {
+    for ( int64_t c=int64_t(col)-1; c<=int64_t(col)+1; ++c ) {
+      const cell_id next = make_cell( level, r, ( c + n ) % n );
+      if ( r >= 0 && r < n && next != cell ) {
+        cells.push_back(next);
+      }
+    }
+  }
+  // At the first levels the wrapped columns are the same cells.
+  std::sort( cells.begin(), cells.end() );
+  cells.erase( std::unique( cells.begin(), cells.end() ), cells.end() );
+  return cells;
+}
+
+std::vector<cell_id> cells_within( const cell_id cell, const double distance ) {
+  unsigned int level;
+  uint64_t row, col;
+  split_cell( cell, &level, &row, &col );
+  const int64_t n      = int64_t(1) << level;
+  const double  height = row_height(level);
+  const double  width  = col_width(level);
+  const double  s      = std::max( distance, 0.0 ) + slack;
+
+  // A geodesic is at least as long as the meridian arc between the
+  // latitudes of its ends.
+  const double lat0 = -M_PI/2 + row * height;
+  const double lat1 = lat0 + height;
+  const double dlat = s / meridian_radius();
+  const int64_t r0 = range( lat0 - dlat, -M_PI/2, height, level );
+  const int64_t r1 = range( lat1 + dlat, -M_PI/2, height, level );
+
+  std::vector<cell_id> cells;
+  for ( int64_t r=r0; r<=r1; ++r ) {
+    // A geodesic between the latitudes of the cell and of the row is at
+    // least the chord 2*p*sin(dlon/2), p the smallest parallel of both.
+    const double lo  = std::min( lat0, -M_PI/2 + r * height );
+    const double hi  = std::max( lat1, -M_PI/2 + ( r + 1 ) * height );
+    const double p   = std::min( parallel_radius( std::max( lo, -M_PI/2 ) ),
+                                 parallel_radius( std::min( hi,  M_PI/2 ) ) );
+    int64_t c0 = 0;
+    int64_t c1 = n - 1;
+    if ( s < 2 * p ) {
+      const double dlon = 2 * std::asin( s / ( 2 * p ) );
+      c0 = int64_t( std::floor( ( col * width - dlon ) / width ) );
+      c1 = int64_t( std::floor( ( ( col + 1 ) * width + dlon ) / width ) );
+      if ( c1 - c0 + 1 >= n ) {
+        c0 = 0;
+        c1 = n - 1;
+      }
+    }
+    for ( int64_t c=c0; c<=c1; ++c ) {
+      cells.push_back( make_cell( level, r, ( c % n + n ) % n ) );
+    }
+  }
+  std::sort( cells.begin(), cells.end() );
+  cells.erase( std::unique( cells.begin(), cells.end() ), cells.end() );
+  return cells;
+}
+
+unsigned int cell_level_for( const double distance ) {
+  unsigned int level = 0;
+  while ( level < max_cell_level &&
+          row_height(level+1) * meridian_radius() >= distance ) {
+    ++level;
+  }
+  return level;
+}
+
+// Cell buckets
+// ------------------------------------------------------------------------
+
+//! Default constructor, no buckets.
+cell_buckets::cell_buckets()
+    : _level(0), _cells(), _offsets(1,0), _positions()
+{
+}
+
+//! Constructor bucketing the positions by their cells of the level.
+cell_buckets::cell_buckets( const vposition_vector& positions,
+                            const unsigned int level )
+    : _level(level), _cells(), _offsets(), _positions()
+{
+  std::vector<cell_id> cells( positions.size() );
+  for ( size_t i=0; i<positions.size(); ++i ) {
+    cells[i] = to_cell( positions[i], level );
+  }
+  _build(cells);
+}
+
+//! Constructor bucketing n positions given as latitudes and longitudes.
+cell_buckets::cell_buckets( const double* lat,
+                            const double* lon,
+                            const size_t n,
+                            const unsigned int level )
+    : _level(level), _cells(), _offsets(), _positions()
+{
+  std::vector<cell_id> cells(n);
+  to_cells( lat, lon, n ? &cells[0] : 0, n, level );
+  _build(cells);
+}
+
+void cell_buckets::_build( const std::vector<cell_id>& cells ) {
+  std::vector< std::pair<cell_id,size_t> > order( cells.size() );
+  for ( size_t i=0; i<cells.size(); ++i ) {
+    order[i] = std::make_pair( cells[i], i );
+  }
+  std::sort( order.begin(), order.end() );
+
+  _positions.resize( order.size() );
+  _offsets.push_back(0);
+  for ( size_t i=0; i<order.size(); ++i ) {
+    if ( i > 0 && order[i].first != order[i-1].first ) {
+      _offsets.push_back(i);
+    }
+    if ( i == 0 || order[i].first != order[i-1].first ) {
+      _cells.push_back( order[i].first );
+    }
+    _positions[i] = order[i].second;
+  }
+  if ( !order.empty() ) {
+    _offsets.push_back( order.size() );
+  }
+}
+
+size_t cell_buckets::find( const cell_id cell ) const {
+  const std::vector<cell_id>::const_iterator it =
+      std::lower_bound( _cells.begin(), _cells.end(), cell );
+  return it != _cells.end() && *it == cell ? it - _cells.begin() : size();
+}
+
+} // namespace end
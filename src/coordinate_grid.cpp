@@ -21,6 +21,7 @@
 #include "vincenty/coordinate_grid.h"
 
 #include "vincenty/vincenty.h"
+#include "vincenty_metrics.h"
 
 using namespace vincenty;
 
@@ -262,19 +263,45 @@ operator<<( std::ostream& os, CoordinateGrid& rhs )
 void
 CoordinateGrid::_initialize_news_from_center()
 {
-  _grid[0][1] = direct( _grid[1][1], direction::north, _grid_distance );
-  _grid[1][2] = direct( _grid[1][1], direction::east , _grid_distance );
-  _grid[2][1] = direct( _grid[1][1], direction::south, _grid_distance );
-  _grid[1][0] = direct( _grid[1][1], direction::west , _grid_distance );
+  const vposition& c = _grid[1][1];
+  const double lat[4] = { c.coords.a[0], c.coords.a[0],
+                          c.coords.a[0], c.coords.a[0] };
+  const double lon[4] = { c.coords.a[1], c.coords.a[1],
+                          c.coords.a[1], c.coords.a[1] };
+  const double bearing[4] = { direction::north, direction::east,
+                              direction::south, direction::west };
+  const double distance[4] = { _grid_distance, _grid_distance,
+                               _grid_distance, _grid_distance };
+  double lat2[4];
+  double lon2[4];
+  direct_batch( lat, lon, bearing, distance, lat2, lon2, 4 );
+
+  _grid[0][1] = vposition( lat2[0], lon2[0] );
+  _grid[1][2] = vposition( lat2[1], lon2[1] );
+  _grid[2][1] = vposition( lat2[2], lon2[2] );
+  _grid[1][0] = vposition( lat2[3], lon2[3] );
 }
 
 void
 CoordinateGrid::_initialize_corners_from_center()
 {
-  _grid[0][2] = direct( _grid[1][1], direction::northeast, sqrt2*_grid_distance );
-  _grid[2][2] = direct( _grid[1][1], direction::southeast, sqrt2*_grid_distance );
-  _grid[2][0] = direct( _grid[1][1], direction::southwest, sqrt2*_grid_distance );
-  _grid[0][0] = direct( _grid[1][1], direction::northwest, sqrt2*_grid_distance );
+  const vposition& c = _grid[1][1];
+  const double lat[4] = { c.coords.a[0], c.coords.a[0],
+                          c.coords.a[0], c.coords.a[0] };
+  const double lon[4] = { c.coords.a[1], c.coords.a[1],
+                          c.coords.a[1], c.coords.a[1] };
+  const double bearing[4] = { direction::northeast, direction::southeast,
+                              direction::southwest, direction::northwest };
+  const double distance[4] = { sqrt2*_grid_distance, sqrt2*_grid_distance,
+                               sqrt2*_grid_distance, sqrt2*_grid_distance };
+  double lat2[4];
+  double lon2[4];
+  direct_batch( lat, lon, bearing, distance, lat2, lon2, 4 );
+
+  _grid[0][2] = vposition( lat2[0], lon2[0] );
+  _grid[2][2] = vposition( lat2[1], lon2[1] );
+  _grid[2][0] = vposition( lat2[2], lon2[2] );
+  _grid[0][0] = vposition( lat2[3], lon2[3] );
 }
 
 void
@@ -508,6 +535,19 @@ CoordinateGrid::_split()
   // (only containing positions at 0,0).
   coord_grid grid( new_grid_size, coord_vector( new_grid_size ) );
 
+  // All new points are the middle of a line between two old points. The two
+  // old points of every new point are collected as arrays first and then all
+  // middle points are computed by the batch functions in one go.
+  const size_t num_new_points =
+      new_grid_size * new_grid_size - _grid.size() * _grid.size();
+  std::vector<double> lat1, lon1, lat2, lon2;
+  std::vector<vposition*> dest;
+  lat1.reserve(num_new_points);
+  lon1.reserve(num_new_points);
+  lat2.reserve(num_new_points);
+  lon2.reserve(num_new_points);
+  dest.reserve(num_new_points);
+
   // Variables i and j loops columns and rows repectively in the new grid,
   // which is supposed to be filled with new data.  Indexes m and n handles
   // the column indexing while u and v are for row indexing in the old
@@ -519,40 +559,47 @@ CoordinateGrid::_split()
     for ( unsigned int j=0; j<new_grid_size; ++j ) {
       const unsigned int u = j/2;
       const unsigned int v = (j+1)/2;
-      if ( i%2 == 0 ) {
-        if ( j%2 == 0 ) {
-          // When both i and j are even we are located on an "old" point, or a
-          // point corresponding to a point in the old grid. Just copy the
-          // point.  grid[i][j] = grid[m][u];
-          grid[i][j] = _grid[m][u];
-        } else {
-          // If only i is even, use the m index to get the column in the old
-          // grid (both m and n will have the same value in this case) and
-          // then u and v to get the row. Index u and v will have different
-          // values here which is why we must find a point between them.
-               
-          // Create a vdirection between two old points and then use the
-          // bearing from that calculation to find the point exactly between
-          // the two points. The distance between grid points for the new grid
-          // is the old size / 2.
-          const vdirection a = inverse(_grid[m][u],_grid[m][v]);
-          grid[i][j] = direct(_grid[m][u],a.bearing1,a.distance/2.0);
-        }
+      if ( i%2 == 0 && j%2 == 0 ) {
+        // When both i and j are even we are located on an "old" point, or a
+        // point corresponding to a point in the old grid. Just copy the
+        // point.  grid[i][j] = grid[m][u];
+        grid[i][j] = _grid[m][u];
       } else {
-        if ( j%2 == 0 ) {
-          // Same case as with even i-index.
-          const vdirection a = inverse(_grid[m][u],_grid[n][u]);
-          grid[i][j] = direct(_grid[m][u],a.bearing1,a.distance/2.0);
-        } else {
-          // When both index i and j are odd we have point which is not on an
-          // old edge but rather in the middle of the old square. Create a
-          // diagonal line and find the middle point.
-          const vdirection a = inverse(_grid[m][u],_grid[n][v]);
-          grid[i][j] = direct(_grid[m][u],a.bearing1,a.distance/2.0);
-        }
+        // If only i is even, m and n will have the same value and u and v
+        // gives a line along the row in the old grid. If only j is even it
+        // is the same case along the column. When both index i and j are odd
+        // we have point which is not on an old edge but rather in the middle
+        // of the old square, i.e. a diagonal line.
+        lat1.push_back( _grid[m][u].coords.a[0] );
+        lon1.push_back( _grid[m][u].coords.a[1] );
+        lat2.push_back( _grid[n][v].coords.a[0] );
+        lon2.push_back( _grid[n][v].coords.a[1] );
+        dest.push_back( &grid[i][j] );
       }
     }
   }
+
+  // Create a vdirection between two old points and then use the bearing from
+  // that calculation to find the point exactly between the two points. The
+  // distance between grid points for the new grid is the old size / 2.
+  const size_t num = dest.size();
+  VINCENTY_COUNT(grid_splits,1);
+  VINCENTY_COUNT(grid_positions,num);
+  if ( num > 0 ) {
+    std::vector<double> bearing1(num), distance(num);
+    inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                   &bearing1[0], &distance[0], 0, num );
+    for ( size_t k=0; k<num; ++k ) {
+      distance[k] /= 2.0;
+    }
+    direct_batch( &lat1[0], &lon1[0], &bearing1[0], &distance[0],
+                  &lat2[0], &lon2[0], num );
+
+    for ( size_t k=0; k<num; ++k ) {
+      *dest[k] = vposition( lat2[k], lon2[k] );
+    }
+  }
+
   // Just assume the grid distance has halfed.
   _grid_distance /= 2;
   _grid.swap( grid );
@@ -617,6 +664,8 @@ CoordinateGrid::operator()( unsigned int i, unsigned int j ) const
     i = n;
   if ( j > n )
     j = n;
+
+  VINCENTY_COUNT(grid_lookups,1);
    
   // Compute the offset in fractions from the closest corner grid position.
   // {i,j}_0 is the {upper,left} most grid position. {i,j}_1 is just the next
@@ -0,0 +1,223 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "vincenty/distance_join.h"
+#include "vincenty/cells.h"
+#include "vincenty/ecef.h"
+#include "vincenty_parallel.h"
+
+#include <algorithm>
+
+#include <pthread.h>
+
+namespace
+{
+// Positions of the first set per block. A block is sorted by cell, so that
+// the buckets near a cell are looked up once for all of its positions.
+const size_t block_size = 4096;
+
+// The second set in bucket order, the positions of bucket k are
+// [offset[k],offset[k+1]) of the arrays.
+struct bucketed_set
+{
+  vincenty::cell_buckets buckets;
+  std::vector<size_t> offset;
+  std::vector<size_t> index;
+  std::vector<double> lat;
+  std::vector<double> lon;
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> z;
+};
+
+struct join_context
+{
+  const double* lat;
+  const double* lon;
+  const bucketed_set* set;
+  double radius;
+  double accuracy;
+  vincenty::join_callback callback;
+  void* context;
+  pthread_mutex_t lock;
+  size_t matches;
+};
+
+void
+emit( join_context& c, const std::vector<vincenty::join_match>& matches ) {
+  if ( matches.empty() ) {
+    return;
+  }
+  pthread_mutex_lock( &c.lock );
+  c.callback( c.context, &matches[0], matches.size() );
+  c.matches += matches.size();
+  pthread_mutex_unlock( &c.lock );
+}
+
+void
+join_block( join_context& c, const size_t begin, const size_t end,
+            std::vector< std::pair<vincenty::cell_id,size_t> >& order,
+            std::vector<unsigned char>& within,
+            std::vector<vincenty::join_match>& matches ) {
+  const bucketed_set& s = *c.set;
+  const unsigned int level = s.buckets.level();
+
+  order.clear();
+  for ( size_t i=begin; i<end; ++i ) {
+    const vincenty::vposition pos( c.lat[i], c.lon[i] );
+    order.push_back( std::make_pair( vincenty::to_cell(pos,level), i ) );
+  }
+  std::sort( order.begin(), order.end() );
+
+  matches.clear();
+  std::vector<size_t> near;
+  for ( size_t k=0; k<order.size(); ) {
+    // The buckets around the cell, for all positions in it.
+    const vincenty::cell_id cell = order[k].first;
+    const std::vector<vincenty::cell_id> cells =
+        vincenty::cells_within( cell, c.radius );
+    near.clear();
+    for ( size_t j=0; j<cells.size(); ++j ) {
+      const size_t b = s.buckets.find( cells[j] );
+      if ( b < s.buckets.size() ) {
+        near.push_back(b);
+      }
+    }
+
+    for ( ; k<order.size() && order[k].first == cell; ++k ) {
+      const size_t i = order[k].second;
+      const vincenty::vposition pos( c.lat[i], c.lon[i] );
+      for ( size_t j=0; j<near.size(); ++j ) {
+        const size_t o = s.offset[near[j]];
+        const size_t n = s.offset[near[j]+1] - o;
+        within.resize( std::max( within.size(), n ) );
+        if ( vincenty::within_distance( pos, &s.lat[o], &s.lon[o],
+                                        &s.x[o], &s.y[o], &s.z[o], n,
+                                        c.radius, &within[0],
+                                        c.accuracy ) == 0 ) {
+          continue;
+        }
+        for ( size_t p=0; p<n; ++p ) {
+          if ( within[p] ) {
+            matches.push_back( vincenty::join_match( i, s.index[o+p] ) );
+          }
+        }
+      }
+    }
+  }
+  emit( c, matches );
+}
+
+// Runs the range given in blocks, the whole set may be given at once when
+// the join runs on one thread.
+void
+join_task( void* context, const size_t begin, const size_t end ) {
+  join_context& c = *static_cast<join_context*>(context);
+  std::vector< std::pair<vincenty::cell_id,size_t> > order;
+  std::vector<unsigned char> within;
+  std::vector<vincenty::join_match> matches;
+  for ( size_t b=begin; b<end; b+=block_size ) {
+    join_block( c, b, std::min( b + block_size, end ), order, within, matches );
+  }
+}
+
+void
+collect( void* context, const vincenty::join_match* matches, size_t n ) {
+  std::vector<vincenty::join_match>& all =
+      *static_cast<std::vector<vincenty::join_match>*>(context);
+  all.insert( all.end(), matches, matches + n );
+}
+} // namespace end
+
+namespace vincenty
+{
+
+size_t distance_join( const double* lat1,
+                      const double* lon1,
+                      const size_t n1,
+                      const double* lat2,
+                      const double* lon2,
+                      const size_t n2,
+                      const double radius,
+                      join_callback callback,
+                      void* context,
+                      const unsigned int threads,
+                      const double accuracy ) {
+  if ( n1 == 0 || n2 == 0 || radius < 0 ) {
+    return 0;
+  }
+
+  bucketed_set s;
+  s.buckets = cell_buckets( lat2, lon2, n2, cell_level_for(radius) );
+  s.offset.push_back(0);
+  for ( size_t k=0; k<s.buckets.size(); ++k ) {
+    for ( const size_t* p=s.buckets.begin(k); p!=s.buckets.end(k); ++p ) {
+      s.index.push_back( *p );
+      s.lat.push_back( lat2[*p] );
+      s.lon.push_back( lon2[*p] );
+    }
+    s.offset.push_back( s.index.size() );
+  }
+  s.x.resize(n2);
+  s.y.resize(n2);
+  s.z.resize(n2);
+  to_ecef( &s.lat[0], &s.lon[0], &s.x[0], &s.y[0], &s.z[0], n2 );
+
+  join_context c;
+  c.lat      = lat1;
+  c.lon      = lon1;
+  c.set      = &s;
+  c.radius   = radius;
+  c.accuracy = accuracy;
+  c.callback = callback;
+  c.context  = context;
+  c.matches  = 0;
+  pthread_mutex_init( &c.lock, 0 );
+  parallel_for( n1, block_size, threads, &join_task, &c );
+  pthread_mutex_destroy( &c.lock );
+  return c.matches;
+}
+
+std::vector<join_match> distance_join( const vposition_vector& set1,
+                                       const vposition_vector& set2,
+                                       const double radius,
+                                       const unsigned int threads,
+                                       const double accuracy ) {
+  std::vector<double> lat1, lon1, lat2, lon2;
+  for ( size_t i=0; i<set1.size(); ++i ) {
+    lat1.push_back( set1[i].coords.a[0] );
+    lon1.push_back( set1[i].coords.a[1] );
+  }
+  for ( size_t i=0; i<set2.size(); ++i ) {
+    lat2.push_back( set2[i].coords.a[0] );
+    lon2.push_back( set2[i].coords.a[1] );
+  }
+
+  std::vector<join_match> all;
+  if ( !set1.empty() && !set2.empty() ) {
+    distance_join( &lat1[0], &lon1[0], lat1.size(),
+                   &lat2[0], &lon2[0], lat2.size(),
+                   radius, &collect, &all, threads, accuracy );
+  }
+  std::sort( all.begin(), all.end() );
+  return all;
+}
+
+} // namespace end
@@ -0,0 +1,326 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "vincenty/distance_matrix.h"
+#include "vincenty_dispatch.h"
+#include "vincenty_metrics.h"
+#include "vincenty_parallel.h"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+// A tile of 32 rows by 512 columns. The four arrays of 512 columns take 16
+// kB, which stays in L1 while the 32 rows of the tile are computed, and the
+// output of a tile is 64 or 128 kB of whole cache lines, which fits in L2.
+const size_t tile_rows = 32;
+const size_t tile_cols = 512;
+
+// The triangle of a condensed matrix is cut in square tiles of 256 sites,
+// the same work for every tile but those on the diagonal which are halves.
+// The rows of a band get shorter towards the diagonal, so bands of rows
+// would not balance.
+const size_t tile_sites = 256;
+
+inline void
+row( const vincenty::prepared_sites& from,
+     const size_t i,
+     const vincenty::prepared_sites& to,
+     const size_t begin,
+     const size_t end,
+     double* bearing1,
+     double* distance,
+     double* bearing2,
+     const double accuracy ) {
+  kernels().distance_row( from, i, to, begin, end,
+                          bearing1, distance, bearing2, accuracy );
+}
+
+inline void
+row( const vincenty::prepared_sites& from,
+     const size_t i,
+     const vincenty::prepared_sites& to,
+     const size_t begin,
+     const size_t end,
+     float* bearing1,
+     float* distance,
+     float* bearing2,
+     const double accuracy ) {
+  kernels().distance_rowf( from, i, to, begin, end,
+                           bearing1, distance, bearing2, accuracy );
+}
+
+// Output arrays may be null, they are then offset from null and never
+// written by the kernels.
+template <typename T> inline T*
+offset( T* p, const size_t i ) {
+  return p ? p + i : 0;
+}
+
+template <typename T> struct matrix_context
+{
+  const vincenty::prepared_sites* from;
+  const vincenty::prepared_sites* to;
+  T* bearing1;
+  T* distance;
+  T* bearing2;
+  size_t tiles_across;
+  double accuracy;
+};
+
+// The elements of the parallel_for() are the tiles, the tiles of a band of
+// rows are next to each other so that a share of tiles is a run of output.
+template <typename T> void
+matrix_task( void* context, const size_t begin, const size_t end ) {
+  const matrix_context<T>& c = *static_cast<matrix_context<T>*>(context);
+  const size_t m = c.from->size();
+  const size_t n = c.to->size();
+  for ( size_t t=begin; t<end; ++t ) {
+    const size_t r0 = ( t / c.tiles_across ) * tile_rows;
+    const size_t c0 = ( t % c.tiles_across ) * tile_cols;
+    const size_t r1 = std::min( r0 + tile_rows, m );
+    const size_t c1 = std::min( c0 + tile_cols, n );
+    for ( size_t i=r0; i<r1; ++i ) {
+      row( *c.from, i, *c.to, c0, c1,
+           0, c.distance + i*n + c0, 0, c.accuracy );
+    }
+  }
+}
+
+template <typename T> void
+matrix( const vincenty::prepared_sites& from,
+        const vincenty::prepared_sites& to,
+        T* distance,
+        const unsigned int threads,
+        const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,from.size()*to.size());
+  const size_t down   = ( from.size() + tile_rows - 1 ) / tile_rows;
+  const size_t across = ( to.size() + tile_cols - 1 ) / tile_cols;
+  matrix_context<T> c = { &from, &to, 0, distance, 0, across, accuracy };
+  parallel_for( down*across, 1, threads, &matrix_task<T>, &c );
+}
+
+// The tiles of the triangle are numbered band by band, band b holds the
+// tiles (b,b) to (b,tiles_across-1).
+template <typename T> void
+triangle_task( void* context, const size_t begin, const size_t end ) {
+  const matrix_context<T>& c = *static_cast<matrix_context<T>*>(context);
+  const size_t n = c.from->size();
+  for ( size_t t=begin; t<end; ++t ) {
+    size_t band = 0;
+    size_t k    = t;
+    while ( k >= c.tiles_across - band ) {
+      k -= c.tiles_across - band;
+      ++band;
+    }
+    const size_t r0 = band * tile_sites;
+    const size_t c0 = ( band + k ) * tile_sites;
+    const size_t r1 = std::min( r0 + tile_sites, n );
+    const size_t c1 = std::min( c0 + tile_sites, n );
+    for ( size_t i=r0; i<r1; ++i ) {
+      const size_t j = std::max( c0, i+1 );
+      if ( j < c1 ) {
+        const size_t o = vincenty::condensed_index( i, j, n );
+        row( *c.from, i, *c.from, j, c1,
+             offset(c.bearing1,o), offset(c.distance,o), offset(c.bearing2,o),
+             c.accuracy );
+      }
+    }
+  }
+}
+
+template <typename T> void
+triangle( const vincenty::prepared_sites& sites,
+          T* bearing1,
+          T* distance,
+          T* bearing2,
+          const unsigned int threads,
+          const double accuracy ) {
+  const size_t n = sites.size();
+  VINCENTY_COUNT(inverse_calls,vincenty::condensed_size(n));
+  const size_t across = ( n + tile_sites - 1 ) / tile_sites;
+  matrix_context<T> c = { &sites, &sites, bearing1, distance, bearing2,
+                          across, accuracy };
+  parallel_for( across*(across+1)/2, 1, threads, &triangle_task<T>, &c );
+}
+} // namespace end
+
+namespace vincenty
+{
+
+// Prepared sites
+// ------------------------------------------------------------------------
+
+//! Default constructor, no sites.
+prepared_sites::prepared_sites()
+    : _lat(), _lon(), _sin_U(), _cos_U()
+{
+}
+
+//! Constructor preparing the positions.
+prepared_sites::prepared_sites( const vposition_vector& sites )
+    : _lat(sites.size()), _lon(sites.size()),
+      _sin_U(sites.size()), _cos_U(sites.size())
+{
+  for ( size_t i=0; i<sites.size(); ++i ) {
+    _lat[i] = sites[i].coords.a[0];
+    _lon[i] = sites[i].coords.a[1];
+  }
+  _prepare();
+}
+
+//! Constructor preparing n positions.
+prepared_sites::prepared_sites( const vposition* sites, const size_t n )
+    : _lat(n), _lon(n), _sin_U(n), _cos_U(n)
+{
+  for ( size_t i=0; i<n; ++i ) {
+    _lat[i] = sites[i].coords.a[0];
+    _lon[i] = sites[i].coords.a[1];
+  }
+  _prepare();
+}
+
+//! Constructor preparing n positions given as latitude and longitude arrays.
+prepared_sites::prepared_sites( const double* lat,
+                                const double* lon,
+                                const size_t n )
+    : _lat(lat,lat+n), _lon(lon,lon+n), _sin_U(n), _cos_U(n)
+{
+  _prepare();
+}
+
+void prepared_sites::_prepare() {
+  const kernel_table& k = kernels();
+  for ( size_t i=0; i<_lat.size(); ++i ) {
+    k.prepare( _lat[i], &_sin_U[i], &_cos_U[i] );
+  }
+}
+
+// Distance matrix
+// ------------------------------------------------------------------------
+void distance_matrix( const prepared_sites& from,
+                      const prepared_sites& to,
+                      double* distance,
+                      const unsigned int threads,
+                      const double accuracy ) {
+  matrix( from, to, distance, threads, accuracy );
+}
+
+void distance_matrix( const prepared_sites& from,
+                      const prepared_sites& to,
+                      float* distance,
+                      const unsigned int threads,
+                      const double accuracy ) {
+  matrix( from, to, distance, threads, accuracy );
+}
+
+// Condensed matrix
+// ------------------------------------------------------------------------
+void pairwise_distances( const prepared_sites& sites,
+                         double* distance,
+                         const unsigned int threads,
+                         const double accuracy ) {
+  triangle( sites, static_cast<double*>(0), distance, static_cast<double*>(0),
+            threads, accuracy );
+}
+
+void pairwise_distances( const prepared_sites& sites,
+                         float* distance,
+                         const unsigned int threads,
+                         const double accuracy ) {
+  triangle( sites, static_cast<float*>(0), distance, static_cast<float*>(0),
+            threads, accuracy );
+}
+
+//! Default constructor, no sites.
+condensed_matrix::condensed_matrix()
+    : _n(0), _bearing1(), _distance(), _bearing2()
+{
+}
+
+//! Constructor computing every pair of the sites.
+condensed_matrix::condensed_matrix( const prepared_sites& sites,
+                                    const unsigned int threads,
+                                    const double accuracy )
+    : _n(sites.size()),
+      _bearing1(condensed_size(sites.size())),
+      _distance(condensed_size(sites.size())),
+      _bearing2(condensed_size(sites.size()))
+{
+  if ( _n > 1 ) {
+    triangle( sites, &_bearing1[0], &_distance[0], &_bearing2[0],
+              threads, accuracy );
+  }
+}
+
+vdirection condensed_matrix::direction( const size_t i,
+                                        const size_t j ) const {
+  if ( i == j ) {
+    return vdirection(0,0,0);
+  }
+  const size_t k = condensed_index(i,j,_n);
+  // The pair is stored from the smaller index, reversed the bearings swap.
+  return i < j ?
+      vdirection(_bearing1[k],_distance[k],_bearing2[k]) :
+      vdirection(_bearing2[k],_distance[k],_bearing1[k]);
+}
+
+template <typename T> bool distance_matrix_file( const prepared_sites& from,
+                                                 const prepared_sites& to,
+                                                 const std::string& path,
+                                                 const unsigned int threads,
+                                                 const double accuracy ) {
+  const int fd = open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if ( fd < 0 ) {
+    return false;
+  }
+  const size_t bytes = from.size() * to.size() * sizeof(T);
+  if ( bytes == 0 ) {
+    return close(fd) == 0;
+  }
+
+  // The blocks are allocated up front, a full disk then fails here instead
+  // of raising SIGBUS on a store through the map.
+  if ( ftruncate( fd, bytes ) != 0 || posix_fallocate( fd, 0, bytes ) != 0 ) {
+    close(fd);
+    return false;
+  }
+  void* map = mmap( 0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close(fd);
+  if ( map == MAP_FAILED ) {
+    return false;
+  }
+
+  matrix( from, to, static_cast<T*>(map), threads, accuracy );
+  return munmap( map, bytes ) == 0;
+}
+
+template bool distance_matrix_file<double>(
+    const prepared_sites&, const prepared_sites&, const std::string&,
+    unsigned int, double );
+template bool distance_matrix_file<float>(
+    const prepared_sites&, const prepared_sites&, const std::string&,
+    unsigned int, double );
+
+} // namespace end
@@ -0,0 +1,161 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "vincenty/ecef.h"
+#include "vincenty_dispatch.h"
+
+#include <limits>
+
+namespace
+{
+// Taken off the lower bounds and added to the upper bounds [m].
+const double slack = 1e-3;
+
+// The longest geodesic, half a meridian [m].
+const double longest = 20003931.4586;
+
+// The smallest radius of curvature, that of the meridian at the equator.
+inline double
+rho() {
+  return vincenty::wgs84::b() * vincenty::wgs84::b() / vincenty::wgs84::a();
+}
+
+// The arc bound holds for geodesics up to pi*rho, which all have shorter
+// chords than the longest geodesic. A chord at least this long may be of a
+// geodesic of any length.
+inline double
+longest_chord() {
+  return 2 * rho() * std::sin( longest / ( 2 * rho() ) );
+}
+
+// The chords below which the upper bound is at most radius, squared.
+double
+inside_chord2( const double radius ) {
+  const double s = radius - slack;
+  if ( s < 0 ) {
+    return 0;
+  }
+  if ( s >= longest ) {
+    return std::numeric_limits<double>::infinity();
+  }
+  if ( s >= M_PI * rho() ) {
+    return longest_chord() * longest_chord();
+  }
+  const double c = std::min( 2 * rho() * std::sin( s / ( 2 * rho() ) ),
+                             longest_chord() );
+  return c * c;
+}
+
+// The chords above which the lower bound is above radius, squared.
+double
+outside_chord2( const double radius ) {
+  return radius < -slack ? -1 : ( radius + slack ) * ( radius + slack );
+}
+} // namespace end
+
+namespace vincenty
+{
+
+void to_ecef( const double* lat,
+              const double* lon,
+              double* x,
+              double* y,
+              double* z,
+              const size_t n ) {
+  kernels().to_ecef( lat, lon, x, y, z, n );
+}
+
+void to_ecef( const vposition& pos, double* xyz ) {
+  kernels().to_ecef( &pos.coords.a[0], &pos.coords.a[1],
+                     &xyz[0], &xyz[1], &xyz[2], 1 );
+}
+
+double distance_lower_bound( const double chord ) {
+  return chord > slack ? chord - slack : 0;
+}
+
+double distance_upper_bound( const double chord ) {
+  if ( chord < longest_chord() ) {
+    return 2 * rho() * std::asin( chord / ( 2 * rho() ) ) + slack;
+  }
+  return longest + slack;
+}
+
+double distance_lower_bound( const vposition& pos1, const vposition& pos2 ) {
+  double xyz1[3], xyz2[3];
+  to_ecef( pos1, xyz1 );
+  to_ecef( pos2, xyz2 );
+  return distance_lower_bound( chord( xyz1, xyz2 ) );
+}
+
+double distance_upper_bound( const vposition& pos1, const vposition& pos2 ) {
+  double xyz1[3], xyz2[3];
+  to_ecef( pos1, xyz1 );
+  to_ecef( pos2, xyz2 );
+  return distance_upper_bound( chord( xyz1, xyz2 ) );
+}
+
+bool within_distance( const vposition& pos1,
+                      const vposition& pos2,
+                      const double radius,
+                      const double accuracy ) {
+  double xyz1[3], xyz2[3];
+  to_ecef( pos1, xyz1 );
+  to_ecef( pos2, xyz2 );
+  const double c = chord( xyz1, xyz2 );
+  if ( c * c > outside_chord2(radius) ) {
+    return false;
+  }
+  if ( c * c < inside_chord2(radius) ) {
+    return true;
+  }
+  return inverse( pos1, pos2, accuracy ).distance <= radius;
+}
+
+size_t within_distance( const vposition& center,
+                        const double* lat,
+                        const double* lon,
+                        const double* x,
+                        const double* y,
+                        const double* z,
+                        const size_t n,
+                        const double radius,
+                        unsigned char* within,
+                        const double accuracy ) {
+  double xyz[3];
+  to_ecef( center, xyz );
+  kernels().chord_classify( xyz, x, y, z, n,
+                            inside_chord2(radius), outside_chord2(radius),
+                            within );
+
+  // The undecided ones, marked 2, are left to the inverse formula.
+  const prepared_position origin(center);
+  size_t count = 0;
+  for ( size_t i=0; i<n; ++i ) {
+    if ( within[i] == 2 ) {
+      within[i] = inverse( origin, vposition(lat[i],lon[i]), accuracy )
+          .distance <= radius;
+    }
+    count += within[i];
+  }
+  return count;
+}
+
+} // namespace end
@@ -0,0 +1,245 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "vincenty/geodesic_index.h"
+#include "vincenty/ecef.h"
+
+#include <algorithm>
+
+namespace
+{
+// Positions per leaf. The chord to each is a few multiplications, an inverse
+// formula is worth skipping even for small leaves.
+const size_t leaf_size = 16;
+
+// Orders position indexes along one axis of their coordinates.
+class along
+{
+ public:
+  along( const std::vector<double>& xyz, const int axis )
+      : _xyz(xyz), _axis(axis)
+  {
+  }
+
+  bool operator()( const size_t i, const size_t j ) const {
+    return _xyz[3*i+_axis] < _xyz[3*j+_axis];
+  }
+
+ private:
+  const std::vector<double>& _xyz;
+  int _axis;
+};
+} // namespace end
+
+namespace vincenty
+{
+
+// Neighbour
+// ------------------------------------------------------------------------
+
+//! Default constructor.
+neighbour::neighbour()
+    : index(0), distance(0)
+{
+}
+
+//! Constructor.
+neighbour::neighbour( size_t _index, double _distance )
+    : index(_index), distance(_distance)
+{
+}
+
+// Geodesic index
+// ------------------------------------------------------------------------
+
+//! Default constructor, an empty index.
+geodesic_index::geodesic_index()
+    : _accuracy(default_accuracy), _points(), _xyz(), _index(), _nodes()
+{
+}
+
+//! Constructor building the tree over the positions.
+geodesic_index::geodesic_index( const vposition_vector& positions,
+                                const double accuracy )
+    : _accuracy(accuracy), _points(), _xyz(3*positions.size()),
+      _index(positions.size()), _nodes()
+{
+  for ( size_t i=0; i<positions.size(); ++i ) {
+    to_ecef( positions[i], &_xyz[3*i] );
+    _index[i] = i;
+  }
+  if ( !positions.empty() ) {
+    _nodes.reserve( 2 * positions.size() / leaf_size + 1 );
+    _build( 0, positions.size() );
+  }
+
+  // The tree orders _index, the positions are put in the same order.
+  std::vector<double> xyz(_xyz.size());
+  _points.reserve(positions.size());
+  for ( size_t i=0; i<positions.size(); ++i ) {
+    _points.push_back( prepared_position(positions[_index[i]]) );
+    std::copy( &_xyz[3*_index[i]], &_xyz[3*_index[i]] + 3, &xyz[3*i] );
+  }
+  _xyz.swap(xyz);
+}
+
+// Builds the node of [begin,end) and those below it, returns its number.
+// The ball is centered on the bounding box, a leaf is split at the median of
+// the widest side of the box.
+size_t geodesic_index::_build( const size_t begin, const size_t end ) {
+  double lo[3] = {  HUGE_VAL,  HUGE_VAL,  HUGE_VAL };
+  double hi[3] = { -HUGE_VAL, -HUGE_VAL, -HUGE_VAL };
+  for ( size_t i=begin; i<end; ++i ) {
+    const double* p = &_xyz[3*_index[i]];
+    for ( int d=0; d<3; ++d ) {
+      lo[d] = std::min( lo[d], p[d] );
+      hi[d] = std::max( hi[d], p[d] );
+    }
+  }
+
+  node nd;
+  nd.radius = 0;
+  for ( int d=0; d<3; ++d ) {
+    nd.center[d] = ( lo[d] + hi[d] ) / 2;
+  }
+  for ( size_t i=begin; i<end; ++i ) {
+    nd.radius = std::max( nd.radius, chord( nd.center, &_xyz[3*_index[i]] ) );
+  }
+  nd.begin = begin;
+  nd.end   = end;
+  nd.left  = 0;
+  nd.right = 0;
+
+  const size_t n = _nodes.size();
+  _nodes.push_back(nd);
+  if ( end - begin > leaf_size ) {
+    int axis = 0;
+    for ( int d=1; d<3; ++d ) {
+      if ( hi[d] - lo[d] > hi[axis] - lo[axis] ) {
+        axis = d;
+      }
+    }
+    const size_t middle = begin + ( end - begin ) / 2;
+    std::nth_element( _index.begin() + begin, _index.begin() + middle,
+                      _index.begin() + end, along(_xyz,axis) );
+    const size_t left  = _build( begin, middle );
+    const size_t right = _build( middle, end );
+    _nodes[n].left  = left;
+    _nodes[n].right = right;
+  }
+  return n;
+}
+
+neighbour_vector geodesic_index::nearest( const vposition& pos,
+                                          const size_t k ) const {
+  neighbour_vector heap;
+  if ( k > 0 && !_nodes.empty() ) {
+    double xyz[3];
+    to_ecef( pos, xyz );
+    heap.reserve( std::min( k, size() ) );
+    _nearest( 0, prepared_position(pos), xyz, k, heap );
+    std::sort_heap( heap.begin(), heap.end() );
+  }
+  return heap;
+}
+
+// The heap holds the best k so far, the farthest on top.
+void geodesic_index::_nearest( const size_t n,
+                               const prepared_position& pos,
+                               const double* xyz,
+                               const size_t k,
+                               neighbour_vector& heap ) const {
+  const node& nd = _nodes[n];
+  const bool full = heap.size() == k;
+  if ( full && distance_lower_bound( chord( xyz, nd.center ) - nd.radius ) >
+      heap.front().distance ) {
+    return;
+  }
+
+  if ( nd.left == 0 ) {
+    for ( size_t i=nd.begin; i<nd.end; ++i ) {
+      if ( heap.size() == k &&
+           distance_lower_bound( chord( xyz, &_xyz[3*i] ) ) >
+           heap.front().distance ) {
+        continue;
+      }
+      const neighbour found( _index[i],
+                             inverse( pos, _points[i], _accuracy ).distance );
+      if ( heap.size() < k ) {
+        heap.push_back(found);
+        std::push_heap( heap.begin(), heap.end() );
+      } else if ( found < heap.front() ) {
+        std::pop_heap( heap.begin(), heap.end() );
+        heap.back() = found;
+        std::push_heap( heap.begin(), heap.end() );
+      }
+    }
+    return;
+  }
+
+  // The nearer child first, it shrinks the bound for the other one.
+  if ( chord( xyz, _nodes[nd.left].center ) <=
+       chord( xyz, _nodes[nd.right].center ) ) {
+    _nearest( nd.left,  pos, xyz, k, heap );
+    _nearest( nd.right, pos, xyz, k, heap );
+  } else {
+    _nearest( nd.right, pos, xyz, k, heap );
+    _nearest( nd.left,  pos, xyz, k, heap );
+  }
+}
+
+neighbour_vector geodesic_index::within( const vposition& pos,
+                                         const double radius ) const {
+  neighbour_vector found;
+  if ( !_nodes.empty() ) {
+    double xyz[3];
+    to_ecef( pos, xyz );
+    _within( 0, prepared_position(pos), xyz, radius, found );
+    std::sort( found.begin(), found.end() );
+  }
+  return found;
+}
+
+void geodesic_index::_within( const size_t n,
+                              const prepared_position& pos,
+                              const double* xyz,
+                              const double radius,
+                              neighbour_vector& found ) const {
+  const node& nd = _nodes[n];
+  if ( distance_lower_bound( chord( xyz, nd.center ) - nd.radius ) > radius ) {
+    return;
+  }
+  if ( nd.left == 0 ) {
+    for ( size_t i=nd.begin; i<nd.end; ++i ) {
+      if ( distance_lower_bound( chord( xyz, &_xyz[3*i] ) ) > radius ) {
+        continue;
+      }
+      const double s = inverse( pos, _points[i], _accuracy ).distance;
+      if ( s <= radius ) {
+        found.push_back( neighbour(_index[i],s) );
+      }
+    }
+    return;
+  }
+  _within( nd.left,  pos, xyz, radius, found );
+  _within( nd.right, pos, xyz, radius, found );
+}
+
+} // namespace end
@@ -0,0 +1,87 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+#include "vincenty/geodesic_line.h"
+#include "vincenty_dispatch.h"
+#include "vincenty_metrics.h"
+
+namespace vincenty
+{
+
+geodesic_line::geodesic_line( const double lat,
+                              const double lon,
+                              const double bearing,
+                              const double accuracy )
+    : _state(),
+      _bearing(bearing),
+      _accuracy(accuracy)
+{
+  kernels().line_setup(lat,lon,bearing,&_state);
+}
+
+geodesic_line::geodesic_line( const vposition& origin,
+                              const double bearing,
+                              const double accuracy )
+    : _state(),
+      _bearing(bearing),
+      _accuracy(accuracy)
+{
+  kernels().line_setup(origin.coords.a[0],origin.coords.a[1],bearing,&_state);
+}
+
+vposition
+geodesic_line::position( const double distance ) const {
+  VINCENTY_COUNT(direct_calls,1);
+  return kernels().line_position(_state,distance,_accuracy);
+}
+
+void
+geodesic_line::positions( const double* distance,
+                          double* lat,
+                          double* lon,
+                          const size_t n ) const {
+  VINCENTY_COUNT(direct_calls,n);
+  kernels().line_positions(_state,distance,lat,lon,n,_accuracy);
+}
+
+vposition_vector
+geodesic_line::positions( const std::vector<double>& distances ) const {
+  const size_t n = distances.size();
+  std::vector<double> lat(n), lon(n);
+  vposition_vector dest(n);
+  if ( n > 0 ) {
+    positions(&distances[0],&lat[0],&lon[0],n);
+  }
+  for ( size_t i=0; i<n; ++i ) {
+    dest[i] = vposition(lat[i],lon[i]);
+  }
+  return dest;
+}
+
+vposition
+geodesic_line::origin() const {
+  return vposition(_state.lat,_state.lon);
+}
+
+double
+geodesic_line::bearing() const {
+  return _bearing;
+}
+
+} // namespace end
@@ -0,0 +1,171 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "vincenty/metrics.h"
+#include "vincenty_metrics.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include <pthread.h>
+
+__thread metric_counters* thread_metrics = 0;
+
+#pragma GCC visibility push(hidden)
+namespace {
+
+// The counters of the live threads, and the sum of those which have exited.
+pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+metric_counters* registry = 0;
+metric_counters retired;
+
+pthread_once_t key_once = PTHREAD_ONCE_INIT;
+pthread_key_t key;
+
+void
+accumulate( vincenty::metrics_snapshot& m, const metric_counters& c ) {
+  m.direct_calls   += __atomic_load_n( &c.direct_calls,   __ATOMIC_RELAXED );
+  m.inverse_calls  += __atomic_load_n( &c.inverse_calls,  __ATOMIC_RELAXED );
+  m.iterations     += __atomic_load_n( &c.iterations,     __ATOMIC_RELAXED );
+  m.not_converged  += __atomic_load_n( &c.not_converged,  __ATOMIC_RELAXED );
+  m.grid_splits    += __atomic_load_n( &c.grid_splits,    __ATOMIC_RELAXED );
+  m.grid_positions += __atomic_load_n( &c.grid_positions, __ATOMIC_RELAXED );
+  m.grid_lookups   += __atomic_load_n( &c.grid_lookups,   __ATOMIC_RELAXED );
+}
+
+// Thread exit, move the counts to retired and drop the counters.
+void
+retire( void* p ) {
+  metric_counters* c = static_cast<metric_counters*>(p);
+  pthread_mutex_lock( &registry_lock );
+  retired.direct_calls   += c->direct_calls;
+  retired.inverse_calls  += c->inverse_calls;
+  retired.iterations     += c->iterations;
+  retired.not_converged  += c->not_converged;
+  retired.grid_splits    += c->grid_splits;
+  retired.grid_positions += c->grid_positions;
+  retired.grid_lookups   += c->grid_lookups;
+  metric_counters** it = &registry;
+  while ( *it != c ) {
+    it = &(*it)->next;
+  }
+  *it = c->next;
+  pthread_mutex_unlock( &registry_lock );
+  thread_metrics = 0;
+  delete c;
+}
+
+void
+create_key() {
+  pthread_key_create( &key, &retire );
+}
+
+void
+write_counter( std::ostream& os,
+               const char* name,
+               const char* help,
+               const uint64_t value ) {
+  os << "# HELP vincenty_" << name << "_total " << help << "\n"
+     << "# TYPE vincenty_" << name << "_total counter\n"
+     << "vincenty_" << name << "_total " << value << "\n";
+}
+
+} // namespace end
+
+metric_counters*
+register_metrics() {
+  pthread_once( &key_once, &create_key );
+  metric_counters* c = new metric_counters();
+  pthread_mutex_lock( &registry_lock );
+  c->next  = registry;
+  registry = c;
+  pthread_mutex_unlock( &registry_lock );
+  pthread_setspecific( key, c );
+  thread_metrics = c;
+  return c;
+}
+#pragma GCC visibility pop
+
+
+namespace vincenty
+{
+metrics_snapshot::metrics_snapshot()
+    : direct_calls(0),
+      inverse_calls(0),
+      iterations(0),
+      not_converged(0),
+      grid_splits(0),
+      grid_positions(0),
+      grid_lookups(0)
+{
+}
+
+metrics_snapshot metrics() {
+  metrics_snapshot m;
+  pthread_mutex_lock( &registry_lock );
+  accumulate( m, retired );
+  for ( const metric_counters* c = registry; c; c = c->next ) {
+    accumulate( m, *c );
+  }
+  pthread_mutex_unlock( &registry_lock );
+  return m;
+}
+
+std::ostream& write_prometheus( std::ostream& os, const metrics_snapshot& m ) {
+  write_counter( os, "direct_calls",
+                 "Direct problems solved.", m.direct_calls );
+  write_counter( os, "inverse_calls",
+                 "Inverse problems solved.", m.inverse_calls );
+  write_counter( os, "iterations",
+                 "Iterations used by direct and inverse problems.",
+                 m.iterations );
+  write_counter( os, "not_converged",
+                 "Problems which stopped at the iteration limit.",
+                 m.not_converged );
+  write_counter( os, "grid_splits",
+                 "Coordinate grid splits.", m.grid_splits );
+  write_counter( os, "grid_positions",
+                 "Positions computed by coordinate grid splits.",
+                 m.grid_positions );
+  write_counter( os, "grid_lookups",
+                 "Coordinate grid positions interpolated.", m.grid_lookups );
+  return os;
+}
+
+bool write_prometheus( const std::string& path, const metrics_snapshot& m ) {
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream os( tmp.c_str() );
+    write_prometheus( os, m );
+    os.close();
+    if ( !os ) {
+      std::remove( tmp.c_str() );
+      return false;
+    }
+  }
+  if ( std::rename( tmp.c_str(), path.c_str() ) != 0 ) {
+    std::remove( tmp.c_str() );
+    return false;
+  }
+  return true;
+}
+
+} // namespace end
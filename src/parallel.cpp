@@ -0,0 +1,448 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "vincenty/parallel.h"
+#include "vincenty_parallel.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <unistd.h>
+
+// The work stealing pool
+// ------------------------------------------------------------------------
+#pragma GCC visibility push(hidden)
+namespace {
+
+// The chunks left to a worker, begin in the low and end in the high half.
+// The owner takes chunks from the front and the thieves from the back, both
+// with a compare and swap. Begin only grows and end only shrinks, so there
+// is no ABA problem. Padded to a cache line of its own.
+struct share
+{
+  uint64_t range;
+  char padding[64 - sizeof(uint64_t)];
+};
+
+inline uint64_t
+pack( const uint64_t begin, const uint64_t end ) {
+  return ( end << 32 ) | begin;
+}
+
+bool
+take_front( share& s, size_t* chunk ) {
+  uint64_t old = __atomic_load_n( &s.range, __ATOMIC_ACQUIRE );
+  for (;;) {
+    const uint64_t begin = old & 0xffffffff;
+    const uint64_t end   = old >> 32;
+    if ( begin >= end ) {
+      return false;
+    }
+    if ( __atomic_compare_exchange_n( &s.range, &old, pack(begin+1,end), true,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) ) {
+      *chunk = begin;
+      return true;
+    }
+  }
+}
+
+bool
+take_back( share& s, size_t* chunk ) {
+  uint64_t old = __atomic_load_n( &s.range, __ATOMIC_ACQUIRE );
+  for (;;) {
+    const uint64_t begin = old & 0xffffffff;
+    const uint64_t end   = old >> 32;
+    if ( begin >= end ) {
+      return false;
+    }
+    if ( __atomic_compare_exchange_n( &s.range, &old, pack(begin,end-1), true,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) ) {
+      *chunk = end - 1;
+      return true;
+    }
+  }
+}
+
+struct job
+{
+  parallel_task task;
+  void* context;
+  size_t n;
+  size_t chunk;
+  unsigned int workers;
+  share* shares;
+};
+
+void
+run_chunk( const job& j, const size_t chunk ) {
+  const size_t begin = chunk * j.chunk;
+  j.task( j.context, begin, std::min( j.n, begin + j.chunk ) );
+}
+
+// Own chunks first, then steal from the others until all are empty.
+void
+work( const job& j, const unsigned int me ) {
+  size_t chunk;
+  for (;;) {
+    while ( take_front( j.shares[me], &chunk ) ) {
+      run_chunk( j, chunk );
+    }
+    bool stolen = false;
+    for ( unsigned int k=1; k<j.workers && !stolen; ++k ) {
+      if ( take_back( j.shares[(me+k) % j.workers], &chunk ) ) {
+        run_chunk( j, chunk );
+        stolen = true;
+      }
+    }
+    if ( !stolen ) {
+      return;
+    }
+  }
+}
+
+// Held by the thread running a job on the pool.
+pthread_mutex_t busy = PTHREAD_MUTEX_INITIALIZER;
+
+// Protects the pool state below.
+pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  wake = PTHREAD_COND_INITIALIZER;
+pthread_cond_t  done = PTHREAD_COND_INITIALIZER;
+const job*      current    = 0;
+uint64_t        generation = 0;
+unsigned int    started    = 0;
+unsigned int    pending    = 0;
+
+struct thread_start
+{
+  unsigned int id;
+  uint64_t generation;
+};
+
+// Pool thread id, 1 and up, the caller of a job is worker 0.
+void*
+pool_thread( void* arg ) {
+  const thread_start start = *static_cast<thread_start*>(arg);
+  delete static_cast<thread_start*>(arg);
+
+  uint64_t seen = start.generation;
+  pthread_mutex_lock( &lock );
+  for (;;) {
+    while ( generation == seen ) {
+      pthread_cond_wait( &wake, &lock );
+    }
+    seen = generation;
+    const job* j = current;
+    if ( j && start.id < j->workers ) {
+      pthread_mutex_unlock( &lock );
+      work( *j, start.id );
+      pthread_mutex_lock( &lock );
+      if ( --pending == 0 ) {
+        pthread_cond_signal( &done );
+      }
+    }
+  }
+  return 0;
+}
+
+// A forked child has none of the pool threads, only the state they left.
+// The lock is held over the fork so that state is consistent, the child
+// then starts over with an empty pool and fresh mutexes and conditions.
+void
+fork_prepare() {
+  pthread_mutex_lock( &lock );
+}
+
+void
+fork_parent() {
+  pthread_mutex_unlock( &lock );
+}
+
+void
+fork_child() {
+  pthread_mutex_init( &busy, 0 );
+  pthread_mutex_init( &lock, 0 );
+  pthread_cond_init( &wake, 0 );
+  pthread_cond_init( &done, 0 );
+  current    = 0;
+  generation = 0;
+  started    = 0;
+  pending    = 0;
+}
+
+bool fork_handled = false;
+
+// Called with lock held. Returns the number of pool threads running, which
+// is less than wanted if no more could be created.
+unsigned int
+start_threads( const unsigned int wanted ) {
+  if ( !fork_handled && started < wanted ) {
+    fork_handled =
+        pthread_atfork( &fork_prepare, &fork_parent, &fork_child ) == 0;
+    if ( !fork_handled ) {
+      return started;
+    }
+  }
+  while ( started < wanted ) {
+    thread_start* start = new thread_start;
+    start->id         = started + 1;
+    start->generation = generation;
+    pthread_t thread;
+    if ( pthread_create( &thread, 0, &pool_thread, start ) != 0 ) {
+      delete start;
+      break;
+    }
+    pthread_detach( thread );
+    ++started;
+  }
+  return started;
+}
+
+} // namespace end
+
+void
+parallel_for( const size_t n,
+              const size_t chunk,
+              const unsigned int threads,
+              parallel_task task,
+              void* context ) {
+  if ( n == 0 ) {
+    return;
+  }
+  // The chunk indexes must fit in the halves of a share.
+  const size_t size   = std::max( chunk, n / 0xffffffff + 1 );
+  const size_t chunks = ( n + size - 1 ) / size;
+
+  const unsigned int wanted =
+      threads ? threads : vincenty::parallel::default_threads();
+  unsigned int workers =
+      static_cast<unsigned int>( std::min( size_t(wanted), chunks ) );
+  if ( workers <= 1 || pthread_mutex_trylock( &busy ) != 0 ) {
+    task( context, 0, n );
+    return;
+  }
+
+  pthread_mutex_lock( &lock );
+  workers = std::min( workers, start_threads( workers - 1 ) + 1 );
+
+  std::vector<share> shares( workers );
+  for ( unsigned int w=0; w<workers; ++w ) {
+    shares[w].range = pack( chunks * w / workers, chunks * (w+1) / workers );
+  }
+  const job j = { task, context, n, size, workers, &shares[0] };
+  current = &j;
+  pending = workers - 1;
+  ++generation;
+  pthread_cond_broadcast( &wake );
+  pthread_mutex_unlock( &lock );
+
+  work( j, 0 );
+
+  pthread_mutex_lock( &lock );
+  while ( pending > 0 ) {
+    pthread_cond_wait( &done, &lock );
+  }
+  current = 0;
+  pthread_mutex_unlock( &lock );
+  pthread_mutex_unlock( &busy );
+}
+#pragma GCC visibility pop
+
+
+// Tasks of the public functions
+// ------------------------------------------------------------------------
+namespace {
+
+// Elements per chunk. The seven arrays of a 2048 pair inverse chunk take
+// 112 kB, within the L2 cache of any recent x86.
+const size_t chunk_size = 2048;
+
+struct inverse_context
+{
+  const double* lat1;
+  const double* lon1;
+  const double* lat2;
+  const double* lon2;
+  double* bearing1;
+  double* distance;
+  double* bearing2;
+  double accuracy;
+};
+
+// Output arrays may be null, they are then offset from null and never
+// written by the batch functions.
+template <typename T> inline T*
+offset( T* p, const size_t i ) {
+  return p ? p + i : 0;
+}
+
+void
+inverse_task( void* context, const size_t begin, const size_t end ) {
+  const inverse_context& c = *static_cast<inverse_context*>(context);
+  vincenty::inverse_batch( c.lat1 + begin, c.lon1 + begin,
+                           c.lat2 + begin, c.lon2 + begin,
+                           offset(c.bearing1,begin),
+                           offset(c.distance,begin),
+                           offset(c.bearing2,begin),
+                           end - begin, c.accuracy );
+}
+
+struct direct_context
+{
+  const double* lat;
+  const double* lon;
+  const double* bearing;
+  const double* distance;
+  double* lat2;
+  double* lon2;
+  double accuracy;
+};
+
+void
+direct_task( void* context, const size_t begin, const size_t end ) {
+  const direct_context& c = *static_cast<direct_context*>(context);
+  vincenty::direct_batch( c.lat + begin, c.lon + begin,
+                          c.bearing + begin, c.distance + begin,
+                          c.lat2 + begin, c.lon2 + begin,
+                          end - begin, c.accuracy );
+}
+
+struct one_to_many_context
+{
+  vincenty::prepared_position origin;
+  const vincenty::vposition* targets;
+  vincenty::vdirection* dirs;
+  double* distance;
+  double accuracy;
+};
+
+void
+one_to_many_task( void* context, const size_t begin, const size_t end ) {
+  const one_to_many_context& c = *static_cast<one_to_many_context*>(context);
+  if ( c.dirs ) {
+    vincenty::inverse_one_to_many( c.origin, c.targets + begin,
+                                   c.dirs + begin, end - begin, c.accuracy );
+  } else {
+    vincenty::inverse_one_to_many( c.origin, c.targets + begin,
+                                   c.distance + begin, end - begin,
+                                   c.accuracy );
+  }
+}
+
+struct pairwise_context
+{
+  const vincenty::vposition* from;
+  const vincenty::vposition* to;
+  size_t n;
+  double* distance;
+  double accuracy;
+};
+
+// The elements are those of the m*n output, a chunk may span rows.
+void
+pairwise_task( void* context, const size_t begin, const size_t end ) {
+  const pairwise_context& c = *static_cast<pairwise_context*>(context);
+  for ( size_t k=begin; k<end; ) {
+    const size_t i   = k / c.n;
+    const size_t j   = k % c.n;
+    const size_t len = std::min( end - k, c.n - j );
+    vincenty::inverse_one_to_many( vincenty::prepared_position(c.from[i]),
+                                   c.to + j, c.distance + k, len, c.accuracy );
+    k += len;
+  }
+}
+
+} // namespace end
+
+
+namespace vincenty
+{
+namespace parallel
+{
+
+unsigned int default_threads() {
+  const long n = sysconf( _SC_NPROCESSORS_ONLN );
+  return n > 0 ? static_cast<unsigned int>(n) : 1;
+}
+
+void inverse( const double* lat1,
+              const double* lon1,
+              const double* lat2,
+              const double* lon2,
+              double* bearing1,
+              double* distance,
+              double* bearing2,
+              const size_t n,
+              const unsigned int threads,
+              const double accuracy ) {
+  inverse_context c = { lat1, lon1, lat2, lon2,
+                        bearing1, distance, bearing2, accuracy };
+  parallel_for( n, chunk_size, threads, &inverse_task, &c );
+}
+
+void direct( const double* lat,
+             const double* lon,
+             const double* bearing,
+             const double* distance,
+             double* lat2,
+             double* lon2,
+             const size_t n,
+             const unsigned int threads,
+             const double accuracy ) {
+  direct_context c = { lat, lon, bearing, distance, lat2, lon2, accuracy };
+  parallel_for( n, chunk_size, threads, &direct_task, &c );
+}
+
+void inverse_one_to_many( const vposition& origin,
+                          const vposition* targets,
+                          vdirection* dirs,
+                          const size_t n,
+                          const unsigned int threads,
+                          const double accuracy ) {
+  one_to_many_context c = { prepared_position(origin), targets,
+                            dirs, 0, accuracy };
+  parallel_for( n, chunk_size, threads, &one_to_many_task, &c );
+}
+
+void inverse_one_to_many( const vposition& origin,
+                          const vposition* targets,
+                          double* distance,
+                          const size_t n,
+                          const unsigned int threads,
+                          const double accuracy ) {
+  one_to_many_context c = { prepared_position(origin), targets,
+                            0, distance, accuracy };
+  parallel_for( n, chunk_size, threads, &one_to_many_task, &c );
+}
+
+void inverse_pairwise( const vposition* from,
+                       const size_t m,
+                       const vposition* to,
+                       const size_t n,
+                       double* distance,
+                       const unsigned int threads,
+                       const double accuracy ) {
+  pairwise_context c = { from, to, n, distance, accuracy };
+  parallel_for( m*n, chunk_size, threads, &pairwise_task, &c );
+}
+
+} // namespace parallel
+} // namespace end
@@ -19,6 +19,8 @@
 */
 
 #include "vincenty/vincenty.h"
+#include "vincenty_dispatch.h"
+#include "vincenty_metrics.h"
 
 #include <cstdlib>
 #include <iostream>
@@ -26,51 +28,10 @@
 #include <map>
 #include <string>
 
-// This shit shall not be visible outside the library, hide all symbols.
-#pragma GCC visibility push(hidden)
-const double a  = 6378137.0000;
-const double b  = 6356752.3142;
-const double f  = (a-b)/a;
-const double _f = ((a*a) / (b*b)) - 1;
-
-double A_full_precision( const double ) __attribute__ ((pure));
-double B_full_precision( const double ) __attribute__ ((pure));
-
-double deltasigma_full_precision(
-    const double,
-    const double,
-    const double,
-    const double ) __attribute__ ((pure));
-
-inline void __asm_sincos(const double a, double *sina, double *cosa) {
-  asm ("fsincos;" : "=t" (*cosa), "=u" (*sina) : "0" (a));
-}
-inline double __asm_atan2(double y, double x) {
-  asm ("fpatan;" : "=t" (x) : "0" (x), "u" (y) : "st(1)");
-  return x;
-}
-inline double __asm_sin(double a) {
-  asm ("fsin;" : "=t" (a) : "0" (a));
-  return a;
-}
-inline double __asm_cos(double a) {
-  asm ("fcos;" : "=t" (a) : "0" (a));
-  return a;
-}
-inline double __asm_fabs(double a) {
-  asm ("fabs;" : "=t" (a) : "0" (a));
-  return a;
-}
-#pragma GCC visibility pop
-
-#define sincos(a,b,c) __asm_sincos(a,b,c)
-#define atan2(a,b) __asm_atan2(a,b)
-#define sqrt(a) __builtin_sqrt(a)
-#define fabs(a) __builtin_fabs(a)
-
-// Sin and cos makes inverse() slower ... ?
-//#define sin(a) __asm_sin(a)
-//#define cos(a) __asm_cos(a)
+// The formulas are implemented in vincenty_kernels.h, compiled once per
+// instruction set. The functions here calls the copy selected at load time.
+// Unless the metrics are compiled out, direct() and inverse() solve through
+// the variants reporting the iterations, which are then counted.
 
 namespace vincenty
 {
@@ -81,76 +42,29 @@ vposition direct( const double lat,
                   const double alpha1,
                   const double s,
                   const double accuracy ) {
-  // If equal return immediately.
-  if ( ulpcmp_inline(0,s) ) {
-    return vposition(lat,lon);
-  }
-  const double tan_U1     = (1-f) * tan(lat);
-  const double cos_U1     = 1 / sqrt( (1 + tan_U1 * tan_U1) );
-  const double sin_U1     = tan_U1 * cos_U1;
-
-  double cos_alpha1;
-  double sin_alpha1;
-  sincos(alpha1,&sin_alpha1,&cos_alpha1);
-
-  const double sigma1     = atan2( tan_U1, cos_alpha1 );
-  const double sin_alpha  = cos_U1 * sin_alpha1;
-  const double cos2_alpha = 1 - sin_alpha*sin_alpha;
-  const double u2         = cos2_alpha * _f;
-
-  const double A          = A_full_precision(u2);
-  const double B          = B_full_precision(u2);
-
-  double sigma            = s / ( b * A );
-
-  double _sigma;
-  double sin_sigma;
-  double cos_sigma;
-  double cos_2sigmam;
-
-  // Prevent loop deadlock. Average loop count is 2-4 before accuracy is
-  // reached. Vincentys algorithm converges fast.
-  unsigned int i = 6;
-  do {
-    sincos(sigma,&sin_sigma,&cos_sigma);
-
-    cos_2sigmam = cos( 2*sigma1 + sigma );
-
-    const double delta_sigma = 
-        deltasigma_full_precision(B,sin_sigma,cos_sigma,cos_2sigmam);
-
-    _sigma = sigma;
-    sigma = s / (b*A) + delta_sigma;
-  } while ( fabs(sigma-_sigma) > accuracy && --i );
-
-  const double C = f/16*cos2_alpha * ( 4 + f*(4-3*cos2_alpha) );
+#ifdef VINCENTY_NO_METRICS
+  return kernels().direct(lat,lon,alpha1,s,accuracy);
+#else
+  convergence info;
+  return direct(lat,lon,alpha1,s,accuracy,&info);
+#endif
+}
 
-  const double lambda = 
-      atan2( sin_sigma*sin_alpha1,
-                       cos_U1*cos_sigma - sin_U1*sin_sigma*cos_alpha1 );
-   
-  const double L = 
-      lambda - 
-      (1-C)*f*sin_alpha * 
-      ( sigma + 
-        C*sin_sigma * ( cos_2sigmam +
-                        C*cos_sigma * ( -1 +
-                                        2*cos_2sigmam*cos_2sigmam) ) );
-   
-  const double tmp =  sin_U1*sin_sigma - cos_U1*cos_sigma*cos_alpha1;
-   
-  const double lat2 = 
-      atan2( sin_U1*cos_sigma + cos_U1*sin_sigma*cos_alpha1, 
-                       (1-f)*sqrt( sin_alpha*sin_alpha + tmp*tmp ) );
-  
-  /*
-    Skip computing the reversed bearing, the returned position does not have a
-    member to return the value. The implementation of how the bearing is
-    computed is keept as reference.
-  */
-  //const double bearing_reversed = atan2(-sin_alpha, tmp);
-   
-  return vposition(lat2, lon+L);
+vposition direct( const double lat,
+                  const double lon,
+                  const double alpha1,
+                  const double s,
+                  const double accuracy,
+                  convergence* info ) {
+  convergence local;
+  if ( !info ) {
+    info = &local;
+  }
+  const vposition pos =
+      kernels().direct_convergence(lat,lon,alpha1,s,accuracy,info);
+  VINCENTY_COUNT(direct_calls,1);
+  VINCENTY_COUNT_ITERATIONS(*info);
+  return pos;
 }
 
 vposition direct( const vposition& pos,
@@ -182,91 +96,46 @@ vdirection inverse( const double lat1,
                     const double lat2,
                     const double lon2,
                     const double accuracy ) {
-  // If equal return immediately.
-  if ( ulpcmp_inline(lat1,lat2) &&
-       ulpcmp_inline(lon1,lon2) ) {
-    return vdirection(0.0,0.0,0.0);
-  }
-#define U1 atan( (1-f) * tan(lat1) )
-#define U2 atan( (1-f) * tan(lat2) )
-  const double sin_U1 = sin(U1);
-  const double cos_U1 = cos(U1);
-  const double sin_U2 = sin(U2);
-  const double cos_U2 = cos(U2);
-#undef U1
-#undef U2
-  const double L = lon2-lon1;
-  double lambda  = L;
-
-  double sin_lambda;
-  double cos_lambda;
-
-  double sin_sigma;
-  double cos_sigma;
-
-  double cos2_alpha;
-  double cos_2sigmam;
-  double sigma;
-  double _lambda;
-
-  // Prevent loop deadlock. Average loop count is 2-4 before accuracy is
-  // reached. Vincentys algorithm converges fast.
-  unsigned int i = 8;
-  do {
-    sincos(lambda,&sin_lambda,&cos_lambda);
-    
-    // pow() might be tempting but is slower!
-    sin_sigma = sqrt( cos_U2*sin_lambda * cos_U2*sin_lambda + 
-                      (cos_U1*sin_U2 - sin_U1*cos_U2*cos_lambda) *
-                      (cos_U1*sin_U2 - sin_U1*cos_U2*cos_lambda) );
-
-    cos_sigma = sin_U1*sin_U2 + cos_U1*cos_U2*cos_lambda;
-
-    sigma = atan2( sin_sigma, cos_sigma );
-
-    const double sin_alpha = cos_U1*cos_U2*sin_lambda/sin_sigma;
-
-    cos2_alpha = 1 - sin_alpha * sin_alpha;
-
-    _lambda = lambda;
-     
-    if ( ulpcmp_inline(cos2_alpha,0.0,16) ) {
-      cos_2sigmam = 0;
-      lambda = L + f * sin_alpha * sigma;
-    } else {
-      cos_2sigmam = cos_sigma - 2*sin_U1*sin_U2/cos2_alpha;
-      const double C = f/16 * cos2_alpha * ( 4 + f * (4 - 3*cos2_alpha) );
-      lambda = 
-          L + (1-C) * f * sin_alpha * 
-          ( sigma + C * sin_sigma * 
-            ( cos_2sigmam + C * cos_sigma * 
-              ( -1 + 2 * cos_2sigmam*cos_2sigmam ) ) );
-    }
-  } while ( fabs(lambda-_lambda) > accuracy && --i );
-  
-  const double u2 = cos2_alpha * _f;
-
-  const double delta_sigma = deltasigma_full_precision( B_full_precision(u2),
-                                                        sin_sigma,
-                                                        cos_sigma,
-                                                        cos_2sigmam );
-  
-  double p1p2 = atan2( cos_U2*sin_lambda,
-                                 cos_U1*sin_U2 - sin_U1*cos_U2*cos_lambda );
-
-  if ( p1p2 < 0 ) {
-    p1p2 = p1p2 + 2*M_PI;
+#ifdef VINCENTY_NO_METRICS
+  return kernels().inverse(lat1,lon1,lat2,lon2,accuracy);
+#else
+  convergence info;
+  return inverse(lat1,lon1,lat2,lon2,accuracy,&info);
+#endif
+}
+
+vdirection inverse( const double lat1,
+                    const double lon1,
+                    const double lat2,
+                    const double lon2,
+                    const double accuracy,
+                    inverse_status* status ) {
+  inverse_status local;
+  if ( !status ) {
+    status = &local;
   }
+  const vdirection dir =
+      kernels().inverse_status(lat1,lon1,lat2,lon2,accuracy,status);
+  VINCENTY_COUNT(inverse_calls,1);
+  VINCENTY_COUNT(not_converged,*status!=inverse_converged);
+  return dir;
+}
 
-  double p2p1 = atan2( cos_U1*sin_lambda,
-                                 -sin_U1*cos_U2 + cos_U1*sin_U2*cos_lambda ) 
-      // Scary, but the reverse bearing needs a "180 degree turn". At least to
-      // be correct with the intervall [0,2*M_PI].
-      + M_PI;
-  
-  const double s = b * A_full_precision(u2) * ( sigma - delta_sigma );
-  
-  return vdirection(p1p2,s,p2p1);
+vdirection inverse( const double lat1,
+                    const double lon1,
+                    const double lat2,
+                    const double lon2,
+                    const double accuracy,
+                    convergence* info ) {
+  convergence local;
+  if ( !info ) {
+    info = &local;
+  }
+  const vdirection dir =
+      kernels().inverse_convergence(lat1,lon1,lat2,lon2,accuracy,info);
+  VINCENTY_COUNT(inverse_calls,1);
+  VINCENTY_COUNT_ITERATIONS(*info);
+  return dir;
 }
 
 vdirection inverse( const vposition& pos1,
@@ -279,6 +148,125 @@ vdirection inverse( const vposition& pos1,
                   accuracy );
 }
 
+vposition direct( const ellipsoid& e,
+                  const double lat,
+                  const double lon,
+                  const double bearing,
+                  const double distance,
+                  const double accuracy ) {
+  VINCENTY_COUNT(direct_calls,1);
+  return kernels().direct_ellipsoid(e,lat,lon,bearing,distance,accuracy);
+}
+
+vdirection inverse( const ellipsoid& e,
+                    const double lat1,
+                    const double lon1,
+                    const double lat2,
+                    const double lon2,
+                    const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,1);
+  return kernels().inverse_ellipsoid(e,lat1,lon1,lat2,lon2,accuracy);
+}
+
+template <> vposition
+direct<grs80>( const double lat,
+               const double lon,
+               const double bearing,
+               const double distance,
+               const double accuracy ) {
+  VINCENTY_COUNT(direct_calls,1);
+  return traits_kernels<grs80>().direct(grs80(),lat,lon,bearing,distance,
+                                        accuracy);
+}
+
+template <> vposition
+direct<bessel1841>( const double lat,
+                    const double lon,
+                    const double bearing,
+                    const double distance,
+                    const double accuracy ) {
+  VINCENTY_COUNT(direct_calls,1);
+  return traits_kernels<bessel1841>().direct(bessel1841(),lat,lon,bearing,
+                                             distance,accuracy);
+}
+
+template <> vdirection
+inverse<grs80>( const double lat1,
+                const double lon1,
+                const double lat2,
+                const double lon2,
+                const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,1);
+  return traits_kernels<grs80>().inverse(grs80(),lat1,lon1,lat2,lon2,
+                                         accuracy);
+}
+
+template <> vdirection
+inverse<bessel1841>( const double lat1,
+                     const double lon1,
+                     const double lat2,
+                     const double lon2,
+                     const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,1);
+  return traits_kernels<bessel1841>().inverse(bessel1841(),lat1,lon1,lat2,lon2,
+                                              accuracy);
+}
+
+vdirection inverse( const prepared_position& pos1,
+                    const prepared_position& pos2,
+                    const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,1);
+  return kernels().inverse_prepared(pos1,pos2,accuracy);
+}
+
+vdirection inverse( const prepared_position& pos1,
+                    const vposition& pos2,
+                    const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,1);
+  return kernels().inverse_prepared(pos1,prepared_position(pos2),accuracy);
+}
+
+
+// Fixed iteration formulas
+// ------------------------------------------------------------------------
+template <unsigned int N> vdirection inverse_fixed( const double lat1,
+                                                   const double lon1,
+                                                   const double lat2,
+                                                   const double lon2 ) {
+  VINCENTY_COUNT(inverse_calls,1);
+  return kernels().inverse_fixed[N](lat1,lon1,lat2,lon2);
+}
+
+template vdirection inverse_fixed<1>( double, double, double, double );
+template vdirection inverse_fixed<2>( double, double, double, double );
+template vdirection inverse_fixed<3>( double, double, double, double );
+template vdirection inverse_fixed<4>( double, double, double, double );
+template vdirection inverse_fixed<5>( double, double, double, double );
+template vdirection inverse_fixed<6>( double, double, double, double );
+template vdirection inverse_fixed<7>( double, double, double, double );
+template vdirection inverse_fixed<8>( double, double, double, double );
+
+
+// Single precision formulas
+// ------------------------------------------------------------------------
+vposition directf( const float lat,
+                   const float lon,
+                   const float bearing,
+                   const float distance,
+                   const float accuracy ) {
+  VINCENTY_COUNT(direct_calls,1);
+  return kernels().directf(lat,lon,bearing,distance,accuracy);
+}
+
+vdirection inversef( const float lat1,
+                     const float lon1,
+                     const float lat2,
+                     const float lon2,
+                     const float accuracy ) {
+  VINCENTY_COUNT(inverse_calls,1);
+  return kernels().inversef(lat1,lon1,lat2,lon2,accuracy);
+}
+
 
 // Simple functions.
 // ------------------------------------------------------------------------
@@ -286,31 +274,53 @@ vdirection inverse( const vposition& pos1,
 // Distance
 double get_distance( const vposition& pos1,
                      const vposition& pos2 ) {
-  const vdirection foo = inverse( pos1, pos2 );
-  return foo.distance;
+  return get_distance( pos1.coords.a[0], pos1.coords.a[1],
+                       pos2.coords.a[0], pos2.coords.a[1] );
 }
 
 double get_distance( const double lat1,
                      const double lon1,
                      const double lat2,
                      const double lon2 ) {
-  const vdirection foo = inverse( lat1, lon1, lat2, lon2 );
-  return foo.distance;
+  VINCENTY_COUNT(inverse_calls,1);
+  return kernels().distance( lat1, lon1, lat2, lon2, default_accuracy );
+}
+
+void get_distance( const double* lat1,
+                   const double* lon1,
+                   const double* lat2,
+                   const double* lon2,
+                   double* distance,
+                   const size_t n ) {
+  inverse_batch( lat1, lon1, lat2, lon2,
+                 0, distance, 0,
+                 n, default_accuracy );
 }
 
 // Bearing
 double get_bearing( const vposition& pos1,
                     const vposition& pos2 ) {
-  const vdirection foo = inverse( pos1, pos2 );
-  return foo.bearing1;
+  return get_bearing( pos1.coords.a[0], pos1.coords.a[1],
+                      pos2.coords.a[0], pos2.coords.a[1] );
 }
 
 double get_bearing( const double lat1,
                     const double lon1,
                     const double lat2,
                     const double lon2 ) {
-  const vdirection foo = inverse( lat1, lon1, lat2, lon2 );
-  return foo.bearing1;
+  VINCENTY_COUNT(inverse_calls,1);
+  return kernels().bearing( lat1, lon1, lat2, lon2, default_accuracy );
+}
+
+void get_bearing( const double* lat1,
+                  const double* lon1,
+                  const double* lat2,
+                  const double* lon2,
+                  double* bearing,
+                  const size_t n ) {
+  inverse_batch( lat1, lon1, lat2, lon2,
+                 bearing, 0, 0,
+                 n, default_accuracy );
 }
 
 
@@ -346,30 +356,3 @@ ulpcmp_inline( const double x, const double y, const uint64_t ulpdiff ) {
 
 } // namespace end
 
-
-// Inlined functions for readability.
-// ------------------------------------------------------------------------
-inline double
-A_full_precision( const double u2 ) {
-  return 1 + u2/16384 * ( 4096 + u2*( -768 + u2*(320 - 175*u2) ) );
-}
-
-inline double
-B_full_precision( const double u2 ) {
-  return 0 + u2/1024  * (  256 + u2*( -128 + u2*( 74 -  47*u2) ) );
-}
-
-inline double
-deltasigma_full_precision( const double B,
-                           const double sin_sigma,
-                           const double cos_sigma,
-                           const double cos_2sigmam ) {
-  return
-      B * sin_sigma * 
-      ( cos_2sigmam + 
-        B/4 * ( cos_sigma * ( -1 + 2*cos_2sigmam*cos_2sigmam ) - 
-                B/6 * cos_2sigmam * 
-                ( -3+4*sin_sigma*sin_sigma ) * 
-                ( -3+4*cos_2sigmam*cos_2sigmam ) ) );
-}
-// ------------------------------------------------------------------------
@@ -0,0 +1,369 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+#include "vincenty/vincenty.h"
+#include "vincenty_dispatch.h"
+#include "vincenty_metrics.h"
+
+namespace
+{
+// Iteration limits of the kernels, the iterations of a capped result.
+const unsigned int direct_limit  = 6;
+const unsigned int inverse_limit = 8;
+
+void
+merge( vincenty::iteration_histogram* hist,
+       const vincenty::iteration_histogram& batch ) {
+  if ( hist ) {
+    for ( size_t i=0; i<vincenty::iteration_histogram::bins; ++i ) {
+      hist->converged[i] += batch.converged[i];
+    }
+    hist->capped += batch.capped;
+  }
+}
+} // namespace end
+
+namespace vincenty
+{
+// Unless the metrics are compiled out, the WGS84 batches solve through the
+// variants filling a histogram, from which the iterations are counted.
+
+// Batch inverse formula
+// ------------------------------------------------------------------------
+void inverse_batch( const double* lat1,
+                    const double* lon1,
+                    const double* lat2,
+                    const double* lon2,
+                    double* bearing1,
+                    double* distance,
+                    double* bearing2,
+                    const size_t n,
+                    const double accuracy ) {
+#ifdef VINCENTY_NO_METRICS
+  kernels().inverse_batch( lat1, lon1, lat2, lon2,
+                           bearing1, distance, bearing2,
+                           n, accuracy );
+#else
+  inverse_batch( lat1, lon1, lat2, lon2,
+                 bearing1, distance, bearing2,
+                 n, accuracy, 0 );
+#endif
+}
+
+void inverse_batch( const double* lat1,
+                    const double* lon1,
+                    const double* lat2,
+                    const double* lon2,
+                    double* bearing1,
+                    double* distance,
+                    double* bearing2,
+                    const size_t n,
+                    const double accuracy,
+                    iteration_histogram* hist ) {
+  iteration_histogram batch;
+  kernels().inverse_batch_histogram( lat1, lon1, lat2, lon2,
+                                     bearing1, distance, bearing2,
+                                     n, accuracy, &batch );
+  VINCENTY_COUNT(inverse_calls,n);
+  VINCENTY_COUNT_HISTOGRAM(batch,inverse_limit);
+  merge( hist, batch );
+}
+
+void inverse_batch( const ellipsoid& e,
+                    const double* lat1,
+                    const double* lon1,
+                    const double* lat2,
+                    const double* lon2,
+                    double* bearing1,
+                    double* distance,
+                    double* bearing2,
+                    const size_t n,
+                    const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,n);
+  kernels().inverse_batch_ellipsoid( e, lat1, lon1, lat2, lon2,
+                                     bearing1, distance, bearing2,
+                                     n, accuracy );
+}
+
+template <> void
+inverse_batch<grs80>( const double* lat1,
+                      const double* lon1,
+                      const double* lat2,
+                      const double* lon2,
+                      double* bearing1,
+                      double* distance,
+                      double* bearing2,
+                      const size_t n,
+                      const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,n);
+  traits_kernels<grs80>().inverse_batch( grs80(), lat1, lon1, lat2, lon2,
+                                         bearing1, distance, bearing2,
+                                         n, accuracy );
+}
+
+template <> void
+inverse_batch<bessel1841>( const double* lat1,
+                           const double* lon1,
+                           const double* lat2,
+                           const double* lon2,
+                           double* bearing1,
+                           double* distance,
+                           double* bearing2,
+                           const size_t n,
+                           const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,n);
+  traits_kernels<bessel1841>().inverse_batch( bessel1841(),
+                                              lat1, lon1, lat2, lon2,
+                                              bearing1, distance, bearing2,
+                                              n, accuracy );
+}
+
+vdirection_vector inverse_batch( const vposition_vector& pos1,
+                                 const vposition_vector& pos2,
+                                 const double accuracy ) {
+  assert( pos1.size() == pos2.size() );
+  const size_t n = pos1.size();
+
+  vdirection_vector dirs(n);
+  if ( n > 0 ) {
+    VINCENTY_COUNT(inverse_calls,n);
+    kernels().inverse_positions( &pos1[0], &pos2[0], &dirs[0], n, accuracy );
+  }
+  return dirs;
+}
+
+void inverse_one_to_many( const prepared_position& origin,
+                          const vposition* targets,
+                          vdirection* dirs,
+                          const size_t n,
+                          const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,n);
+  kernels().inverse_one_to_many( origin, targets, dirs, 0, n, accuracy );
+}
+
+void inverse_one_to_many( const prepared_position& origin,
+                          const vposition* targets,
+                          double* distance,
+                          const size_t n,
+                          const double accuracy ) {
+  VINCENTY_COUNT(inverse_calls,n);
+  kernels().inverse_one_to_many( origin, targets, 0, distance, n, accuracy );
+}
+
+vdirection_vector inverse_one_to_many( const vposition& origin,
+                                       const vposition_vector& targets,
+                                       const double accuracy ) {
+  const size_t n = targets.size();
+
+  vdirection_vector dirs(n);
+  if ( n > 0 ) {
+    VINCENTY_COUNT(inverse_calls,n);
+    kernels().inverse_one_to_many( prepared_position(origin), &targets[0],
+                                   &dirs[0], 0, n, accuracy );
+  }
+  return dirs;
+}
+
+
+// Batch direct formula
+// ------------------------------------------------------------------------
+void direct_batch( const double* lat,
+                   const double* lon,
+                   const double* bearing,
+                   const double* distance,
+                   double* lat2,
+                   double* lon2,
+                   const size_t n,
+                   const double accuracy ) {
+#ifdef VINCENTY_NO_METRICS
+  kernels().direct_batch( lat, lon, bearing, distance,
+                          lat2, lon2,
+                          n, accuracy );
+#else
+  direct_batch( lat, lon, bearing, distance,
+                lat2, lon2,
+                n, accuracy, 0 );
+#endif
+}
+
+void direct_batch( const double* lat,
+                   const double* lon,
+                   const double* bearing,
+                   const double* distance,
+                   double* lat2,
+                   double* lon2,
+                   const size_t n,
+                   const double accuracy,
+                   iteration_histogram* hist ) {
+  iteration_histogram batch;
+  kernels().direct_batch_histogram( lat, lon, bearing, distance,
+                                    lat2, lon2,
+                                    n, accuracy, &batch );
+  VINCENTY_COUNT(direct_calls,n);
+  VINCENTY_COUNT_HISTOGRAM(batch,direct_limit);
+  merge( hist, batch );
+}
+
+void direct_batch( const ellipsoid& e,
+                   const double* lat,
+                   const double* lon,
+                   const double* bearing,
+                   const double* distance,
+                   double* lat2,
+                   double* lon2,
+                   const size_t n,
+                   const double accuracy ) {
+  VINCENTY_COUNT(direct_calls,n);
+  kernels().direct_batch_ellipsoid( e, lat, lon, bearing, distance,
+                                    lat2, lon2,
+                                    n, accuracy );
+}
+
+template <> void
+direct_batch<grs80>( const double* lat,
+                     const double* lon,
+                     const double* bearing,
+                     const double* distance,
+                     double* lat2,
+                     double* lon2,
+                     const size_t n,
+                     const double accuracy ) {
+  VINCENTY_COUNT(direct_calls,n);
+  traits_kernels<grs80>().direct_batch( grs80(), lat, lon, bearing, distance,
+                                        lat2, lon2,
+                                        n, accuracy );
+}
+
+template <> void
+direct_batch<bessel1841>( const double* lat,
+                          const double* lon,
+                          const double* bearing,
+                          const double* distance,
+                          double* lat2,
+                          double* lon2,
+                          const size_t n,
+                          const double accuracy ) {
+  VINCENTY_COUNT(direct_calls,n);
+  traits_kernels<bessel1841>().direct_batch( bessel1841(),
+                                             lat, lon, bearing, distance,
+                                             lat2, lon2,
+                                             n, accuracy );
+}
+
+vposition_vector direct_batch( const vposition_vector& pos,
+                               const vdirection_vector& dir,
+                               const double accuracy ) {
+  assert( pos.size() == dir.size() );
+  const size_t n = pos.size();
+
+  vposition_vector dest(n);
+  if ( n > 0 ) {
+    VINCENTY_COUNT(direct_calls,n);
+    kernels().direct_positions( &pos[0], &dir[0], &dest[0], n, accuracy );
+  }
+  return dest;
+}
+
+
+// Fixed iteration batch formula
+// ------------------------------------------------------------------------
+template <unsigned int N> void inverse_batch_fixed( const double* lat1,
+                                                    const double* lon1,
+                                                    const double* lat2,
+                                                    const double* lon2,
+                                                    double* bearing1,
+                                                    double* distance,
+                                                    double* bearing2,
+                                                    const size_t n ) {
+  VINCENTY_COUNT(inverse_calls,n);
+  kernels().inverse_batch_fixed[N]( lat1, lon1, lat2, lon2,
+                                    bearing1, distance, bearing2, n );
+}
+
+#define VINCENTY_INSTANTIATE_BATCH_FIXED(N)                             \
+  template void inverse_batch_fixed<N>( const double*, const double*,   \
+                                        const double*, const double*,   \
+                                        double*, double*, double*,      \
+                                        size_t );
+VINCENTY_INSTANTIATE_BATCH_FIXED(1)
+VINCENTY_INSTANTIATE_BATCH_FIXED(2)
+VINCENTY_INSTANTIATE_BATCH_FIXED(3)
+VINCENTY_INSTANTIATE_BATCH_FIXED(4)
+VINCENTY_INSTANTIATE_BATCH_FIXED(5)
+VINCENTY_INSTANTIATE_BATCH_FIXED(6)
+VINCENTY_INSTANTIATE_BATCH_FIXED(7)
+VINCENTY_INSTANTIATE_BATCH_FIXED(8)
+#undef VINCENTY_INSTANTIATE_BATCH_FIXED
+
+
+// Single precision batch formulas
+// ------------------------------------------------------------------------
+void inverse_batchf( const float* lat1,
+                     const float* lon1,
+                     const float* lat2,
+                     const float* lon2,
+                     float* bearing1,
+                     float* distance,
+                     float* bearing2,
+                     const size_t n,
+                     const float accuracy ) {
+  VINCENTY_COUNT(inverse_calls,n);
+  kernels().inverse_batchf( lat1, lon1, lat2, lon2,
+                            bearing1, distance, bearing2,
+                            n, accuracy );
+}
+
+void inverse_batchf( const v4sf lat1,
+                     const v4sf lon1,
+                     const v4sf lat2,
+                     const v4sf lon2,
+                     v4sf* bearing1,
+                     v4sf* distance,
+                     v4sf* bearing2,
+                     const float accuracy ) {
+  v4sf_u p1, l1, p2, l2, b1, s, b2;
+  p1.v = lat1;
+  l1.v = lon1;
+  p2.v = lat2;
+  l2.v = lon2;
+  VINCENTY_COUNT(inverse_calls,4);
+  kernels().inverse_batchf( p1.a, l1.a, p2.a, l2.a,
+                            b1.a, s.a, b2.a,
+                            4, accuracy );
+  *bearing1 = b1.v;
+  *distance = s.v;
+  *bearing2 = b2.v;
+}
+
+void direct_batchf( const float* lat,
+                    const float* lon,
+                    const float* bearing,
+                    const float* distance,
+                    float* lat2,
+                    float* lon2,
+                    const size_t n,
+                    const float accuracy ) {
+  VINCENTY_COUNT(direct_calls,n);
+  kernels().direct_batchf( lat, lon, bearing, distance,
+                           lat2, lon2,
+                           n, accuracy );
+}
+
+} // namespace end
@@ -0,0 +1,121 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+#include "vincenty/vincenty.h"
+#include "vincenty_dispatch.h"
+
+#include <cstdlib>
+#include <cstring>
+
+const kernel_table* selected_kernels = &kernels_sse2;
+
+#pragma GCC visibility push(hidden)
+namespace {
+
+const kernel_table* const tables[] = {
+  &kernels_sse2,
+  &kernels_avx2,
+  &kernels_avx512
+};
+
+const char* const names[] = {
+  "sse2",
+  "avx2",
+  "avx512"
+};
+
+bool
+supported( const vincenty::isa_level level ) {
+  __builtin_cpu_init();
+  switch ( level ) {
+    case vincenty::isa_sse2:
+      return true;
+    case vincenty::isa_avx2:
+      return
+          __builtin_cpu_supports("avx2") &&
+          __builtin_cpu_supports("fma");
+    case vincenty::isa_avx512:
+      return
+          __builtin_cpu_supports("avx512f") &&
+          __builtin_cpu_supports("fma");
+  }
+  return false;
+}
+
+/*!
+ * @brief Picks the kernels when the library is loaded.
+ *
+ * The best supported level is used unless VINCENTY_ISA names another one,
+ * which is handy for benchmarking without touching the code. An unknown or
+ * unsupported name is ignored.
+ */
+__attribute__((constructor)) void
+select_at_load() {
+  vincenty::isa_level level = vincenty::get_best_isa();
+  const char* env = getenv("VINCENTY_ISA");
+  if ( env ) {
+    for ( int i=vincenty::isa_sse2; i<=vincenty::isa_avx512; ++i ) {
+      if ( strcmp(env,names[i]) == 0 &&
+           supported(vincenty::isa_level(i)) ) {
+        level = vincenty::isa_level(i);
+      }
+    }
+  }
+  vincenty::set_isa(level);
+}
+
+}
+#pragma GCC visibility pop
+
+namespace vincenty
+{
+
+isa_level
+get_isa() {
+  return kernels().isa;
+}
+
+isa_level
+get_best_isa() {
+  if ( supported(isa_avx512) ) {
+    return isa_avx512;
+  } else if ( supported(isa_avx2) ) {
+    return isa_avx2;
+  }
+  return isa_sse2;
+}
+
+bool
+set_isa( const isa_level level ) {
+  if ( level < isa_sse2 || level > isa_avx512 || !supported(level) ) {
+    return false;
+  }
+  __atomic_store_n(&selected_kernels,tables[level],__ATOMIC_RELAXED);
+  return true;
+}
+
+const char*
+isa_name( const isa_level level ) {
+  if ( level < isa_sse2 || level > isa_avx512 ) {
+    return "unknown";
+  }
+  return names[level];
+}
+
+} // namespace end
@@ -0,0 +1,386 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+/*
+  Internal header for the runtime selection of the kernels. The hot functions
+  are compiled once per instruction set (vincenty_kernels_*.cpp) and each
+  copy fills in a kernel_table. The public functions calls through the table
+  picked at load time by vincenty_dispatch.cpp, or forced with
+  vincenty::set_isa().
+*/
+
+#ifndef __vincenty_dispatch_h__
+#define __vincenty_dispatch_h__
+
+#include "vincenty/distance_matrix.h"
+#include "vincenty/geodesic_line.h"
+#include "vincenty/vincenty.h"
+
+#include <cstddef>
+
+#pragma GCC visibility push(hidden)
+
+/*!
+ * @brief Entry points on an ellipsoid given as a traits type, compiled with
+ * its constants folded as the plain ones are on WGS84.
+ */
+template <typename E> struct ellipsoid_kernels
+{
+  vincenty::vposition (*direct)( const E& e,
+                                 double lat,
+                                 double lon,
+                                 double bearing,
+                                 double distance,
+                                 double accuracy );
+
+  vincenty::vdirection (*inverse)( const E& e,
+                                   double lat1,
+                                   double lon1,
+                                   double lat2,
+                                   double lon2,
+                                   double accuracy );
+
+  void (*direct_batch)( const E& e,
+                        const double* lat,
+                        const double* lon,
+                        const double* bearing,
+                        const double* distance,
+                        double* lat2,
+                        double* lon2,
+                        size_t n,
+                        double accuracy );
+
+  void (*inverse_batch)( const E& e,
+                         const double* lat1,
+                         const double* lon1,
+                         const double* lat2,
+                         const double* lon2,
+                         double* bearing1,
+                         double* distance,
+                         double* bearing2,
+                         size_t n,
+                         double accuracy );
+};
+
+/*!
+ * @brief Entry points of one compiled copy of the kernels.
+ *
+ * The arguments are the same as for the public functions with the same name,
+ * the vector overloads of the batch functions takes plain arrays of n
+ * elements.
+ */
+struct kernel_table
+{
+  vincenty::isa_level isa;
+
+  vincenty::vposition (*direct)( double lat,
+                                 double lon,
+                                 double bearing,
+                                 double distance,
+                                 double accuracy );
+
+  vincenty::vdirection (*inverse)( double lat1,
+                                   double lon1,
+                                   double lat2,
+                                   double lon2,
+                                   double accuracy );
+
+  vincenty::vdirection (*inverse_status)( double lat1,
+                                          double lon1,
+                                          double lat2,
+                                          double lon2,
+                                          double accuracy,
+                                          vincenty::inverse_status* status );
+
+  // With the iterations written to info.
+  vincenty::vposition (*direct_convergence)( double lat,
+                                             double lon,
+                                             double bearing,
+                                             double distance,
+                                             double accuracy,
+                                             vincenty::convergence* info );
+
+  vincenty::vdirection (*inverse_convergence)( double lat1,
+                                               double lon1,
+                                               double lat2,
+                                               double lon2,
+                                               double accuracy,
+                                               vincenty::convergence* info );
+
+  double (*distance)( double lat1,
+                      double lon1,
+                      double lat2,
+                      double lon2,
+                      double accuracy );
+
+  double (*bearing)( double lat1,
+                     double lon1,
+                     double lat2,
+                     double lon2,
+                     double accuracy );
+
+  // On a runtime ellipsoid, the functions above are all on WGS84.
+  vincenty::vposition (*direct_ellipsoid)( const vincenty::ellipsoid& e,
+                                           double lat,
+                                           double lon,
+                                           double bearing,
+                                           double distance,
+                                           double accuracy );
+
+  vincenty::vdirection (*inverse_ellipsoid)( const vincenty::ellipsoid& e,
+                                             double lat1,
+                                             double lon1,
+                                             double lat2,
+                                             double lon2,
+                                             double accuracy );
+
+  void (*direct_batch_ellipsoid)( const vincenty::ellipsoid& e,
+                                  const double* lat,
+                                  const double* lon,
+                                  const double* bearing,
+                                  const double* distance,
+                                  double* lat2,
+                                  double* lon2,
+                                  size_t n,
+                                  double accuracy );
+
+  void (*inverse_batch_ellipsoid)( const vincenty::ellipsoid& e,
+                                   const double* lat1,
+                                   const double* lon1,
+                                   const double* lat2,
+                                   const double* lon2,
+                                   double* bearing1,
+                                   double* distance,
+                                   double* bearing2,
+                                   size_t n,
+                                   double accuracy );
+
+  // On the built-in traits other than WGS84.
+  ellipsoid_kernels<vincenty::grs80>      grs80;
+  ellipsoid_kernels<vincenty::bessel1841> bessel1841;
+
+  // With the iterations added to hist.
+  void (*direct_batch_histogram)( const double* lat,
+                                  const double* lon,
+                                  const double* bearing,
+                                  const double* distance,
+                                  double* lat2,
+                                  double* lon2,
+                                  size_t n,
+                                  double accuracy,
+                                  vincenty::iteration_histogram* hist );
+
+  void (*inverse_batch_histogram)( const double* lat1,
+                                   const double* lon1,
+                                   const double* lat2,
+                                   const double* lon2,
+                                   double* bearing1,
+                                   double* distance,
+                                   double* bearing2,
+                                   size_t n,
+                                   double accuracy,
+                                   vincenty::iteration_histogram* hist );
+
+  void (*direct_batch)( const double* lat,
+                        const double* lon,
+                        const double* bearing,
+                        const double* distance,
+                        double* lat2,
+                        double* lon2,
+                        size_t n,
+                        double accuracy );
+
+  // Outputs which are null are not computed.
+  void (*inverse_batch)( const double* lat1,
+                         const double* lon1,
+                         const double* lat2,
+                         const double* lon2,
+                         double* bearing1,
+                         double* distance,
+                         double* bearing2,
+                         size_t n,
+                         double accuracy );
+
+  void (*direct_positions)( const vincenty::vposition* pos,
+                            const vincenty::vdirection* dir,
+                            vincenty::vposition* dest,
+                            size_t n,
+                            double accuracy );
+
+  void (*inverse_positions)( const vincenty::vposition* pos1,
+                             const vincenty::vposition* pos2,
+                             vincenty::vdirection* dirs,
+                             size_t n,
+                             double accuracy );
+
+  // Single precision versions.
+  vincenty::vposition (*directf)( float lat,
+                                  float lon,
+                                  float bearing,
+                                  float distance,
+                                  float accuracy );
+
+  vincenty::vdirection (*inversef)( float lat1,
+                                    float lon1,
+                                    float lat2,
+                                    float lon2,
+                                    float accuracy );
+
+  void (*direct_batchf)( const float* lat,
+                         const float* lon,
+                         const float* bearing,
+                         const float* distance,
+                         float* lat2,
+                         float* lon2,
+                         size_t n,
+                         float accuracy );
+
+  void (*inverse_batchf)( const float* lat1,
+                          const float* lon1,
+                          const float* lat2,
+                          const float* lon2,
+                          float* bearing1,
+                          float* distance,
+                          float* bearing2,
+                          size_t n,
+                          float accuracy );
+
+  // vincenty::prepared_position
+  void (*prepare)( double lat, double* sin_U, double* cos_U );
+
+  vincenty::vdirection (*inverse_prepared)(
+      const vincenty::prepared_position& pos1,
+      const vincenty::prepared_position& pos2,
+      double accuracy );
+
+  // Either dirs or distance may be null, a null dirs skips the bearings.
+  void (*inverse_one_to_many)(
+      const vincenty::prepared_position& origin,
+      const vincenty::vposition* targets,
+      vincenty::vdirection* dirs,
+      double* distance,
+      size_t n,
+      double accuracy );
+
+  // One row segment of vincenty::distance_matrix(), from site i of from to
+  // the sites [begin,end) of to. The outputs points at the element of site
+  // begin, those which are null are not computed.
+  void (*distance_row)( const vincenty::prepared_sites& from,
+                        size_t i,
+                        const vincenty::prepared_sites& to,
+                        size_t begin,
+                        size_t end,
+                        double* bearing1,
+                        double* distance,
+                        double* bearing2,
+                        double accuracy );
+
+  void (*distance_rowf)( const vincenty::prepared_sites& from,
+                         size_t i,
+                         const vincenty::prepared_sites& to,
+                         size_t begin,
+                         size_t end,
+                         float* bearing1,
+                         float* distance,
+                         float* bearing2,
+                         double accuracy );
+
+  // vincenty/ecef.h
+  void (*to_ecef)( const double* lat,
+                   const double* lon,
+                   double* x,
+                   double* y,
+                   double* z,
+                   size_t n );
+
+  // Sorts the points by their squared chord c2 to center, cls is 1 if c2 <
+  // inside2, 0 if c2 > outside2 and 2 otherwise.
+  void (*chord_classify)( const double* center,
+                          const double* x,
+                          const double* y,
+                          const double* z,
+                          size_t n,
+                          double inside2,
+                          double outside2,
+                          unsigned char* cls );
+
+  // vincenty::geodesic_line
+  void (*line_setup)( double lat,
+                      double lon,
+                      double bearing,
+                      vincenty::geodesic_line::state* st );
+
+  vincenty::vposition (*line_position)(
+      const vincenty::geodesic_line::state& st,
+      double distance,
+      double accuracy );
+
+  void (*line_positions)( const vincenty::geodesic_line::state& st,
+                          const double* distance,
+                          double* lat,
+                          double* lon,
+                          size_t n,
+                          double accuracy );
+
+  // Fixed iteration inverse, indexed by the number of iterations.
+  vincenty::vdirection (*inverse_fixed[vincenty::max_fixed_iterations+1])(
+      double lat1,
+      double lon1,
+      double lat2,
+      double lon2 );
+
+  void (*inverse_batch_fixed[vincenty::max_fixed_iterations+1])(
+      const double* lat1,
+      const double* lon1,
+      const double* lat2,
+      const double* lon2,
+      double* bearing1,
+      double* distance,
+      double* bearing2,
+      size_t n );
+};
+
+extern const kernel_table kernels_sse2;
+extern const kernel_table kernels_avx2;
+extern const kernel_table kernels_avx512;
+
+//! The table in use, never null. Starts out as the SSE2 table.
+extern const kernel_table* selected_kernels;
+
+inline const kernel_table&
+kernels() {
+  return *__atomic_load_n(&selected_kernels,__ATOMIC_RELAXED);
+}
+
+//! The entry points of the traits type E in the table in use.
+template <typename E> const ellipsoid_kernels<E>& traits_kernels();
+
+template <> inline const ellipsoid_kernels<vincenty::grs80>&
+traits_kernels<vincenty::grs80>() {
+  return kernels().grs80;
+}
+
+template <> inline const ellipsoid_kernels<vincenty::bessel1841>&
+traits_kernels<vincenty::bessel1841>() {
+  return kernels().bessel1841;
+}
+
+#pragma GCC visibility pop
+
+#endif
@@ -19,6 +19,7 @@
 */
 
 #include "vincenty/vincenty.h"
+#include "vincenty_dispatch.h"
 
 #include <iomanip>
 
@@ -172,4 +173,81 @@ vdirection vdirection::operator*( const double rhs ) const
   return vdirection((*this).bearing1,(*this).distance*rhs);
 }
 
+
+// Ellipsoid
+// ------------------------------------------------------------------------
+
+//! Constructor, the flattening and eccentricity are derived once.
+ellipsoid::ellipsoid( double a, double b )
+    : _a(a), _b(b), _f((a-b)/a), _ep2((a*a)/(b*b)-1)
+{
+}
+
+//! Named constructor from the inverse flattening.
+ellipsoid ellipsoid::from_flattening( double a, double inv_f )
+{
+  return ellipsoid( a, a * ( 1 - 1/inv_f ) );
+}
+
+// Prepared position
+// ------------------------------------------------------------------------
+
+//! Constructor, the position on the equator at longitude zero.
+prepared_position::prepared_position()
+    : position(), sin_U(0), cos_U(1)
+{
+}
+
+//! Constructor computing the reduced latitude terms.
+prepared_position::prepared_position( double _lat, double _lon )
+    : position(_lat,_lon), sin_U(0), cos_U(1)
+{
+  kernels().prepare(_lat,&sin_U,&cos_U);
+}
+
+//! Constructor computing the reduced latitude terms.
+prepared_position::prepared_position( const vposition& pos )
+    : position(pos), sin_U(0), cos_U(1)
+{
+  kernels().prepare(pos.coords.a[0],&sin_U,&cos_U);
+}
+
+// Convergence
+// ------------------------------------------------------------------------
+
+//! Constructor, no iterations and converged.
+convergence::convergence()
+    : iterations(0), converged(true)
+{
+}
+
+//! Constructor, all bins empty.
+iteration_histogram::iteration_histogram()
+    : capped(0)
+{
+  for ( size_t i=0; i<bins; ++i ) {
+    converged[i] = 0;
+  }
+}
+
+size_t iteration_histogram::total() const
+{
+  size_t n = capped;
+  for ( size_t i=0; i<bins; ++i ) {
+    n += converged[i];
+  }
+  return n;
+}
+
+double iteration_histogram::mean() const
+{
+  size_t n = 0;
+  double sum = 0;
+  for ( size_t i=0; i<bins; ++i ) {
+    n   += converged[i];
+    sum += double(converged[i]) * i;
+  }
+  return n ? sum / n : 0;
+}
+
 } // namespace end
@@ -0,0 +1,68 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+/*
+  Internal header, shared by the translation units implementing the
+  formulas. It is not installed and nothing in here is part of the interface.
+*/
+
+#ifndef __vincenty_internal_h__
+#define __vincenty_internal_h__
+
+#include "vincenty/vincenty.h"
+
+// This shit shall not be visible outside the library, hide all symbols.
+// The ellipsoid constants are in vincenty/ellipsoid.h, see vincenty::wgs84.
+#pragma GCC visibility push(hidden)
+
+// Inlined functions for readability. Instantiated by the kernels for each
+// instruction set, the anonymous namespace keeps the copies apart.
+// ------------------------------------------------------------------------
+namespace {
+
+template <typename T> inline T
+A_full_precision( const T u2 ) {
+  return 1 + u2/16384 * ( 4096 + u2*( -768 + u2*(320 - 175*u2) ) );
+}
+
+template <typename T> inline T
+B_full_precision( const T u2 ) {
+  return 0 + u2/1024  * (  256 + u2*( -128 + u2*( 74 -  47*u2) ) );
+}
+
+template <typename T> inline T
+deltasigma_full_precision( const T B,
+                           const T sin_sigma,
+                           const T cos_sigma,
+                           const T cos_2sigmam ) {
+  return
+      B * sin_sigma *
+      ( cos_2sigmam +
+        B/4 * ( cos_sigma * ( -1 + 2*cos_2sigmam*cos_2sigmam ) -
+                B/6 * cos_2sigmam *
+                ( -3+4*sin_sigma*sin_sigma ) *
+                ( -3+4*cos_2sigmam*cos_2sigmam ) ) );
+}
+
+} // namespace end
+// ------------------------------------------------------------------------
+#pragma GCC visibility pop
+
+#endif
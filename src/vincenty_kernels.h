@@ -0,0 +1,2041 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+/*
+  Internal header with the hot kernels, the scalar direct and inverse formulas
+  and their batch versions. It is compiled once per instruction set by
+  vincenty_kernels_sse2.cpp, vincenty_kernels_avx2.cpp and
+  vincenty_kernels_avx512.cpp, the public functions calls the copy selected
+  in vincenty_dispatch.cpp.
+
+  The formulas are templates over the operand type, the same code is
+  instantiated for double and float, scalars and vector operands. They also
+  take the ellipsoid as their first argument, either a traits type such as
+  vincenty::wgs84 whose constants are folded or a vincenty::ellipsoid.
+
+  The including translation unit must, in this order:
+
+    * include vincenty_dispatch.h and the standard headers (anything shared
+      with the rest of the library must be compiled for the baseline),
+    * raise the target with #pragma GCC target,
+    * define VINCENTY_LANES to the number of doubles in a register,
+      VINCENTY_KERNEL_ISA to its vincenty::isa_level and
+      VINCENTY_KERNEL_TABLE to the name of the kernel_table to define.
+*/
+
+#ifndef __vincenty_kernels_h__
+#define __vincenty_kernels_h__
+
+#if !defined(VINCENTY_KERNEL_TABLE) || !defined(VINCENTY_KERNEL_ISA)
+#error "vincenty_kernels.h included without a kernel table to define"
+#endif
+
+#include "vincenty_dispatch.h"
+#include "vincenty_internal.h"
+#include "vincenty_math.h"
+#include "vincenty_simd.h"
+
+#include <limits>
+
+namespace {
+
+/*!
+ * @brief Positions closer than this are treated as identical by the inverse
+ * formula. 8 ULPs of a double is nanometers, 8 ULPs of a float would be
+ * several meters.
+ */
+template <typename S> struct identical;
+
+template <> struct identical<double>
+{
+  static const uint64_t ulps = 8;
+};
+
+template <> struct identical<float>
+{
+  static const uint32_t ulps = 2;
+};
+
+// Direct formula
+// ------------------------------------------------------------------------
+
+/*!
+ * @brief Terms of the direct formula which depends only on the origin and
+ * the bearing. Computed once per vincenty::geodesic_line, or per call to
+ * direct().
+ */
+template <typename T> struct direct_state
+{
+  T lat;
+  T lon;
+  T cos_U1;
+  T sin_U1;
+  T sin_alpha1;
+  T cos_alpha1;
+  T sigma1;
+  T sin_alpha;
+  T cos2_alpha;
+  T A;
+  T B;
+  T C;
+};
+
+//! Same for scalars and vector operands, no branches.
+template <typename E, typename T> inline void
+direct_setup( const E& e,
+              const T lat,
+              const T lon,
+              const T alpha1,
+              direct_state<T>* st ) {
+  typedef typename vmath::lanes<T>::scalar S;
+
+  // The ellipsoid in the precision of the operands.
+  const S f  = e.f();
+  const S _f = e.ep2();
+
+  const T tan_U1 = (1-f) * vmath::tan(lat);
+
+  st->lat    = lat;
+  st->lon    = lon;
+  st->cos_U1 = 1 / simd::sqrt( (1 + tan_U1 * tan_U1) );
+  st->sin_U1 = tan_U1 * st->cos_U1;
+
+  vmath::sincos(alpha1,&st->sin_alpha1,&st->cos_alpha1);
+
+  st->sigma1     = vmath::atan2( tan_U1, st->cos_alpha1 );
+  st->sin_alpha  = st->cos_U1 * st->sin_alpha1;
+  st->cos2_alpha = 1 - st->sin_alpha*st->sin_alpha;
+
+  const T u2 = st->cos2_alpha * _f;
+  st->A = A_full_precision(u2);
+  st->B = B_full_precision(u2);
+  st->C = f/16*st->cos2_alpha * ( 4 + f*(4-3*st->cos2_alpha) );
+}
+
+/*!
+ * @brief The part of the direct formula depending on the distance, the sigma
+ * iteration and the final atan2s.
+ */
+template <typename E, typename S> vincenty::vposition
+direct_step( const E& e,
+             const direct_state<S>& st,
+             const S s,
+             const S accuracy,
+             vincenty::convergence* info = 0 ) {
+  // The ellipsoid in the precision of the operands.
+  const S f  = e.f();
+  const S b  = e.b();
+
+  // If equal return immediately.
+  if ( simd::ulpcmp(S(0),s) ) {
+    if ( info ) {
+      info->iterations = 0;
+      info->converged  = true;
+    }
+    return vincenty::vposition(st.lat,st.lon);
+  }
+  const S cos_U1     = st.cos_U1;
+  const S sin_U1     = st.sin_U1;
+  const S sin_alpha1 = st.sin_alpha1;
+  const S cos_alpha1 = st.cos_alpha1;
+  const S sigma1     = st.sigma1;
+  const S sin_alpha  = st.sin_alpha;
+  const S A          = st.A;
+  const S B          = st.B;
+  const S C          = st.C;
+
+  S sigma            = s / ( b * A );
+
+  S _sigma;
+  S sin_sigma;
+  S cos_sigma;
+  S cos_2sigmam;
+
+  // Prevent loop deadlock. Average loop count is 2-4 before accuracy is
+  // reached. Vincentys algorithm converges fast.
+  unsigned int i = 6;
+  unsigned int used = 0;
+  do {
+    ++used;
+    vmath::sincos(sigma,&sin_sigma,&cos_sigma);
+
+    cos_2sigmam = vmath::cos( 2*sigma1 + sigma );
+
+    const S delta_sigma = 
+        deltasigma_full_precision(B,sin_sigma,cos_sigma,cos_2sigmam);
+
+    _sigma = sigma;
+    sigma = s / (b*A) + delta_sigma;
+  } while ( simd::fabs(sigma-_sigma) > accuracy && --i );
+
+  if ( info ) {
+    // Same ULP slack as inverse_iterate().
+    info->iterations = used;
+    info->converged  =
+        simd::fabs(sigma-_sigma) <=
+        accuracy + 4*std::numeric_limits<S>::epsilon()*simd::fabs(sigma);
+  }
+
+  const S lambda = 
+      vmath::atan2( sin_sigma*sin_alpha1,
+                       cos_U1*cos_sigma - sin_U1*sin_sigma*cos_alpha1 );
+   
+  const S L = 
+      lambda - 
+      (1-C)*f*sin_alpha * 
+      ( sigma + 
+        C*sin_sigma * ( cos_2sigmam +
+                        C*cos_sigma * ( -1 +
+                                        2*cos_2sigmam*cos_2sigmam) ) );
+   
+  const S tmp =  sin_U1*sin_sigma - cos_U1*cos_sigma*cos_alpha1;
+   
+  const S lat2 = 
+      vmath::atan2( sin_U1*cos_sigma + cos_U1*sin_sigma*cos_alpha1, 
+                       (1-f)*simd::sqrt( sin_alpha*sin_alpha + tmp*tmp ) );
+  
+  /*
+    Skip computing the reversed bearing, the returned position does not have a
+    member to return the value. The implementation of how the bearing is
+    computed is keept as reference.
+  */
+  //const S bearing_reversed = vmath::atan2(-sin_alpha, tmp);
+   
+  return vincenty::vposition(lat2, st.lon+L);
+}
+
+template <typename E, typename S> vincenty::vposition
+direct_kernel( const E& e,
+               const S lat,
+               const S lon,
+               const S alpha1,
+               const S s,
+               const S accuracy ) {
+  // If equal return immediately.
+  if ( simd::ulpcmp(S(0),s) ) {
+    return vincenty::vposition(lat,lon);
+  }
+  direct_state<S> st;
+  direct_setup(e,lat,lon,alpha1,&st);
+  return direct_step(e,st,s,accuracy);
+}
+
+//! On WGS84, the constants are folded.
+template <typename S> vincenty::vposition
+direct_kernel( const S lat,
+               const S lon,
+               const S alpha1,
+               const S s,
+               const S accuracy ) {
+  return direct_kernel(vincenty::wgs84(),lat,lon,alpha1,s,accuracy);
+}
+
+//! On WGS84 and with the iterations written to info.
+template <typename S> vincenty::vposition
+direct_convergence_kernel( const S lat,
+                           const S lon,
+                           const S alpha1,
+                           const S s,
+                           const S accuracy,
+                           vincenty::convergence* info ) {
+  const vincenty::wgs84 e;
+  direct_state<S> st;
+  direct_setup(e,lat,lon,alpha1,&st);
+  return direct_step(e,st,s,accuracy,info);
+}
+
+
+// Inverse formula
+// ------------------------------------------------------------------------
+
+/*!
+ * @brief A position and the sine and cosine of its reduced latitude,
+ * atan((1-f)*tan(lat)).
+ */
+template <typename T> struct reduced_position
+{
+  T lat;
+  T lon;
+  T sin_U;
+  T cos_U;
+};
+
+/*!
+ * @brief The reduced latitude terms, computed algebraically from tan(U) as in
+ * direct_setup() instead of through atan and sincos. Same for scalars and
+ * vector operands.
+ */
+template <typename E, typename T> inline reduced_position<T>
+reduce( const E& e, const T lat, const T lon ) {
+  typedef typename vmath::lanes<T>::scalar S;
+
+  const S f = e.f();
+
+  const T tan_U = (1-f) * vmath::tan(lat);
+  reduced_position<T> r;
+  r.lat   = lat;
+  r.lon   = lon;
+  r.cos_U = 1 / simd::sqrt( 1 + tan_U * tan_U );
+  r.sin_U = tan_U * r.cos_U;
+  return r;
+}
+
+/*!
+ * @brief What the lambda iteration leaves for the distance and the bearings.
+ */
+template <typename T> struct inverse_state
+{
+  T sin_U1;
+  T cos_U1;
+  T sin_U2;
+  T cos_U2;
+  T sin_lambda;
+  T cos_lambda;
+  T sin_sigma;
+  T cos_sigma;
+  T sigma;
+  T cos2_alpha;
+  T cos_2sigmam;
+};
+
+/*!
+ * @brief Iterates lambda until it changes less than accuracy. Identical
+ * positions must be caught by the caller, sin_sigma is zero for them.
+ *
+ * @return False if the accuracy was not reached, for nearly antipodal
+ * positions lambda oscillates. A change of a few ULPs counts as converged,
+ * the float accuracy is finer than a float lambda. The same is written to
+ * info if non-null, with the number of iterations.
+ */
+template <typename E, typename S> inline bool
+inverse_iterate( const E& e,
+                 const reduced_position<S>& p1,
+                 const reduced_position<S>& p2,
+                 const S accuracy,
+                 inverse_state<S>* st,
+                 vincenty::convergence* info = 0 ) {
+  // The ellipsoid in the precision of the operands.
+  const S f = e.f();
+
+  const S sin_U1 = p1.sin_U;
+  const S cos_U1 = p1.cos_U;
+  const S sin_U2 = p2.sin_U;
+  const S cos_U2 = p2.cos_U;
+  const S lon1   = p1.lon;
+  const S lon2   = p2.lon;
+  const S L = lon2-lon1;
+  S lambda  = L;
+
+  S sin_lambda;
+  S cos_lambda;
+
+  S sin_sigma;
+  S cos_sigma;
+
+  S cos2_alpha;
+  S cos_2sigmam;
+  S sigma;
+  S _lambda;
+
+  // Prevent loop deadlock. Average loop count is 2-4 before accuracy is
+  // reached. Vincentys algorithm converges fast.
+  unsigned int i = 8;
+  unsigned int used = 0;
+  do {
+    ++used;
+    vmath::sincos(lambda,&sin_lambda,&cos_lambda);
+    
+    // pow() might be tempting but is slower!
+    sin_sigma = simd::sqrt( cos_U2*sin_lambda * cos_U2*sin_lambda + 
+                      (cos_U1*sin_U2 - sin_U1*cos_U2*cos_lambda) *
+                      (cos_U1*sin_U2 - sin_U1*cos_U2*cos_lambda) );
+
+    cos_sigma = sin_U1*sin_U2 + cos_U1*cos_U2*cos_lambda;
+
+    sigma = vmath::atan2( sin_sigma, cos_sigma );
+
+    const S sin_alpha = cos_U1*cos_U2*sin_lambda/sin_sigma;
+
+    cos2_alpha = 1 - sin_alpha * sin_alpha;
+
+    _lambda = lambda;
+     
+    if ( simd::ulpcmp(cos2_alpha,S(0),16) ) {
+      cos_2sigmam = 0;
+      lambda = L + f * sin_alpha * sigma;
+    } else {
+      cos_2sigmam = cos_sigma - 2*sin_U1*sin_U2/cos2_alpha;
+      const S C = f/16 * cos2_alpha * ( 4 + f * (4 - 3*cos2_alpha) );
+      lambda = 
+          L + (1-C) * f * sin_alpha * 
+          ( sigma + C * sin_sigma * 
+            ( cos_2sigmam + C * cos_sigma * 
+              ( -1 + 2 * cos_2sigmam*cos_2sigmam ) ) );
+    }
+  } while ( simd::fabs(lambda-_lambda) > accuracy && --i );
+
+  st->sin_U1      = sin_U1;
+  st->cos_U1      = cos_U1;
+  st->sin_U2      = sin_U2;
+  st->cos_U2      = cos_U2;
+  st->sin_lambda  = sin_lambda;
+  st->cos_lambda  = cos_lambda;
+  st->sin_sigma   = sin_sigma;
+  st->cos_sigma   = cos_sigma;
+  st->sigma       = sigma;
+  st->cos2_alpha  = cos2_alpha;
+  st->cos_2sigmam = cos_2sigmam;
+
+  const bool converged =
+      simd::fabs(lambda-_lambda) <=
+      accuracy + 4*std::numeric_limits<S>::epsilon()*simd::fabs(lambda);
+  if ( info ) {
+    info->iterations = used;
+    info->converged  = converged;
+  }
+  return converged;
+}
+
+/*!
+ * @brief The distance from an iterated state, the A/B/delta_sigma series.
+ * Same for scalars and vector operands.
+ */
+template <typename E, typename T> inline T
+inverse_distance( const E& e, const inverse_state<T>& st ) {
+  typedef typename vmath::lanes<T>::scalar S;
+
+  const S b  = e.b();
+  const S _f = e.ep2();
+
+  const T u2 = st.cos2_alpha * _f;
+
+  const T delta_sigma = deltasigma_full_precision( B_full_precision(u2),
+                                                   st.sin_sigma,
+                                                   st.cos_sigma,
+                                                   st.cos_2sigmam );
+
+  return b * A_full_precision(u2) * ( st.sigma - delta_sigma );
+}
+
+//! The bearing from the first position, in [0,2*M_PI).
+template <typename T> inline T
+inverse_bearing1( const inverse_state<T>& st ) {
+  typedef typename vmath::lanes<T>::scalar S;
+
+  const T p1p2 = vmath::atan2( st.cos_U2*st.sin_lambda,
+                               st.cos_U1*st.sin_U2 -
+                               st.sin_U1*st.cos_U2*st.cos_lambda );
+  return simd::select( p1p2 < vmath::lanes<T>::splat(0),
+                       p1p2 + S(2*M_PI),
+                       p1p2 );
+}
+
+//! The bearing from the second position.
+template <typename T> inline T
+inverse_bearing2( const inverse_state<T>& st ) {
+  typedef typename vmath::lanes<T>::scalar S;
+
+  return vmath::atan2( st.cos_U1*st.sin_lambda,
+                       -st.sin_U1*st.cos_U2 +
+                       st.cos_U1*st.sin_U2*st.cos_lambda )
+      // Scary, but the reverse bearing needs a "180 degree turn". At least to
+      // be correct with the intervall [0,2*M_PI].
+      + S(M_PI);
+}
+
+/*!
+ * @brief Longitude difference along the geodesic in st after the arc sigma,
+ * and the reduced latitude there. Same terms as in direct_step(), the
+ * spherical longitude is unwrapped to [0,2*M_PI) so the geodesic must head
+ * east.
+ */
+template <typename E, typename S> inline S
+geodesic_longitude( const E& e,
+                    const direct_state<S>& st,
+                    const S sigma,
+                    S* U ) {
+  const S f = e.f();
+  const S C = st.C;
+
+  S sin_sigma;
+  S cos_sigma;
+  vmath::sincos(sigma,&sin_sigma,&cos_sigma);
+
+  const S cos_2sigmam = vmath::cos( 2*st.sigma1 + sigma );
+
+  S omega = vmath::atan2( sin_sigma*st.sin_alpha1,
+                          st.cos_U1*cos_sigma -
+                          st.sin_U1*sin_sigma*st.cos_alpha1 );
+  if ( omega < 0 ) {
+    omega += S(2*M_PI);
+  }
+
+  const S tmp = st.sin_U1*sin_sigma - st.cos_U1*cos_sigma*st.cos_alpha1;
+  *U = vmath::atan2( st.sin_U1*cos_sigma + st.cos_U1*sin_sigma*st.cos_alpha1,
+                     simd::sqrt( st.sin_alpha*st.sin_alpha + tmp*tmp ) );
+
+  return
+      omega -
+      (1-C)*f*st.sin_alpha *
+      ( sigma +
+        C*sin_sigma * ( cos_2sigmam +
+                        C*cos_sigma * ( -1 +
+                                        2*cos_2sigmam*cos_2sigmam) ) );
+}
+
+/*!
+ * @brief The arc where the geodesic in st has come L east, in [0,2*M_PI].
+ *
+ * The longitude grows monotonically with the arc, Newton steps which leave
+ * the bracket are replaced by bisection so the loop always ends.
+ */
+template <typename E, typename S> inline S
+geodesic_arc( const E& e,
+              const direct_state<S>& st,
+              const S L,
+              const S accuracy,
+              S* U ) {
+  const S f = e.f();
+
+  S lo    = 0;
+  S hi    = S(2*M_PI);
+  S sigma = L;
+
+  for ( unsigned int i = 0; i < 64; ++i ) {
+    const S lambda = geodesic_longitude(e,st,sigma,U);
+    if ( lambda < L ) {
+      lo = sigma;
+    } else {
+      hi = sigma;
+    }
+    // d(omega)/d(sigma) is sin(alpha)/cos(U)^2, Clairaut. Converged on the
+    // arc and not on lambda, which hardly moves along a meridian.
+    S sin_U;
+    S cos_U;
+    vmath::sincos(*U,&sin_U,&cos_U);
+    const S dlambda = st.sin_alpha/(cos_U*cos_U) - (1-st.C)*f*st.sin_alpha;
+    S next = sigma - (lambda-L)/dlambda;
+    // Checked before the bracket, an exact step lands on its end and would
+    // bisect from scratch.
+    if ( simd::fabs(next-sigma) <= accuracy ) {
+      break;
+    }
+    if ( !( next > lo && next < hi ) ) {
+      next = (lo+hi)/2;
+    }
+    if ( simd::fabs(next-sigma) <= accuracy ) {
+      break;
+    }
+    sigma = next;
+  }
+  return sigma;
+}
+
+/*!
+ * @brief How far north of p2 the geodesic leaving lat1 with the bearing
+ * alpha1 crosses the meridian L east, in reduced latitude. Not in its sine,
+ * which hardly moves close to the poles.
+ */
+template <typename E> inline double
+antipodal_miss( const E& e,
+                const double lat1,
+                const double alpha1,
+                const double L,
+                const double U2,
+                const double accuracy,
+                direct_state<double>* st,
+                double* sigma ) {
+  direct_setup(e,lat1,0.0,alpha1,st);
+
+  double U;
+  *sigma = geodesic_arc(e,*st,L,accuracy,&U);
+  return U - U2;
+}
+
+/*!
+ * @brief False position (Illinois) iteration for the bearing in [lo,hi]
+ * where the miss changes sign. Steps which do not halve the bracket are
+ * followed by bisection, false position crawls along one side of a steep
+ * miss. Bounded, false when neither the accuracy nor the resolution of the
+ * bearing was reached.
+ */
+template <typename E> bool
+antipodal_refine( const E& e,
+                  const double lat1,
+                  const double L,
+                  const double U2,
+                  const double accuracy,
+                  double lo,
+                  double glo,
+                  double hi,
+                  double ghi,
+                  double* alpha1,
+                  double* sigma ) {
+  direct_state<double> st;
+  int side = 0;
+  bool bisect = false;
+  for ( unsigned int i = 0; i < 128; ++i ) {
+    double x = ( lo*ghi - hi*glo ) / ( ghi-glo );
+    if ( bisect || !( x > lo && x < hi ) ) {
+      x = (lo+hi)/2;
+    }
+    const double g = antipodal_miss(e,lat1,x,L,U2,accuracy,&st,sigma);
+    *alpha1 = x;
+    // Not on the width of the bracket, close to a meridian a small change
+    // of the bearing moves the crossing far. Unless the bracket is down to
+    // a few ULPs, no bearing in double comes closer.
+    if ( simd::fabs(g) <= accuracy ||
+         hi-lo <= 4*std::numeric_limits<double>::epsilon()*hi ) {
+      return true;
+    }
+    const double width = hi-lo;
+    if ( ( g > 0 ) == ( glo > 0 ) ) {
+      lo  = x;
+      glo = g;
+      if ( side > 0 ) {
+        ghi /= 2;
+      }
+      side = 1;
+    } else {
+      hi  = x;
+      ghi = g;
+      if ( side < 0 ) {
+        glo /= 2;
+      }
+      side = -1;
+    }
+    bisect = hi-lo > width/2;
+  }
+  return false;
+}
+
+/*!
+ * @brief Keeps the geodesic from lat1 with the bearing alpha1 and the arc
+ * sigma in dir if it is the first or shorter than the one there.
+ */
+template <typename E> inline bool
+antipodal_keep( const E& e,
+                const double lat1,
+                const double alpha1,
+                const double sigma,
+                const bool west,
+                const bool found,
+                vincenty::vdirection* dir ) {
+  const double b = e.b();
+
+  // Mirrored back if solved east for a position to the west.
+  const double alpha = west ? -alpha1 : alpha1;
+
+  direct_state<double> st;
+  direct_setup(e,lat1,0.0,alpha,&st);
+
+  double sin_sigma;
+  double cos_sigma;
+  vmath::sincos(sigma,&sin_sigma,&cos_sigma);
+  const double cos_2sigmam = vmath::cos( 2*st.sigma1 + sigma );
+
+  const double s =
+      b * st.A *
+      ( sigma -
+        deltasigma_full_precision(st.B,sin_sigma,cos_sigma,cos_2sigmam) );
+  if ( found && s >= dir->distance ) {
+    return false;
+  }
+
+  const double tmp = st.sin_U1*sin_sigma - st.cos_U1*cos_sigma*st.cos_alpha1;
+
+  dir->bearing1 = alpha < 0 ? alpha + 2*M_PI : alpha;
+  dir->distance = s;
+  dir->bearing2 = vmath::atan2(st.sin_alpha,-tmp) + M_PI;
+  return true;
+}
+
+/*!
+ * @brief A bearing in [lo,hi] where the miss is negative, or positive for a
+ * negative sign. The miss has at most one turning point in each half of
+ * [0,M_PI], where the meridian of p2 touches the envelope of the geodesics
+ * from p1, golden section search closes in on it until the sign flips. The
+ * turning point is found to the square root of the accuracy, the miss there
+ * is quadratic in the bearing.
+ *
+ * @return False if the miss keeps its sign, there is no root in [lo,hi].
+ */
+template <typename E> bool
+antipodal_extremum( const E& e,
+                    const double lat1,
+                    const double L,
+                    const double U2,
+                    const double accuracy,
+                    const double sign,
+                    double lo,
+                    double hi,
+                    double* alpha1,
+                    double* g ) {
+  static const double ratio = 0.38196601125010515; // (3-sqrt(5))/2
+
+  direct_state<double> st;
+  double sigma;
+  double x1 = lo + ratio*(hi-lo);
+  double x2 = hi - ratio*(hi-lo);
+  double g1 = sign*antipodal_miss(e,lat1,x1,L,U2,accuracy,&st,&sigma);
+  double g2 = 0;
+  bool second = false;
+  const double width = simd::sqrt(accuracy);
+  for ( unsigned int i = 0; i < 64 && g1 >= 0; ++i ) {
+    if ( !second ) {
+      g2 = sign*antipodal_miss(e,lat1,x2,L,U2,accuracy,&st,&sigma);
+      second = true;
+      if ( g2 < 0 ) {
+        break;
+      }
+    }
+    if ( hi-lo <= width ) {
+      return false;
+    }
+    if ( g1 < g2 ) {
+      hi = x2;
+      x2 = x1;
+      g2 = g1;
+      x1 = lo + ratio*(hi-lo);
+      g1 = sign*antipodal_miss(e,lat1,x1,L,U2,accuracy,&st,&sigma);
+    } else {
+      lo = x1;
+      x1 = x2;
+      g1 = g2;
+      second = false;
+      x2 = hi - ratio*(hi-lo);
+    }
+  }
+  const bool first = g1 < 0;
+  if ( !first && !( second && g2 < 0 ) ) {
+    return false;
+  }
+  *alpha1 = first ? x1 : x2;
+  *g      = sign*( first ? g1 : g2 );
+  return true;
+}
+
+/*!
+ * @brief Inverse formula for the pairs where the lambda iteration does not
+ * converge, nearly antipodal positions.
+ *
+ * Solves the direct problem instead. The geodesic leaving p1 with the bearing
+ * alpha1 crosses the meridian of p2 near the north pole for alpha1 = 0 and
+ * near the south pole for alpha1 = M_PI. In between the miss falls to a
+ * minimum before M_PI/2 and rises to a maximum after it. Close to the equator
+ * two roots can lie on the same side of M_PI/2 without a sign change between
+ * them, the half where the miss at M_PI/2 does not already change sign is
+ * searched for its turning point with antipodal_extremum(). Every sign change
+ * between the poles, M_PI/2 and the turning point is refined with
+ * antipodal_refine(), the crossing itself with geodesic_arc(). The shortest of
+ * the geodesics to p2 is returned. All loops are bounded, false when the
+ * accuracy was not reached for any of them.
+ */
+template <typename E> bool
+inverse_antipodal( const E& e,
+                   const reduced_position<double>& p1,
+                   const reduced_position<double>& p2,
+                   const double accuracy,
+                   vincenty::vdirection* dir ) {
+  // Solved heading east, mirrored back at the end.
+  double L = p2.lon-p1.lon;
+  L -= 2*M_PI * std::ceil( L/(2*M_PI) - 0.5 );
+  const bool west = L < 0;
+  L = simd::fabs(L);
+
+  const double U1 = vmath::atan2(p1.sin_U,p1.cos_U);
+  const double U2 = vmath::atan2(p2.sin_U,p2.cos_U);
+
+  bool found  = false;
+  bool failed = false;
+
+  // On the opposite meridian the meridians over the poles are geodesics to
+  // p2 too. The miss jumps next to them, there is nothing to refine there.
+  const bool opposite = M_PI-L <= accuracy;
+  if ( opposite ) {
+    found = antipodal_keep(e,p1.lat,0.0,M_PI-U1-U2,west,found,dir);
+    antipodal_keep(e,p1.lat,M_PI,M_PI+U1+U2,west,found,dir);
+  }
+
+  direct_state<double> st;
+  double sigma_mid;
+  const double g_mid =
+      antipodal_miss(e,p1.lat,M_PI/2,L,U2,accuracy,&st,&sigma_mid);
+  if ( simd::fabs(g_mid) <= accuracy ) {
+    found = antipodal_keep(e,p1.lat,M_PI/2,sigma_mid,west,found,dir) || found;
+  }
+
+  // The poles, M_PI/2 and the turning points where the miss changes sign.
+  double alpha[5];
+  double g[5];
+  unsigned int n = 0;
+  alpha[n] = 0.0;
+  g[n++]   = M_PI/2-U2;
+  if ( g_mid > -accuracy &&
+       antipodal_extremum( e, p1.lat, L, U2, accuracy, 1.0, 0.0, M_PI/2,
+                           &alpha[n], &g[n] ) ) {
+    ++n;
+  }
+  alpha[n] = M_PI/2;
+  g[n++]   = g_mid;
+  if ( g_mid < accuracy &&
+       antipodal_extremum( e, p1.lat, L, U2, accuracy, -1.0, M_PI/2, M_PI,
+                           &alpha[n], &g[n] ) ) {
+    ++n;
+  }
+  alpha[n] = M_PI;
+  g[n++]   = -M_PI/2-U2;
+
+  double alpha_failed = M_PI/2;
+  double sigma_failed = sigma_mid;
+  for ( unsigned int k = 0; k+1 < n; ++k ) {
+    if ( ( opposite && ( k == 0 || k+2 == n ) ) ||
+         !( ( g[k] > 0 && g[k+1] < 0 ) || ( g[k] < 0 && g[k+1] > 0 ) ) ) {
+      continue;
+    }
+    double alpha1;
+    double sigma;
+    if ( antipodal_refine( e, p1.lat, L, U2, accuracy,
+                           alpha[k], g[k], alpha[k+1], g[k+1],
+                           &alpha1, &sigma ) ) {
+      if ( antipodal_keep(e,p1.lat,alpha1,sigma,west,found,dir) ) {
+        found = true;
+      }
+    } else {
+      failed       = true;
+      alpha_failed = alpha1;
+      sigma_failed = sigma;
+    }
+  }
+
+  // The last attempt rather than nothing, reported as failed.
+  if ( !found ) {
+    antipodal_keep(e,p1.lat,alpha_failed,sigma_failed,west,false,dir);
+  }
+  return found && !failed;
+}
+
+/*!
+ * @brief Single precision positions are solved in double, the rounding of
+ * the nested loops adds up to tens of meters in float.
+ */
+template <typename E> bool
+inverse_antipodal( const E& e,
+                   const reduced_position<float>& p1,
+                   const reduced_position<float>& p2,
+                   const float accuracy,
+                   vincenty::vdirection* dir ) {
+  return inverse_antipodal( e,
+                            reduce(e,double(p1.lat),double(p1.lon)),
+                            reduce(e,double(p2.lat),double(p2.lon)),
+                            double(accuracy),
+                            dir );
+}
+
+/*!
+ * @brief The inverse formula, with inverse_antipodal() for the pairs where
+ * lambda does not converge. How it went is written to status and info if
+ * non-null.
+ */
+template <typename E, typename S> vincenty::vdirection
+inverse_reduced( const E& e,
+                 const reduced_position<S>& p1,
+                 const reduced_position<S>& p2,
+                 const S accuracy,
+                 vincenty::inverse_status* status = 0,
+                 vincenty::convergence* info = 0 ) {
+  // If equal return immediately.
+  if ( simd::ulpcmp(p1.lat,p2.lat,identical<S>::ulps) &&
+       simd::ulpcmp(p1.lon,p2.lon,identical<S>::ulps) ) {
+    if ( status ) {
+      *status = vincenty::inverse_converged;
+    }
+    if ( info ) {
+      info->iterations = 0;
+      info->converged  = true;
+    }
+    return vincenty::vdirection(0.0,0.0,0.0);
+  }
+
+  inverse_state<S> st;
+  if ( inverse_iterate(e,p1,p2,accuracy,&st,info) ) {
+    if ( status ) {
+      *status = vincenty::inverse_converged;
+    }
+    return vincenty::vdirection( inverse_bearing1(st),
+                                 inverse_distance(e,st),
+                                 inverse_bearing2(st) );
+  }
+
+  vincenty::vdirection dir;
+  const bool converged = inverse_antipodal(e,p1,p2,accuracy,&dir);
+  if ( status ) {
+    *status = converged ? vincenty::inverse_fallback : vincenty::inverse_failed;
+  }
+  return dir;
+}
+
+template <typename E, typename S> vincenty::vdirection
+inverse_kernel( const E& e,
+                const S lat1,
+                const S lon1,
+                const S lat2,
+                const S lon2,
+                const S accuracy ) {
+  // If equal return immediately, before computing anything.
+  if ( simd::ulpcmp(lat1,lat2,identical<S>::ulps) &&
+       simd::ulpcmp(lon1,lon2,identical<S>::ulps) ) {
+    return vincenty::vdirection(0.0,0.0,0.0);
+  }
+  return inverse_reduced( e, reduce(e,lat1,lon1), reduce(e,lat2,lon2),
+                          accuracy );
+}
+
+//! On WGS84 and with the convergence written to status.
+template <typename S> vincenty::vdirection
+inverse_status_kernel( const S lat1,
+                       const S lon1,
+                       const S lat2,
+                       const S lon2,
+                       const S accuracy,
+                       vincenty::inverse_status* status ) {
+  const vincenty::wgs84 e;
+  return inverse_reduced( e, reduce(e,lat1,lon1), reduce(e,lat2,lon2),
+                          accuracy, status );
+}
+
+//! On WGS84 and with the iterations written to info.
+template <typename S> vincenty::vdirection
+inverse_convergence_kernel( const S lat1,
+                            const S lon1,
+                            const S lat2,
+                            const S lon2,
+                            const S accuracy,
+                            vincenty::convergence* info ) {
+  const vincenty::wgs84 e;
+  return inverse_reduced( e, reduce(e,lat1,lon1), reduce(e,lat2,lon2),
+                          accuracy, 0, info );
+}
+
+//! On WGS84, the constants are folded.
+template <typename S> vincenty::vdirection
+inverse_kernel( const S lat1,
+                const S lon1,
+                const S lat2,
+                const S lon2,
+                const S accuracy ) {
+  return inverse_kernel(vincenty::wgs84(),lat1,lon1,lat2,lon2,accuracy);
+}
+
+/*!
+ * @brief Distance only inverse formula, the bearings are never computed.
+ */
+template <typename S> S
+distance_kernel( const S lat1,
+                 const S lon1,
+                 const S lat2,
+                 const S lon2,
+                 const S accuracy ) {
+  if ( simd::ulpcmp(lat1,lat2,identical<S>::ulps) &&
+       simd::ulpcmp(lon1,lon2,identical<S>::ulps) ) {
+    return 0;
+  }
+  const vincenty::wgs84 e;
+  const reduced_position<S> p1 = reduce(e,lat1,lon1);
+  const reduced_position<S> p2 = reduce(e,lat2,lon2);
+  inverse_state<S> st;
+  if ( !inverse_iterate(e,p1,p2,accuracy,&st) ) {
+    vincenty::vdirection dir;
+    inverse_antipodal(e,p1,p2,accuracy,&dir);
+    return dir.distance;
+  }
+  return inverse_distance(e,st);
+}
+
+/*!
+ * @brief Bearing only inverse formula, the distance series is never
+ * computed.
+ */
+template <typename S> S
+bearing_kernel( const S lat1,
+                const S lon1,
+                const S lat2,
+                const S lon2,
+                const S accuracy ) {
+  if ( simd::ulpcmp(lat1,lat2,identical<S>::ulps) &&
+       simd::ulpcmp(lon1,lon2,identical<S>::ulps) ) {
+    return 0;
+  }
+  const vincenty::wgs84 e;
+  const reduced_position<S> p1 = reduce(e,lat1,lon1);
+  const reduced_position<S> p2 = reduce(e,lat2,lon2);
+  inverse_state<S> st;
+  if ( !inverse_iterate(e,p1,p2,accuracy,&st) ) {
+    vincenty::vdirection dir;
+    inverse_antipodal(e,p1,p2,accuracy,&dir);
+    return dir.bearing1;
+  }
+  return inverse_bearing1(st);
+}
+
+
+// Batch versions
+// ------------------------------------------------------------------------
+/*!
+ * @brief Lambda iteration for VINCENTY_LANES pairs at the same time.
+ *
+ * Same computation as inverse_iterate() but every variable is a vector
+ * operand. The loop runs until all lanes have converged, lanes which already
+ * have converged are masked out and keeps the values from their last
+ * iteration. The equatorial case (cos2_alpha == 0) is blended instead of
+ * branched. Lanes set in equal are never iterated. The iterations of each
+ * lane are written to iterations if non-null.
+ *
+ * @return The lanes which did not reach the accuracy.
+ */
+template <typename E, typename T> inline typename vmath::lanes<T>::mask
+inverse_iterate_lanes( const E& e,
+                       const reduced_position<T>& p1,
+                       const reduced_position<T>& p2,
+                       const typename vmath::lanes<T>::mask equal,
+                       const double accuracy,
+                       inverse_state<T>* st,
+                       T* iterations = 0 ) {
+  typedef typename vmath::lanes<T>::scalar S;
+  typedef typename vmath::lanes<T>::mask M;
+
+  // The ellipsoid in the precision of the operands.
+  const S f = e.f();
+
+  const T zero = vmath::lanes<T>::splat(0);
+  const T one  = vmath::lanes<T>::splat(1);
+
+  const T cos_U1 = p1.cos_U;
+  const T cos_U2 = p2.cos_U;
+  const T sin_U1 = p1.sin_U;
+  const T sin_U2 = p2.sin_U;
+  const T lon1   = p1.lon;
+  const T lon2   = p2.lon;
+
+  const T L = lon2-lon1;
+  T lambda  = L;
+
+  T sin_lambda  = zero;
+  T cos_lambda  = one;
+  T sin_sigma   = zero;
+  T cos_sigma   = one;
+  T cos2_alpha  = zero;
+  T cos_2sigmam = zero;
+  T sigma       = zero;
+
+  // A value below 16 denormals is considered zero, exactly as in inverse().
+  const T tiny =
+      vmath::lanes<T>::splat(16*std::numeric_limits<S>::denorm_min());
+
+  M active = ~equal;
+  T delta  = zero;
+  T used   = zero;
+
+  // Same maximum number of iterations as inverse().
+  for ( unsigned int i = 8; i && simd::any(active); --i ) {
+    used = simd::select(active,used+one,used);
+
+    T s_lambda;
+    T c_lambda;
+    vmath::sincos(lambda,&s_lambda,&c_lambda);
+
+    const T t = cos_U1*sin_U2 - sin_U1*cos_U2*c_lambda;
+    const T s_sigma =
+        simd::sqrt( cos_U2*s_lambda * cos_U2*s_lambda + t*t );
+    const T c_sigma = sin_U1*sin_U2 + cos_U1*cos_U2*c_lambda;
+    const T sig     = vmath::atan2( s_sigma, c_sigma );
+
+    // Coincident lanes would divide by zero, they are masked out anyway.
+    const T sin_alpha =
+        cos_U1*cos_U2*s_lambda / simd::select(equal,one,s_sigma);
+    const T c2_alpha  = 1 - sin_alpha * sin_alpha;
+
+    // Blend the equatorial line, cos_2sigmam is zero and so is C.
+    const M equatorial = ( c2_alpha >= zero ) & ( c2_alpha < tiny );
+    const T c_2sigmam  =
+        simd::select( equatorial,
+                      zero,
+                      c_sigma - 2*sin_U1*sin_U2 /
+                      simd::select(equatorial,one,c2_alpha) );
+
+    const T C = f/16 * c2_alpha * ( 4 + f * (4 - 3*c2_alpha) );
+    const T l =
+        L + (1-C) * f * sin_alpha *
+        ( sig + C * s_sigma *
+          ( c_2sigmam + C * c_sigma *
+            ( -1 + 2 * c_2sigmam*c_2sigmam ) ) );
+
+    // Only lanes still iterating are updated.
+    sin_lambda  = simd::select(active,s_lambda,sin_lambda);
+    cos_lambda  = simd::select(active,c_lambda,cos_lambda);
+    sin_sigma   = simd::select(active,s_sigma,sin_sigma);
+    cos_sigma   = simd::select(active,c_sigma,cos_sigma);
+    sigma       = simd::select(active,sig,sigma);
+    cos2_alpha  = simd::select(active,c2_alpha,cos2_alpha);
+    cos_2sigmam = simd::select(active,c_2sigmam,cos_2sigmam);
+
+    delta  = simd::select(active,simd::fabs(l-lambda),delta);
+    lambda = simd::select(active,l,lambda);
+    active = active & ( delta > S(accuracy) );
+  }
+
+  st->sin_U1      = sin_U1;
+  st->cos_U1      = cos_U1;
+  st->sin_U2      = sin_U2;
+  st->cos_U2      = cos_U2;
+  st->sin_lambda  = sin_lambda;
+  st->cos_lambda  = cos_lambda;
+  st->sin_sigma   = sin_sigma;
+  st->cos_sigma   = cos_sigma;
+  st->sigma       = sigma;
+  st->cos2_alpha  = cos2_alpha;
+  st->cos_2sigmam = cos_2sigmam;
+
+  if ( iterations ) {
+    *iterations = used;
+  }
+
+  // Same ULP slack as inverse_iterate().
+  return active &
+      ( delta > S(accuracy) +
+        4*std::numeric_limits<S>::epsilon()*simd::fabs(lambda) );
+}
+
+
+/*!
+ * @brief Inverse formula for VINCENTY_LANES pairs at the same time.
+ *
+ * Only the outputs whose pointers are non-null are computed, the bearings
+ * cost two atan2 and the distance the A/B/delta_sigma series. Lanes which
+ * does not converge are redone one by one with inverse_antipodal(); only the
+ * first m lanes are, the rest are padding. The iterations and the lanes
+ * which did not converge are written to iterations and capped if non-null.
+ */
+template <typename E, typename T> void
+inverse_reduced_lanes( const E& e,
+                       const reduced_position<T>& p1,
+                       const reduced_position<T>& p2,
+                       T* bearing1,
+                       T* distance,
+                       T* bearing2,
+                       const double accuracy,
+                       const size_t m,
+                       T* iterations = 0,
+                       typename vmath::lanes<T>::mask* capped = 0 ) {
+  typedef typename vmath::lanes<T>::scalar S;
+  typedef typename vmath::lanes<T>::mask M;
+
+  // Identical positions are never iterated, they are set to zero last.
+  const M equal =
+      simd::ulpcmp(p1.lat,p2.lat,identical<S>::ulps) &
+      simd::ulpcmp(p1.lon,p2.lon,identical<S>::ulps);
+
+  inverse_state<T> st;
+  const M failed =
+      inverse_iterate_lanes(e,p1,p2,equal,accuracy,&st,iterations);
+  if ( capped ) {
+    *capped = failed;
+  }
+
+  const T zero = vmath::lanes<T>::splat(0);
+  if ( bearing1 ) {
+    *bearing1 = simd::select(equal,zero,inverse_bearing1(st));
+  }
+  if ( distance ) {
+    *distance = simd::select(equal,zero,inverse_distance(e,st));
+  }
+  if ( bearing2 ) {
+    *bearing2 = simd::select(equal,zero,inverse_bearing2(st));
+  }
+
+  if ( !simd::any(failed) ) {
+    return;
+  }
+  for ( size_t j = 0; j < m && j < sizeof(T)/sizeof(S); ++j ) {
+    if ( !failed[j] ) {
+      continue;
+    }
+    reduced_position<S> q1;
+    q1.lat   = p1.lat[j];
+    q1.lon   = p1.lon[j];
+    q1.sin_U = p1.sin_U[j];
+    q1.cos_U = p1.cos_U[j];
+    reduced_position<S> q2;
+    q2.lat   = p2.lat[j];
+    q2.lon   = p2.lon[j];
+    q2.sin_U = p2.sin_U[j];
+    q2.cos_U = p2.cos_U[j];
+
+    vincenty::vdirection dir;
+    inverse_antipodal(e,q1,q2,S(accuracy),&dir);
+    if ( bearing1 ) {
+      (*bearing1)[j] = dir.bearing1;
+    }
+    if ( distance ) {
+      (*distance)[j] = dir.distance;
+    }
+    if ( bearing2 ) {
+      (*bearing2)[j] = dir.bearing2;
+    }
+  }
+}
+
+
+template <typename E, typename T> void
+inverse_lanes( const E& e,
+               const T lat1,
+               const T lon1,
+               const T lat2,
+               const T lon2,
+               T* bearing1,
+               T* distance,
+               T* bearing2,
+               const double accuracy,
+               const size_t m,
+               T* iterations = 0,
+               typename vmath::lanes<T>::mask* capped = 0 ) {
+  inverse_reduced_lanes( e, reduce(e,lat1,lon1), reduce(e,lat2,lon2),
+                         bearing1, distance, bearing2,
+                         accuracy, m, iterations, capped );
+}
+
+
+/*!
+ * @brief Direct formula for VINCENTY_LANES distances at the same time, from
+ * the origins in st.
+ *
+ * Same computation as direct_step(), the sigma iteration is masked per lane
+ * in the same way as in inverse_lanes(). The iterations and the lanes which
+ * did not converge are written to iterations and capped if non-null.
+ */
+template <typename E, typename T> void
+direct_step_lanes( const E& e,
+                   const direct_state<T>& st,
+                   const T s,
+                   T* lat2,
+                   T* lon2,
+                   const double accuracy,
+                   T* iterations = 0,
+                   typename vmath::lanes<T>::mask* capped = 0 ) {
+  typedef typename vmath::lanes<T>::scalar S;
+  typedef typename vmath::lanes<T>::mask M;
+
+  // The ellipsoid in the precision of the operands.
+  const S f  = e.f();
+  const S b  = e.b();
+
+  const T zero = vmath::lanes<T>::splat(0);
+  const T one  = vmath::lanes<T>::splat(1);
+
+  // Zero distances returns the position itself.
+  const M still = simd::ulpcmp(zero,s);
+
+  const T sigma0     = s / ( b * st.A );
+  T sigma            = sigma0;
+
+  T sin_sigma   = zero;
+  T cos_sigma   = one;
+  T cos_2sigmam = zero;
+
+  M active = ~still;
+  T delta  = zero;
+  T used   = zero;
+
+  // Same maximum number of iterations as direct().
+  for ( unsigned int i = 6; i && simd::any(active); --i ) {
+    used = simd::select(active,used+one,used);
+
+    T s_sigma;
+    T c_sigma;
+    vmath::sincos(sigma,&s_sigma,&c_sigma);
+
+    const T c_2sigmam = vmath::cos( 2*st.sigma1 + sigma );
+
+    const T delta_sigma =
+        deltasigma_full_precision(st.B,s_sigma,c_sigma,c_2sigmam);
+
+    // Only lanes still iterating are updated.
+    sin_sigma   = simd::select(active,s_sigma,sin_sigma);
+    cos_sigma   = simd::select(active,c_sigma,cos_sigma);
+    cos_2sigmam = simd::select(active,c_2sigmam,cos_2sigmam);
+
+    const T _sigma = sigma;
+    sigma  = simd::select(active,sigma0 + delta_sigma,sigma);
+    delta  = simd::select(active,simd::fabs(sigma-_sigma),delta);
+    active &= delta > S(accuracy);
+  }
+
+  if ( iterations ) {
+    *iterations = used;
+  }
+  if ( capped ) {
+    // Same ULP slack as direct_step().
+    *capped = active &
+        ( delta > S(accuracy) +
+          4*std::numeric_limits<S>::epsilon()*simd::fabs(sigma) );
+  }
+
+  const T C = st.C;
+
+  const T lambda =
+      vmath::atan2( sin_sigma*st.sin_alpha1,
+                   st.cos_U1*cos_sigma - st.sin_U1*sin_sigma*st.cos_alpha1 );
+
+  const T L =
+      lambda -
+      (1-C)*f*st.sin_alpha *
+      ( sigma +
+        C*sin_sigma * ( cos_2sigmam +
+                        C*cos_sigma * ( -1 +
+                                        2*cos_2sigmam*cos_2sigmam) ) );
+
+  const T tmp =  st.sin_U1*sin_sigma - st.cos_U1*cos_sigma*st.cos_alpha1;
+
+  const T phi =
+      vmath::atan2( st.sin_U1*cos_sigma + st.cos_U1*sin_sigma*st.cos_alpha1,
+                   (1-f)*simd::sqrt( st.sin_alpha*st.sin_alpha + tmp*tmp ) );
+
+  *lat2 = simd::select(still,st.lat,phi);
+  *lon2 = simd::select(still,st.lon,st.lon+L);
+}
+
+/*!
+ * @brief Direct formula for VINCENTY_LANES positions at the same time.
+ */
+template <typename E, typename T> void
+direct_lanes( const E& e,
+              const T lat,
+              const T lon,
+              const T alpha1,
+              const T s,
+              T* lat2,
+              T* lon2,
+              const double accuracy,
+              T* iterations = 0,
+              typename vmath::lanes<T>::mask* capped = 0 ) {
+  direct_state<T> st;
+  direct_setup(e,lat,lon,alpha1,&st);
+  direct_step_lanes(e,st,s,lat2,lon2,accuracy,iterations,capped);
+}
+
+
+/*!
+ * @brief Adds the iterations of the first m lanes to hist.
+ */
+template <typename T> inline void
+tally( vincenty::iteration_histogram* hist,
+       const T iterations,
+       const typename vmath::lanes<T>::mask capped,
+       const size_t m ) {
+  typedef typename vmath::lanes<T>::scalar S;
+  for ( size_t j=0; j<m && j<sizeof(T)/sizeof(S); ++j ) {
+    if ( capped[j] ) {
+      ++hist->capped;
+    } else {
+      ++hist->converged[static_cast<size_t>(iterations[j])];
+    }
+  }
+}
+
+//! The iterations are added to hist if non-null.
+template <typename E, typename S> void
+inverse_batch_kernel( const E& e,
+                      const S* lat1,
+                      const S* lon1,
+                      const S* lat2,
+                      const S* lon2,
+                      S* bearing1,
+                      S* distance,
+                      S* bearing2,
+                      const size_t n,
+                      const S accuracy,
+                      vincenty::iteration_histogram* hist ) {
+  typedef typename simd::packed<S>::type T;
+  typedef typename vmath::lanes<T>::mask M;
+  for ( size_t i=0; i<n; i+=simd::packed<S>::lanes ) {
+    const size_t m = n-i;
+    T p1p2, s, p2p1, iterations;
+    M capped;
+    inverse_lanes( e,
+                   simd::load(lat1+i,m),
+                   simd::load(lon1+i,m),
+                   simd::load(lat2+i,m),
+                   simd::load(lon2+i,m),
+                   bearing1 ? &p1p2 : 0,
+                   distance ? &s    : 0,
+                   bearing2 ? &p2p1 : 0,
+                   accuracy,
+                   m,
+                   hist ? &iterations : 0,
+                   hist ? &capped     : 0 );
+    if ( hist ) {
+      tally(hist,iterations,capped,m);
+    }
+    if ( bearing1 ) {
+      simd::store(bearing1+i,p1p2,m);
+    }
+    if ( distance ) {
+      simd::store(distance+i,s,m);
+    }
+    if ( bearing2 ) {
+      simd::store(bearing2+i,p2p1,m);
+    }
+  }
+}
+
+template <typename E, typename S> void
+inverse_batch_kernel( const E& e,
+                      const S* lat1,
+                      const S* lon1,
+                      const S* lat2,
+                      const S* lon2,
+                      S* bearing1,
+                      S* distance,
+                      S* bearing2,
+                      const size_t n,
+                      const S accuracy ) {
+  inverse_batch_kernel( e,
+                        lat1, lon1, lat2, lon2,
+                        bearing1, distance, bearing2,
+                        n, accuracy, 0 );
+}
+
+//! On WGS84, with the iterations added to hist.
+void
+inverse_histogram_kernel( const double* lat1,
+                          const double* lon1,
+                          const double* lat2,
+                          const double* lon2,
+                          double* bearing1,
+                          double* distance,
+                          double* bearing2,
+                          const size_t n,
+                          const double accuracy,
+                          vincenty::iteration_histogram* hist ) {
+  inverse_batch_kernel( vincenty::wgs84(),
+                        lat1, lon1, lat2, lon2,
+                        bearing1, distance, bearing2,
+                        n, accuracy, hist );
+}
+
+template <typename S> void
+inverse_batch_kernel( const S* lat1,
+                      const S* lon1,
+                      const S* lat2,
+                      const S* lon2,
+                      S* bearing1,
+                      S* distance,
+                      S* bearing2,
+                      const size_t n,
+                      const S accuracy ) {
+  inverse_batch_kernel( vincenty::wgs84(),
+                        lat1, lon1, lat2, lon2,
+                        bearing1, distance, bearing2,
+                        n, accuracy );
+}
+
+void
+inverse_positions_kernel( const vincenty::vposition* pos1,
+                          const vincenty::vposition* pos2,
+                          vincenty::vdirection* dirs,
+                          const size_t n,
+                          const double accuracy ) {
+  // Scatter the positions into structure-of-arrays form, VINCENTY_LANES pairs
+  // at the time so that the temporaries stays in registers.
+  for ( size_t i=0; i<n; i+=VINCENTY_LANES ) {
+    const size_t m = n-i < VINCENTY_LANES ? n-i : VINCENTY_LANES;
+    vdf lat1, lon1, lat2, lon2;
+    for ( size_t j=0; j<VINCENTY_LANES; ++j ) {
+      // Padding lanes repeats the first pair.
+      const size_t k = i + ( j<m ? j : 0 );
+      lat1[j] = pos1[k].coords.a[0];
+      lon1[j] = pos1[k].coords.a[1];
+      lat2[j] = pos2[k].coords.a[0];
+      lon2[j] = pos2[k].coords.a[1];
+    }
+    vdf p1p2, s, p2p1;
+    inverse_lanes( vincenty::wgs84(),
+                   lat1, lon1, lat2, lon2, &p1p2, &s, &p2p1, accuracy, m );
+    for ( size_t j=0; j<m; ++j ) {
+      dirs[i+j] = vincenty::vdirection(p1p2[j],s[j],p2p1[j]);
+    }
+  }
+}
+
+//! The iterations are added to hist if non-null.
+template <typename E, typename S> void
+direct_batch_kernel( const E& e,
+                     const S* lat,
+                     const S* lon,
+                     const S* bearing,
+                     const S* distance,
+                     S* lat2,
+                     S* lon2,
+                     const size_t n,
+                     const S accuracy,
+                     vincenty::iteration_histogram* hist ) {
+  typedef typename simd::packed<S>::type T;
+  typedef typename vmath::lanes<T>::mask M;
+  for ( size_t i=0; i<n; i+=simd::packed<S>::lanes ) {
+    const size_t m = n-i;
+    T phi, lambda, iterations;
+    M capped;
+    direct_lanes( e,
+                  simd::load(lat+i,m),
+                  simd::load(lon+i,m),
+                  simd::load(bearing+i,m),
+                  simd::load(distance+i,m),
+                  &phi, &lambda,
+                  accuracy,
+                  hist ? &iterations : 0,
+                  hist ? &capped     : 0 );
+    if ( hist ) {
+      tally(hist,iterations,capped,m);
+    }
+    simd::store(lat2+i,phi,m);
+    simd::store(lon2+i,lambda,m);
+  }
+}
+
+template <typename E, typename S> void
+direct_batch_kernel( const E& e,
+                     const S* lat,
+                     const S* lon,
+                     const S* bearing,
+                     const S* distance,
+                     S* lat2,
+                     S* lon2,
+                     const size_t n,
+                     const S accuracy ) {
+  direct_batch_kernel(e,lat,lon,bearing,distance,lat2,lon2,n,accuracy,0);
+}
+
+//! On WGS84, with the iterations added to hist.
+void
+direct_histogram_kernel( const double* lat,
+                         const double* lon,
+                         const double* bearing,
+                         const double* distance,
+                         double* lat2,
+                         double* lon2,
+                         const size_t n,
+                         const double accuracy,
+                         vincenty::iteration_histogram* hist ) {
+  direct_batch_kernel( vincenty::wgs84(),
+                       lat, lon, bearing, distance, lat2, lon2,
+                       n, accuracy, hist );
+}
+
+template <typename S> void
+direct_batch_kernel( const S* lat,
+                     const S* lon,
+                     const S* bearing,
+                     const S* distance,
+                     S* lat2,
+                     S* lon2,
+                     const size_t n,
+                     const S accuracy ) {
+  direct_batch_kernel( vincenty::wgs84(),
+                       lat, lon, bearing, distance,
+                       lat2, lon2,
+                       n, accuracy );
+}
+
+void
+direct_positions_kernel( const vincenty::vposition* pos,
+                         const vincenty::vdirection* dir,
+                         vincenty::vposition* dest,
+                         const size_t n,
+                         const double accuracy ) {
+  for ( size_t i=0; i<n; i+=VINCENTY_LANES ) {
+    const size_t m = n-i < VINCENTY_LANES ? n-i : VINCENTY_LANES;
+    vdf lat, lon, bearing, distance;
+    for ( size_t j=0; j<VINCENTY_LANES; ++j ) {
+      // Padding lanes repeats the first position.
+      const size_t k = i + ( j<m ? j : 0 );
+      lat[j]      = pos[k].coords.a[0];
+      lon[j]      = pos[k].coords.a[1];
+      bearing[j]  = dir[k].bearing1;
+      distance[j] = dir[k].distance;
+    }
+    vdf phi, lambda;
+    direct_lanes( vincenty::wgs84(),
+                  lat, lon, bearing, distance, &phi, &lambda, accuracy );
+    for ( size_t j=0; j<m; ++j ) {
+      dest[i+j] = vincenty::vposition(phi[j],lambda[j]);
+    }
+  }
+}
+
+// Fixed iteration inverse formula
+// ------------------------------------------------------------------------
+/*!
+ * @brief Exactly N iterations of lambda, no early exit and no branches.
+ *
+ * Same computation as inverse_iterate_lanes() but nothing is masked, every
+ * lane and every call does the same work. The equatorial line is blended
+ * and lanes set in equal only avoids the division by zero, the caller zeroes
+ * them. Same for scalars and vector operands, a constant N lets the compiler
+ * unroll the loop.
+ */
+template <unsigned int N, typename E, typename T> inline void
+inverse_iterate_fixed( const E& e,
+                       const reduced_position<T>& p1,
+                       const reduced_position<T>& p2,
+                       const typename vmath::lanes<T>::mask equal,
+                       inverse_state<T>* st ) {
+  typedef typename vmath::lanes<T>::scalar S;
+  typedef typename vmath::lanes<T>::mask M;
+
+  // The ellipsoid in the precision of the operands.
+  const S f = e.f();
+
+  const T zero = vmath::lanes<T>::splat(0);
+  const T one  = vmath::lanes<T>::splat(1);
+  const T tiny =
+      vmath::lanes<T>::splat(16*std::numeric_limits<S>::denorm_min());
+
+  const T cos_U1 = p1.cos_U;
+  const T cos_U2 = p2.cos_U;
+  const T sin_U1 = p1.sin_U;
+  const T sin_U2 = p2.sin_U;
+
+  const T L = p2.lon - p1.lon;
+  T lambda  = L;
+
+  for ( unsigned int i=0; i<N; ++i ) {
+    vmath::sincos(lambda,&st->sin_lambda,&st->cos_lambda);
+
+    const T t = cos_U1*sin_U2 - sin_U1*cos_U2*st->cos_lambda;
+    st->sin_sigma =
+        simd::sqrt( cos_U2*st->sin_lambda * cos_U2*st->sin_lambda + t*t );
+    st->cos_sigma = sin_U1*sin_U2 + cos_U1*cos_U2*st->cos_lambda;
+    st->sigma     = vmath::atan2( st->sin_sigma, st->cos_sigma );
+
+    const T sin_alpha =
+        cos_U1*cos_U2*st->sin_lambda / simd::select(equal,one,st->sin_sigma);
+    st->cos2_alpha = 1 - sin_alpha * sin_alpha;
+
+    const M equatorial =
+        ( st->cos2_alpha >= zero ) & ( st->cos2_alpha < tiny );
+    st->cos_2sigmam =
+        simd::select( equatorial,
+                      zero,
+                      st->cos_sigma - 2*sin_U1*sin_U2 /
+                      simd::select(equatorial,one,st->cos2_alpha) );
+
+    const T C = f/16 * st->cos2_alpha * ( 4 + f * (4 - 3*st->cos2_alpha) );
+    lambda =
+        L + (1-C) * f * sin_alpha *
+        ( st->sigma + C * st->sin_sigma *
+          ( st->cos_2sigmam + C * st->cos_sigma *
+            ( -1 + 2 * st->cos_2sigmam*st->cos_2sigmam ) ) );
+  }
+
+  st->sin_U1 = sin_U1;
+  st->cos_U1 = cos_U1;
+  st->sin_U2 = sin_U2;
+  st->cos_U2 = cos_U2;
+}
+
+template <unsigned int N> vincenty::vdirection
+inverse_fixed_kernel( const double lat1,
+                      const double lon1,
+                      const double lat2,
+                      const double lon2 ) {
+  const vincenty::wgs84 e;
+  const bool equal =
+      simd::ulpcmp(lat1,lat2,identical<double>::ulps) &
+      simd::ulpcmp(lon1,lon2,identical<double>::ulps);
+
+  inverse_state<double> st;
+  inverse_iterate_fixed<N>( e, reduce(e,lat1,lon1), reduce(e,lat2,lon2),
+                            equal, &st );
+  return vincenty::vdirection(
+      simd::select(equal,0.0,inverse_bearing1(st)),
+      simd::select(equal,0.0,inverse_distance(e,st)),
+      simd::select(equal,0.0,inverse_bearing2(st)) );
+}
+
+template <unsigned int N> void
+inverse_batch_fixed_kernel( const double* lat1,
+                            const double* lon1,
+                            const double* lat2,
+                            const double* lon2,
+                            double* bearing1,
+                            double* distance,
+                            double* bearing2,
+                            const size_t n ) {
+  const vincenty::wgs84 e;
+  const vdf zero = simd::set1(0.0);
+  for ( size_t i=0; i<n; i+=VINCENTY_LANES ) {
+    const size_t m = n-i;
+    const reduced_position<vdf> p1 =
+        reduce(e,simd::load(lat1+i,m),simd::load(lon1+i,m));
+    const reduced_position<vdf> p2 =
+        reduce(e,simd::load(lat2+i,m),simd::load(lon2+i,m));
+    const vdi equal =
+        simd::ulpcmp(p1.lat,p2.lat,identical<double>::ulps) &
+        simd::ulpcmp(p1.lon,p2.lon,identical<double>::ulps);
+
+    inverse_state<vdf> st;
+    inverse_iterate_fixed<N>(e,p1,p2,equal,&st);
+    if ( bearing1 ) {
+      simd::store(bearing1+i,simd::select(equal,zero,inverse_bearing1(st)),m);
+    }
+    if ( distance ) {
+      simd::store(distance+i,simd::select(equal,zero,inverse_distance(e,st)),m);
+    }
+    if ( bearing2 ) {
+      simd::store(bearing2+i,simd::select(equal,zero,inverse_bearing2(st)),m);
+    }
+  }
+}
+
+// vincenty::prepared_position
+// ------------------------------------------------------------------------
+inline reduced_position<double>
+reduced( const vincenty::prepared_position& pos ) {
+  reduced_position<double> r;
+  r.lat   = pos.position.coords.a[0];
+  r.lon   = pos.position.coords.a[1];
+  r.sin_U = pos.sin_U;
+  r.cos_U = pos.cos_U;
+  return r;
+}
+
+void
+prepare_kernel( const double lat, double* sin_U, double* cos_U ) {
+  const reduced_position<double> r = reduce(vincenty::wgs84(),lat,0.0);
+  *sin_U = r.sin_U;
+  *cos_U = r.cos_U;
+}
+
+vincenty::vdirection
+inverse_prepared_kernel( const vincenty::prepared_position& pos1,
+                         const vincenty::prepared_position& pos2,
+                         const double accuracy ) {
+  return inverse_reduced( vincenty::wgs84(), reduced(pos1), reduced(pos2),
+                          accuracy );
+}
+
+void
+inverse_one_to_many_kernel( const vincenty::prepared_position& origin,
+                            const vincenty::vposition* targets,
+                            vincenty::vdirection* dirs,
+                            double* distance,
+                            const size_t n,
+                            const double accuracy ) {
+  const vincenty::wgs84 e;
+
+  // The origin is the same in all lanes and already reduced, it is broadcast
+  // once and stays in registers for the whole loop.
+  const reduced_position<double> o = reduced(origin);
+  reduced_position<vdf> p1;
+  p1.lat   = simd::set1(o.lat);
+  p1.lon   = simd::set1(o.lon);
+  p1.sin_U = simd::set1(o.sin_U);
+  p1.cos_U = simd::set1(o.cos_U);
+
+  for ( size_t i=0; i<n; i+=VINCENTY_LANES ) {
+    const size_t m = n-i < VINCENTY_LANES ? n-i : VINCENTY_LANES;
+    vdf lat2, lon2;
+    for ( size_t j=0; j<VINCENTY_LANES; ++j ) {
+      // Padding lanes repeats the first target.
+      const size_t k = i + ( j<m ? j : 0 );
+      lat2[j] = targets[k].coords.a[0];
+      lon2[j] = targets[k].coords.a[1];
+    }
+    vdf p1p2, s, p2p1;
+    inverse_reduced_lanes( e, p1, reduce(e,lat2,lon2),
+                           dirs ? &p1p2 : 0, &s, dirs ? &p2p1 : 0,
+                           accuracy, m );
+    if ( dirs ) {
+      for ( size_t j=0; j<m; ++j ) {
+        dirs[i+j] = vincenty::vdirection(p1p2[j],s[j],p2p1[j]);
+      }
+    }
+    if ( distance ) {
+      simd::store(distance+i,s,m);
+    }
+  }
+}
+
+// vincenty::distance_matrix
+// ------------------------------------------------------------------------
+template <typename O> inline void
+store_lanes( O* p, const vdf x, const size_t n ) {
+  for ( size_t j=0; j<n && j<VINCENTY_LANES; ++j ) {
+    p[j] = static_cast<O>(x[j]);
+  }
+}
+
+template <> inline void
+store_lanes( double* p, const vdf x, const size_t n ) {
+  simd::store(p,x,n);
+}
+
+/*!
+ * @brief One row segment of a distance matrix, from site i of from to the
+ * sites [begin,end) of to. The outputs points at the element of site begin,
+ * those which are null are not computed.
+ *
+ * Both sets are already reduced. The row broadcasts its site, like the
+ * origin of inverse_one_to_many_kernel(), and the columns are loaded straight
+ * from the arrays of the set.
+ */
+template <typename O> void
+distance_row_kernel( const vincenty::prepared_sites& from,
+                     const size_t i,
+                     const vincenty::prepared_sites& to,
+                     const size_t begin,
+                     const size_t end,
+                     O* bearing1,
+                     O* distance,
+                     O* bearing2,
+                     const double accuracy ) {
+  const vincenty::wgs84 e;
+  reduced_position<vdf> p1;
+  p1.lat   = simd::set1(from.lat()[i]);
+  p1.lon   = simd::set1(from.lon()[i]);
+  p1.sin_U = simd::set1(from.sin_U()[i]);
+  p1.cos_U = simd::set1(from.cos_U()[i]);
+
+  for ( size_t j=begin; j<end; j+=VINCENTY_LANES ) {
+    const size_t m = end - j;
+    reduced_position<vdf> p2;
+    p2.lat   = simd::load(to.lat()+j,m);
+    p2.lon   = simd::load(to.lon()+j,m);
+    p2.sin_U = simd::load(to.sin_U()+j,m);
+    p2.cos_U = simd::load(to.cos_U()+j,m);
+    vdf p1p2, s, p2p1;
+    inverse_reduced_lanes( e, p1, p2,
+                           bearing1 ? &p1p2 : 0, &s, bearing2 ? &p2p1 : 0,
+                           accuracy, m );
+    if ( bearing1 ) {
+      store_lanes(bearing1+(j-begin),p1p2,m);
+    }
+    if ( distance ) {
+      store_lanes(distance+(j-begin),s,m);
+    }
+    if ( bearing2 ) {
+      store_lanes(bearing2+(j-begin),p2p1,m);
+    }
+  }
+}
+
+// vincenty/ecef.h
+// ------------------------------------------------------------------------
+
+//! Earth-centered Earth-fixed coordinates on WGS84, no branches.
+template <typename T> inline void
+ecef_lanes( const T lat, const T lon, T* x, T* y, T* z ) {
+  const double a  = vincenty::wgs84::a();
+  const double f  = vincenty::wgs84::f();
+  const double e2 = f * ( 2 - f );
+
+  T sin_lat, cos_lat, sin_lon, cos_lon;
+  vmath::sincos(lat,&sin_lat,&cos_lat);
+  vmath::sincos(lon,&sin_lon,&cos_lon);
+
+  const T N = a / simd::sqrt( 1 - e2 * sin_lat * sin_lat );
+  *x = N * cos_lat * cos_lon;
+  *y = N * cos_lat * sin_lon;
+  *z = N * ( 1 - e2 ) * sin_lat;
+}
+
+void
+ecef_kernel( const double* lat,
+             const double* lon,
+             double* x,
+             double* y,
+             double* z,
+             const size_t n ) {
+  for ( size_t i=0; i<n; i+=VINCENTY_LANES ) {
+    const size_t m = n-i;
+    vdf X, Y, Z;
+    ecef_lanes( simd::load(lat+i,m), simd::load(lon+i,m), &X, &Y, &Z );
+    simd::store(x+i,X,m);
+    simd::store(y+i,Y,m);
+    simd::store(z+i,Z,m);
+  }
+}
+
+void
+chord_classify_kernel( const double* center,
+                       const double* x,
+                       const double* y,
+                       const double* z,
+                       const size_t n,
+                       const double inside2,
+                       const double outside2,
+                       unsigned char* cls ) {
+  const vdf cx = simd::set1(center[0]);
+  const vdf cy = simd::set1(center[1]);
+  const vdf cz = simd::set1(center[2]);
+  for ( size_t i=0; i<n; i+=VINCENTY_LANES ) {
+    const size_t m = n-i;
+    const vdf dx = simd::load(x+i,m) - cx;
+    const vdf dy = simd::load(y+i,m) - cy;
+    const vdf dz = simd::load(z+i,m) - cz;
+    const vdf c2 = dx*dx + dy*dy + dz*dz;
+    for ( size_t j=0; j<m && j<VINCENTY_LANES; ++j ) {
+      cls[i+j] = c2[j] < inside2 ? 1 : ( c2[j] > outside2 ? 0 : 2 );
+    }
+  }
+}
+
+// vincenty::geodesic_line
+// ------------------------------------------------------------------------
+template <typename T> inline void
+line_state( const vincenty::geodesic_line::state& line, direct_state<T>* st ) {
+  st->lat        = vmath::lanes<T>::splat(line.lat);
+  st->lon        = vmath::lanes<T>::splat(line.lon);
+  st->cos_U1     = vmath::lanes<T>::splat(line.cos_U1);
+  st->sin_U1     = vmath::lanes<T>::splat(line.sin_U1);
+  st->sin_alpha1 = vmath::lanes<T>::splat(line.sin_alpha1);
+  st->cos_alpha1 = vmath::lanes<T>::splat(line.cos_alpha1);
+  st->sigma1     = vmath::lanes<T>::splat(line.sigma1);
+  st->sin_alpha  = vmath::lanes<T>::splat(line.sin_alpha);
+  st->cos2_alpha = vmath::lanes<T>::splat(line.cos2_alpha);
+  st->A          = vmath::lanes<T>::splat(line.A);
+  st->B          = vmath::lanes<T>::splat(line.B);
+  st->C          = vmath::lanes<T>::splat(line.C);
+}
+
+void
+line_setup_kernel( const double lat,
+                   const double lon,
+                   const double bearing,
+                   vincenty::geodesic_line::state* line ) {
+  direct_state<double> st;
+  direct_setup(vincenty::wgs84(),lat,lon,bearing,&st);
+  line->lat        = st.lat;
+  line->lon        = st.lon;
+  line->cos_U1     = st.cos_U1;
+  line->sin_U1     = st.sin_U1;
+  line->sin_alpha1 = st.sin_alpha1;
+  line->cos_alpha1 = st.cos_alpha1;
+  line->sigma1     = st.sigma1;
+  line->sin_alpha  = st.sin_alpha;
+  line->cos2_alpha = st.cos2_alpha;
+  line->A          = st.A;
+  line->B          = st.B;
+  line->C          = st.C;
+}
+
+vincenty::vposition
+line_position_kernel( const vincenty::geodesic_line::state& line,
+                      const double distance,
+                      const double accuracy ) {
+  direct_state<double> st;
+  line_state(line,&st);
+  return direct_step(vincenty::wgs84(),st,distance,accuracy);
+}
+
+void
+line_positions_kernel( const vincenty::geodesic_line::state& line,
+                       const double* distance,
+                       double* lat,
+                       double* lon,
+                       const size_t n,
+                       const double accuracy ) {
+  // The origin is the same in all lanes, only the distances are loaded.
+  direct_state<vdf> st;
+  line_state(line,&st);
+  for ( size_t i=0; i<n; i+=VINCENTY_LANES ) {
+    const size_t m = n-i;
+    vdf phi, lambda;
+    direct_step_lanes( vincenty::wgs84(),
+                       st, simd::load(distance+i,m), &phi, &lambda, accuracy );
+    simd::store(lat+i,phi,m);
+    simd::store(lon+i,lambda,m);
+  }
+}
+
+} // namespace end
+
+const kernel_table VINCENTY_KERNEL_TABLE = {
+  VINCENTY_KERNEL_ISA,
+  &direct_kernel<double>,
+  &inverse_kernel<double>,
+  &inverse_status_kernel<double>,
+  &direct_convergence_kernel<double>,
+  &inverse_convergence_kernel<double>,
+  &distance_kernel<double>,
+  &bearing_kernel<double>,
+  &direct_kernel<vincenty::ellipsoid,double>,
+  &inverse_kernel<vincenty::ellipsoid,double>,
+  &direct_batch_kernel<vincenty::ellipsoid,double>,
+  &inverse_batch_kernel<vincenty::ellipsoid,double>,
+  { &direct_kernel<vincenty::grs80,double>,
+    &inverse_kernel<vincenty::grs80,double>,
+    &direct_batch_kernel<vincenty::grs80,double>,
+    &inverse_batch_kernel<vincenty::grs80,double> },
+  { &direct_kernel<vincenty::bessel1841,double>,
+    &inverse_kernel<vincenty::bessel1841,double>,
+    &direct_batch_kernel<vincenty::bessel1841,double>,
+    &inverse_batch_kernel<vincenty::bessel1841,double> },
+  &direct_histogram_kernel,
+  &inverse_histogram_kernel,
+  &direct_batch_kernel<double>,
+  &inverse_batch_kernel<double>,
+  &direct_positions_kernel,
+  &inverse_positions_kernel,
+  &direct_kernel<float>,
+  &inverse_kernel<float>,
+  &direct_batch_kernel<float>,
+  &inverse_batch_kernel<float>,
+  &prepare_kernel,
+  &inverse_prepared_kernel,
+  &inverse_one_to_many_kernel,
+  &distance_row_kernel<double>,
+  &distance_row_kernel<float>,
+  &ecef_kernel,
+  &chord_classify_kernel,
+  &line_setup_kernel,
+  &line_position_kernel,
+  &line_positions_kernel,
+  { 0,
+    &inverse_fixed_kernel<1>,
+    &inverse_fixed_kernel<2>,
+    &inverse_fixed_kernel<3>,
+    &inverse_fixed_kernel<4>,
+    &inverse_fixed_kernel<5>,
+    &inverse_fixed_kernel<6>,
+    &inverse_fixed_kernel<7>,
+    &inverse_fixed_kernel<8> },
+  { 0,
+    &inverse_batch_fixed_kernel<1>,
+    &inverse_batch_fixed_kernel<2>,
+    &inverse_batch_fixed_kernel<3>,
+    &inverse_batch_fixed_kernel<4>,
+    &inverse_batch_fixed_kernel<5>,
+    &inverse_batch_fixed_kernel<6>,
+    &inverse_batch_fixed_kernel<7>,
+    &inverse_batch_fixed_kernel<8> }
+};
+
+#endif
@@ -0,0 +1,38 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+/*
+  AVX2 copy of the kernels with four double lanes. FMA is enabled too, the
+  dispatch only picks this copy on hosts having both.
+*/
+
+// Shared headers first, they must not be compiled for the raised target.
+#include "vincenty/vincenty.h"
+#include "vincenty_dispatch.h"
+
+#include <cmath>
+#include <immintrin.h>
+#include <limits>
+
+#pragma GCC target("avx2,fma")
+#define VINCENTY_LANES        4
+#define VINCENTY_KERNEL_ISA   vincenty::isa_avx2
+#define VINCENTY_KERNEL_TABLE kernels_avx2
+
+#include "vincenty_kernels.h"
@@ -0,0 +1,38 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+/*
+  Baseline copy of the kernels, SSE2 with two double lanes. Used on any
+  x86-64 host without AVX2 and FMA.
+*/
+
+// Shared headers first, they must not be compiled for the raised target.
+#include "vincenty/vincenty.h"
+#include "vincenty_dispatch.h"
+
+#include <cmath>
+#include <immintrin.h>
+#include <limits>
+
+// Baseline x86-64, no target raised.
+#define VINCENTY_LANES        2
+#define VINCENTY_KERNEL_ISA   vincenty::isa_sse2
+#define VINCENTY_KERNEL_TABLE kernels_sse2
+
+#include "vincenty_kernels.h"
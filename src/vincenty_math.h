@@ -0,0 +1,380 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+/*
+  Internal header with polynomial versions of the transcendental functions
+  used by the formulas. Everything is written as templates over the operand
+  type, the same code is used for plain doubles and for the vector operands
+  in the batch functions. No branches depend on the argument, the different
+  ranges are blended, so the vector versions compile to straight SSE2, AVX2
+  or AVX-512 code depending on the target of the including translation unit
+  (anonymous namespace for the same reason as in vincenty_simd.h).
+
+  The coefficients are the ones from the Cephes library (S. L. Moshier).
+
+  Error bounds, measured against the 80-bit long double libm functions over
+  the stated ranges, in units in last place (ULP) of the double result:
+
+    sin, cos, sincos  |x| < 1e5         < 1 ULP
+    tan               |x| < 1e5         < 2.5 ULP
+    atan              all x             < 1 ULP
+    atan2             all y,x           < 2 ULP
+
+  The single precision versions, selected by the operand type, are measured
+  against the double C library in units of the float result:
+
+    sin, cos, sincos  |x| < 4*pi        < 2 ULP
+    tan               |x| < 1.5         < 4 ULP
+    atan              all x             < 3 ULP
+    atan2             all y,x           < 3.5 ULP
+
+  The float reduction is only good for a few turns, beyond 4*pi the error
+  grows quickly. The formulas never go there.
+
+  Larger arguments to sin and cos looses accuracy since the argument
+  reduction uses a three part Cody-Waite constant. All angles handled by the
+  formulas are within a few turns so this is never an issue.
+*/
+
+#ifndef __vincenty_math_h__
+#define __vincenty_math_h__
+
+#include "vincenty_simd.h"
+
+namespace {
+
+namespace vmath {
+
+/*!
+ * @brief Operand traits, maps an operand type to its element, mask and
+ * integer types.
+ *
+ * Comparing two doubles gives a bool while comparing two vector operands
+ * gives an integer vector. The traits hides that difference.
+ */
+template <typename T> struct lanes;
+
+template <> struct lanes<double>
+{
+  typedef double  scalar;
+  typedef bool    mask;
+  typedef int64_t integer;
+
+  static double splat( const double x ) {
+    return x;
+  }
+
+  static integer bits( const double x ) {
+    union { double d; integer i; } u;
+    u.d = x;
+    return u.i;
+  }
+};
+
+template <> struct lanes<float>
+{
+  typedef float   scalar;
+  typedef bool    mask;
+  typedef int32_t integer;
+
+  static float splat( const float x ) {
+    return x;
+  }
+
+  static integer bits( const float x ) {
+    union { float d; integer i; } u;
+    u.d = x;
+    return u.i;
+  }
+};
+
+template <> struct lanes<vdf>
+{
+  typedef double scalar;
+  typedef vdi    mask;
+  typedef vdi    integer;
+
+  static vdf splat( const double x ) {
+    return simd::set1(x);
+  }
+
+  static integer bits( const vdf x ) {
+    return (integer)x;
+  }
+};
+
+template <> struct lanes<vsf>
+{
+  typedef float scalar;
+  typedef vsi   mask;
+  typedef vsi   integer;
+
+  static vsf splat( const float x ) {
+    return simd::set1(x);
+  }
+
+  static integer bits( const vsf x ) {
+    return (integer)x;
+  }
+};
+
+//! 1.5*2^52, adding and subtracting it rounds to the nearest integer.
+const double round_magic = 6755399441055744.0;
+
+// Pi/2 split in three parts, the two first parts have enough trailing zeros
+// that multiplying them with the quadrant number is exact.
+const double pio2_1 = 1.57079625129699707031e+00;
+const double pio2_2 = 7.54978941586159635336e-08;
+const double pio2_3 = 5.39030285815811905290e-15;
+
+//! Bits lost when rounding pi/2 into a double.
+const double pio2_lo = 6.123233995736765886130e-17;
+
+//! tan(3*pi/8)
+const double tan3pio8 = 2.41421356237309504880e+00;
+
+//! 1.5*2^23, the single precision round_magic.
+const float round_magic_f = 12582912.0f;
+
+// Pi/2 split in three floats, as above.
+const float pio2_1f = 1.5703125f;
+const float pio2_2f = 4.837512969970703125e-4f;
+const float pio2_3f = 7.54978995489188216e-8f;
+
+/*!
+ * @brief Sine and cosine computed at the same time.
+ *
+ * The argument is reduced to [-pi/4,pi/4] and the quadrant. Both polynomials
+ * are always evaluated and then swapped and negated depending on the
+ * quadrant.
+ */
+template <typename T> inline void
+sincos_kernel( const T x, T* sinx, T* cosx, double ) {
+  typedef typename lanes<T>::mask mask;
+  typedef typename lanes<T>::integer integer;
+
+  // Nearest quadrant, the two low bits of the rounded value is the quadrant
+  // number modulo 4.
+  const T qm = x * M_2_PI + round_magic;
+  const integer q = lanes<T>::bits(qm);
+  const T j = qm - round_magic;
+
+  // The reduced argument is kept as r + lo, the rounding errors from the
+  // subtractions would otherwise cost about one bit. (And all bits close to
+  // the zeros).
+  const T t0 = x - j*pio2_1;
+  const T t1 = t0 - j*pio2_2;
+  const T r  = t1 - j*pio2_3;
+  const T lo = ( ( t0 - t1 ) - j*pio2_2 ) + ( ( t1 - r ) - j*pio2_3 );
+  const T z  = r*r;
+
+  // The rounding error from 1 - z/2 is added back, as in fdlibm, or the cosine
+  // looses almost one bit close to pi/4.
+  const T hz = 0.5*z;
+  const T w  = 1 - hz;
+
+  const T s = r + ( r*z *
+      ( -1.66666666666666307295e-01 + z *
+        (  8.33333333332211858878e-03 + z *
+           ( -1.98412698295895385996e-04 + z *
+             (  2.75573136213857245213e-06 + z *
+                ( -2.50507477628578072866e-08 + z *
+                  1.58962301576546568060e-10 ) ) ) ) ) + lo*w );
+
+  const T c = w + ( ( ( ( 1 - w ) - hz ) + z*z *
+      (  4.16666666666665929218e-02 + z *
+         ( -1.38888888888730564116e-03 + z *
+           (  2.48015872888517045348e-05 + z *
+              ( -2.75573141792967388112e-07 + z *
+                (  2.08757008419747316778e-09 + z *
+                   -1.13585365213876817300e-11 ) ) ) ) ) ) - r*lo );
+
+  const mask swap     = ( q & 1 ) != 0;
+  const mask sin_sign = ( q & 2 ) != 0;
+  const mask cos_sign = ( ( q + 1 ) & 2 ) != 0;
+
+  const T sv = swap ? c : s;
+  const T cv = swap ? s : c;
+  *sinx = sin_sign ? -sv : sv;
+  *cosx = cos_sign ? -cv : cv;
+}
+
+/*!
+ * @brief Single precision sine and cosine, same structure as the double
+ * version with shorter polynomials and no correction terms.
+ */
+template <typename T> inline void
+sincos_kernel( const T x, T* sinx, T* cosx, float ) {
+  typedef typename lanes<T>::mask mask;
+  typedef typename lanes<T>::integer integer;
+
+  const T qm = x * float(M_2_PI) + round_magic_f;
+  const integer q = lanes<T>::bits(qm);
+  const T j = qm - round_magic_f;
+
+  const T r = ( ( x - j*pio2_1f ) - j*pio2_2f ) - j*pio2_3f;
+  const T z = r*r;
+
+  const T s = r + r*z *
+      ( ( -1.9515295891e-4f * z + 8.3321608736e-3f ) * z - 1.6666654611e-1f );
+  const T c = 1 - 0.5f*z + z*z *
+      ( ( 2.443315711809948e-5f * z - 1.388731625493765e-3f ) * z +
+        4.166664568298827e-2f );
+
+  const mask swap     = ( q & 1 ) != 0;
+  const mask sin_sign = ( q & 2 ) != 0;
+  const mask cos_sign = ( ( q + 1 ) & 2 ) != 0;
+
+  const T sv = swap ? c : s;
+  const T cv = swap ? s : c;
+  *sinx = sin_sign ? -sv : sv;
+  *cosx = cos_sign ? -cv : cv;
+}
+
+/*!
+ * @brief Sine and cosine in the precision of the operand type.
+ */
+template <typename T> inline void
+sincos( const T x, T* sinx, T* cosx ) {
+  sincos_kernel( x, sinx, cosx, typename lanes<T>::scalar() );
+}
+
+template <typename T> inline T
+sin( const T x ) {
+  T s, c;
+  sincos(x,&s,&c);
+  return s;
+}
+
+template <typename T> inline T
+cos( const T x ) {
+  T s, c;
+  sincos(x,&s,&c);
+  return c;
+}
+
+template <typename T> inline T
+tan( const T x ) {
+  T s, c;
+  sincos(x,&s,&c);
+  return s / c;
+}
+
+/*!
+ * @brief Arc tangent.
+ *
+ * The absolute value is reduced to [0,0.66] by either atan(x) = pi/2 -
+ * atan(1/x) or atan(x) = pi/4 + atan((x-1)/(x+1)). A rational function is
+ * used on the reduced range.
+ */
+template <typename T> inline T
+atan_kernel( const T x, double ) {
+  typedef typename lanes<T>::mask mask;
+
+  const T zero = lanes<T>::splat(0.0);
+  const T ax   = x < zero ? -x : x;
+
+  const mask big = ax > tan3pio8;
+  const mask mid = !big && ax > 0.66;
+
+  // Both reductions are computed, the divisions by zero in unused lanes are
+  // harmless.
+  const T xr =
+      big ? -1/ax : mid ? (ax-1)/(ax+1) : ax;
+  const T y0 =
+      big ? lanes<T>::splat(M_PI_2) : mid ? lanes<T>::splat(M_PI_4) : zero;
+  const T lo =
+      big ? lanes<T>::splat(pio2_lo) : mid ? lanes<T>::splat(0.5*pio2_lo) : zero;
+
+  const T z = xr*xr;
+  const T p =
+      ( ( ( -8.750608600031904122785e-01 * z +
+            -1.615753718733365076637e+01 ) * z +
+          -7.500855792314704667340e+01 ) * z +
+        -1.228866684490136173410e+02 ) * z +
+      -6.485021904942025371773e+01;
+  const T q =
+      ( ( ( ( z +
+              2.485846490142306297962e+01 ) * z +
+            1.650270098316988542046e+02 ) * z +
+          4.328810604912902668951e+02 ) * z +
+        4.853903996359136964868e+02 ) * z +
+      1.945506571482613964425e+02;
+
+  const T y = y0 + ( ( xr*z*p/q + xr ) + lo );
+  return lanes<T>::bits(x) < 0 ? -y : y;
+}
+
+/*!
+ * @brief Single precision arc tangent, same reductions as the double
+ * version with a polynomial on the reduced range.
+ */
+template <typename T> inline T
+atan_kernel( const T x, float ) {
+  typedef typename lanes<T>::mask mask;
+
+  const T zero = lanes<T>::splat(0.0f);
+  const T ax   = x < zero ? -x : x;
+
+  const mask big = ax > float(tan3pio8);
+  const mask mid = !big && ax > 0.4142135623730950f;
+
+  const T xr =
+      big ? -1/ax : mid ? (ax-1)/(ax+1) : ax;
+  const T y0 =
+      big ? lanes<T>::splat(M_PI_2) : mid ? lanes<T>::splat(M_PI_4) : zero;
+
+  const T z = xr*xr;
+  const T y = y0 + ( xr + xr*z *
+      ( ( ( 8.05374449538e-2f * z - 1.38776856032e-1f ) * z +
+          1.99777106478e-1f ) * z - 3.33329491539e-1f ) );
+  return lanes<T>::bits(x) < 0 ? -y : y;
+}
+
+/*!
+ * @brief Arc tangent in the precision of the operand type.
+ */
+template <typename T> inline T
+atan( const T x ) {
+  return atan_kernel( x, typename lanes<T>::scalar() );
+}
+
+/*!
+ * @brief Arc tangent of y/x using the signs to find the quadrant.
+ *
+ * Same result as the C library atan2 for all finite arguments, signed zeros
+ * included. The quadrant is taken from the sign bits, x = -0 is to the left.
+ */
+template <typename T> inline T
+atan2( const T y, const T x ) {
+  const T zero = lanes<T>::splat(0.0);
+  const T pi   = lanes<T>::splat(M_PI);
+
+  // 0/0 gives nan, take y which is +-0 as the C library does.
+  const T z = atan( ( y == zero && x == zero ) ? y : y/x );
+  const T w = lanes<T>::bits(y) < 0 ? -pi : pi;
+  return lanes<T>::bits(x) < 0 ? z + w : z;
+}
+
+} // namespace end
+
+} // namespace end
+
+#endif
@@ -0,0 +1,98 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+/*
+  Internal header, the per thread counters behind vincenty/metrics.h. The
+  counting macros expand to nothing when VINCENTY_NO_METRICS is defined.
+*/
+
+#ifndef __vincenty_metrics_h__
+#define __vincenty_metrics_h__
+
+#include "vincenty/metrics.h"
+#include "vincenty/vincenty.h"
+
+#pragma GCC visibility push(hidden)
+
+// The counters of one thread. Only the owning thread writes them, metrics()
+// reads them from any thread, hence the relaxed atomic stores and loads.
+struct metric_counters
+{
+  uint64_t direct_calls;
+  uint64_t inverse_calls;
+  uint64_t iterations;
+  uint64_t not_converged;
+  uint64_t grid_splits;
+  uint64_t grid_positions;
+  uint64_t grid_lookups;
+
+  metric_counters* next;
+};
+
+extern __thread metric_counters* thread_metrics;
+
+// Allocates and registers the counters of the calling thread.
+metric_counters* register_metrics();
+
+inline metric_counters&
+local_metrics() {
+  metric_counters* c = thread_metrics;
+  return *( c ? c : register_metrics() );
+}
+
+inline void
+add_metric( uint64_t& counter, const uint64_t n ) {
+  __atomic_store_n( &counter, counter + n, __ATOMIC_RELAXED );
+}
+
+inline void
+add_iterations( const vincenty::convergence& info ) {
+  metric_counters& c = local_metrics();
+  add_metric( c.iterations, info.iterations );
+  add_metric( c.not_converged, info.converged ? 0 : 1 );
+}
+
+// The histogram does not keep the iterations of capped results, they all
+// used the limit.
+inline void
+add_iterations( const vincenty::iteration_histogram& hist,
+                const unsigned int limit ) {
+  uint64_t n = uint64_t(hist.capped) * limit;
+  for ( size_t i=0; i<vincenty::iteration_histogram::bins; ++i ) {
+    n += uint64_t(hist.converged[i]) * i;
+  }
+  metric_counters& c = local_metrics();
+  add_metric( c.iterations, n );
+  add_metric( c.not_converged, hist.capped );
+}
+
+#pragma GCC visibility pop
+
+#ifdef VINCENTY_NO_METRICS
+#define VINCENTY_COUNT(counter,n) ((void)0)
+#define VINCENTY_COUNT_ITERATIONS(info) ((void)0)
+#define VINCENTY_COUNT_HISTOGRAM(hist,limit) ((void)0)
+#else
+#define VINCENTY_COUNT(counter,n) add_metric( local_metrics().counter, (n) )
+#define VINCENTY_COUNT_ITERATIONS(info) add_iterations( (info) )
+#define VINCENTY_COUNT_HISTOGRAM(hist,limit) add_iterations( (hist), (limit) )
+#endif
+
+#endif
@@ -0,0 +1,50 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+/*
+  Internal header, the work stealing pool behind vincenty/parallel.h. Other
+  parts of the library run their loops on it through parallel_for().
+*/
+
+#ifndef __vincenty_parallel_h__
+#define __vincenty_parallel_h__
+
+#include <cstddef>
+
+#pragma GCC visibility push(hidden)
+
+//! Work on the elements [begin,end) of a parallel_for().
+typedef void (*parallel_task)( void* context, size_t begin, size_t end );
+
+/*
+  Runs task on [0,n) in chunks of chunk elements, on threads workers (0 for
+  default_threads()) of which the calling thread is one. Returns when all
+  chunks are done. Runs everything on the calling thread if the pool is
+  busy, e.g. when called from within a task.
+*/
+void parallel_for( const size_t n,
+                   const size_t chunk,
+                   const unsigned int threads,
+                   parallel_task task,
+                   void* context );
+
+#pragma GCC visibility pop
+
+#endif
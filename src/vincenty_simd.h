@@ -0,0 +1,275 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2; -*-
+
+/*
+  Copyright (C) 2009, 2010, 2011, 2012, 2013, anders.ronnbrant@gmail.com
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  You should have received a copy of the FreeBSD license, if not see:
+  <http://www.freebsd.org/copyright/freebsd-license.html>.
+*/
+
+/*
+  Internal header with the vector operands used by the batch functions. The
+  types are plain GCC vector extensions sized to VINCENTY_LANES doubles, or
+  twice as many floats in the same register.
+
+  The header is compiled once per instruction set, see vincenty_kernels.h.
+  Everything is therefore put in an anonymous namespace, each translation
+  unit gets a private copy compiled for its own target and the linker can
+  never pick, say, the AVX-512 copy of an inline function for the SSE2
+  kernels.
+*/
+
+#ifndef __vincenty_simd_h__
+#define __vincenty_simd_h__
+
+#include "vincenty_internal.h"
+
+#include <cmath>
+#include <immintrin.h>
+
+//! Number of double lanes processed at the same time by the batch functions,
+//! defaults to a SSE2 register.
+#ifndef VINCENTY_LANES
+#define VINCENTY_LANES 2
+#endif
+
+//! Number of float lanes, a register holds twice as many floats.
+#define VINCENTY_FLOAT_LANES (2*VINCENTY_LANES)
+
+namespace {
+
+typedef double   vdf __attribute__((vector_size(VINCENTY_LANES*8)));
+typedef int64_t  vdi __attribute__((vector_size(VINCENTY_LANES*8)));
+typedef uint64_t vdu __attribute__((vector_size(VINCENTY_LANES*8)));
+
+typedef float    vsf __attribute__((vector_size(VINCENTY_LANES*8)));
+typedef int32_t  vsi __attribute__((vector_size(VINCENTY_LANES*8)));
+typedef uint32_t vsu __attribute__((vector_size(VINCENTY_LANES*8)));
+
+namespace simd {
+
+//! Maps a scalar type to its vector operand and number of lanes.
+template <typename S> struct packed;
+
+template <> struct packed<double>
+{
+  typedef vdf type;
+  static const size_t lanes = VINCENTY_LANES;
+};
+
+template <> struct packed<float>
+{
+  typedef vsf type;
+  static const size_t lanes = VINCENTY_FLOAT_LANES;
+};
+
+/*!
+ * @brief Broadcast a scalar to all lanes.
+ */
+inline vdf
+set1( const double x ) {
+  vdf r;
+  for ( int i=0; i<VINCENTY_LANES; ++i ) {
+    r[i] = x;
+  }
+  return r;
+}
+
+inline vsf
+set1( const float x ) {
+  vsf r;
+  for ( int i=0; i<VINCENTY_FLOAT_LANES; ++i ) {
+    r[i] = x;
+  }
+  return r;
+}
+
+/*!
+ * @brief Loads up to VINCENTY_LANES values. Missing lanes repeat the first
+ * value so that they always hold something sane to compute on.
+ */
+inline vdf
+load( const double* p, const size_t n ) {
+  vdf r = set1(p[0]);
+  for ( size_t i=1; i<n && i<VINCENTY_LANES; ++i ) {
+    r[i] = p[i];
+  }
+  return r;
+}
+
+inline vsf
+load( const float* p, const size_t n ) {
+  vsf r = set1(p[0]);
+  for ( size_t i=1; i<n && i<VINCENTY_FLOAT_LANES; ++i ) {
+    r[i] = p[i];
+  }
+  return r;
+}
+
+//! Stores up to VINCENTY_LANES values, the padding lanes are dropped.
+inline void
+store( double* p, const vdf x, const size_t n ) {
+  for ( size_t i=0; i<n && i<VINCENTY_LANES; ++i ) {
+    p[i] = x[i];
+  }
+}
+
+inline void
+store( float* p, const vsf x, const size_t n ) {
+  for ( size_t i=0; i<n && i<VINCENTY_FLOAT_LANES; ++i ) {
+    p[i] = x[i];
+  }
+}
+
+//! Lane blend, picks x where the mask is set and y elsewhere.
+inline vdf
+select( const vdi mask, const vdf x, const vdf y ) {
+  return mask ? x : y;
+}
+
+inline vsf
+select( const vsi mask, const vsf x, const vsf y ) {
+  return mask ? x : y;
+}
+
+inline double
+select( const bool mask, const double x, const double y ) {
+  return mask ? x : y;
+}
+
+inline float
+select( const bool mask, const float x, const float y ) {
+  return mask ? x : y;
+}
+
+//! True if any lane in the mask is set.
+template <typename M> inline bool
+any( const M mask ) {
+  for ( size_t i=0; i<sizeof(M)/sizeof(mask[0]); ++i ) {
+    if ( mask[i] ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline vdf
+fabs( const vdf x ) {
+  return (vdf)( (vdu)x & ~(vdu)set1(-0.0) );
+}
+
+inline vsf
+fabs( const vsf x ) {
+  return (vsf)( (vsu)x & ~(vsu)set1(-0.0f) );
+}
+
+inline double
+fabs( const double x ) {
+  return __builtin_fabs(x);
+}
+
+inline float
+fabs( const float x ) {
+  return __builtin_fabsf(x);
+}
+
+inline vdf
+sqrt( const vdf x ) {
+#if VINCENTY_LANES == 8 && defined(__AVX512F__)
+  return (vdf)_mm512_sqrt_pd((__m512d)x);
+#elif VINCENTY_LANES == 4 && defined(__AVX__)
+  return (vdf)_mm256_sqrt_pd((__m256d)x);
+#elif VINCENTY_LANES == 2
+  return (vdf)_mm_sqrt_pd((__m128d)x);
+#else
+  vdf r;
+  for ( int i=0; i<VINCENTY_LANES; ++i ) {
+    r[i] = __builtin_sqrt(x[i]);
+  }
+  return r;
+#endif
+}
+
+inline vsf
+sqrt( const vsf x ) {
+#if VINCENTY_LANES == 8 && defined(__AVX512F__)
+  return (vsf)_mm512_sqrt_ps((__m512)x);
+#elif VINCENTY_LANES == 4 && defined(__AVX__)
+  return (vsf)_mm256_sqrt_ps((__m256)x);
+#elif VINCENTY_LANES == 2
+  return (vsf)_mm_sqrt_ps((__m128)x);
+#else
+  vsf r;
+  for ( int i=0; i<VINCENTY_FLOAT_LANES; ++i ) {
+    r[i] = __builtin_sqrtf(x[i]);
+  }
+  return r;
+#endif
+}
+
+inline double
+sqrt( const double x ) {
+  return __builtin_sqrt(x);
+}
+
+inline float
+sqrt( const float x ) {
+  return __builtin_sqrtf(x);
+}
+
+/*!
+ * @brief Lane wise version of vincenty::ulpcmp_inline().
+ *
+ * Compares the bit patterns of the doubles, a lane is set if the values are
+ * less than ulpdiff units in last place apart.
+ */
+inline vdi
+ulpcmp( const vdf x, const vdf y, const uint64_t ulpdiff = 8 ) {
+  const vdu bits = (vdu)x - (vdu)y;
+  const vdu nits = (vdu)y - (vdu)x;
+  // The bits of +0.0 are all zero, the scalar is broadcast by the addition.
+  const vdu ulps = (vdu)set1(0.0) + ulpdiff;
+  return (vdi)( ( bits < ulps ) | ( nits < ulps ) );
+}
+
+inline vsi
+ulpcmp( const vsf x, const vsf y, const uint32_t ulpdiff = 8 ) {
+  const vsu bits = (vsu)x - (vsu)y;
+  const vsu nits = (vsu)y - (vsu)x;
+  const vsu ulps = (vsu)set1(0.0f) + ulpdiff;
+  return (vsi)( ( bits < ulps ) | ( nits < ulps ) );
+}
+
+//! Scalar version, same as vincenty::ulpcmp_inline().
+inline bool
+ulpcmp( const double x, const double y, const uint64_t ulpdiff = 8 ) {
+  union { double d; uint64_t u; } ux, uy;
+  ux.d = x;
+  uy.d = y;
+  return ( ux.u - uy.u ) < ulpdiff || ( uy.u - ux.u ) < ulpdiff;
+}
+
+inline bool
+ulpcmp( const float x, const float y, const uint32_t ulpdiff = 8 ) {
+  union { float d; uint32_t u; } ux, uy;
+  ux.d = x;
+  uy.d = y;
+  return ( ux.u - uy.u ) < ulpdiff || ( uy.u - ux.u ) < ulpdiff;
+}
+
+} // namespace end
+
+} // namespace end
+
+#endif
@@ -2,7 +2,11 @@
 
 include $(HEADER)
 
-TARGETS := test.reg.vincenty test.reg.coordinategrid
+TARGETS := test.reg.vincenty test.reg.coordinategrid test.reg.math \
+           test.reg.geodesicline test.reg.approximate test.reg.metrics \
+           test.reg.parallel test.reg.distancematrix \
+           test.reg.geodesicindex test.reg.ecef test.reg.cells \
+           test.reg.distancejoin
 
 # These apply to all targets in this makerules.
 _LDFLAGS := -pthread -Wl,-rpath=$(TGTDIR)
@@ -12,5 +16,15 @@ GTEST_SRCS := gtest-all.cc
 
 test.reg.vincenty_SRCS := $(GTEST_SRCS) test.vincenty.cpp
 test.reg.coordinategrid_SRCS := $(GTEST_SRCS) test.coordinate_grid.cpp
+test.reg.math_SRCS := $(GTEST_SRCS) test.math.cpp
+test.reg.geodesicline_SRCS := $(GTEST_SRCS) test.geodesic_line.cpp
+test.reg.approximate_SRCS := $(GTEST_SRCS) test.approximate.cpp
+test.reg.metrics_SRCS := $(GTEST_SRCS) test.metrics.cpp
+test.reg.parallel_SRCS := $(GTEST_SRCS) test.parallel.cpp
+test.reg.distancematrix_SRCS := $(GTEST_SRCS) test.distance_matrix.cpp
+test.reg.geodesicindex_SRCS := $(GTEST_SRCS) test.geodesic_index.cpp
+test.reg.ecef_SRCS := $(GTEST_SRCS) test.ecef.cpp
+test.reg.cells_SRCS := $(GTEST_SRCS) test.cells.cpp
+test.reg.distancejoin_SRCS := $(GTEST_SRCS) test.distance_join.cpp
 
 include $(FOOTER)
@@ -0,0 +1,99 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/approximate.h"
+
+#include <cstdlib>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace vincenty;
+
+namespace Test {
+
+/**
+ * Testing class for the approximate distances. Every method must stay within
+ * its documented error bound, measured against the full inverse formula.
+ */
+class ApproximateTest : public testing::Test
+{
+ protected:
+  std::vector<double> lat1;
+  std::vector<double> lon1;
+  std::vector<double> lat2;
+  std::vector<double> lon2;
+  std::vector<double> distance;
+
+  ApproximateTest()
+      : lat1(), lon1(), lat2(), lon2(), distance()
+  {
+  }
+
+  // Random pairs, the distances spread evenly over the decades from 1 m to
+  // half the circumference.
+  void generate( const size_t n ) {
+    srand48(123456789);
+    for ( size_t i=0; i<n; ++i ) {
+      const double lat     = M_PI * ( drand48() - 0.5 );
+      const double lon     = 2*M_PI * ( drand48() - 0.5 );
+      const double bearing = 2*M_PI * drand48();
+      const double s       = pow( 10, 7.3*drand48() );
+      const vposition p = direct(lat,lon,bearing,s);
+      lat1.push_back(lat);
+      lon1.push_back(lon);
+      lat2.push_back(p.coords.a[0]);
+      lon2.push_back(p.coords.a[1]);
+      distance.push_back(inverse(lat,lon,lat2.back(),lon2.back(),1e-13).distance);
+    }
+  }
+
+  double max_lat( const size_t i ) const {
+    return std::max( fabs(lat1[i]), fabs(lat2[i]) );
+  }
+};
+
+
+TEST_F(ApproximateTest, ErrorBoundsHold) {
+  generate(100000);
+  for ( int m=approx_tangent_plane; m<approx_vincenty; ++m ) {
+    const approximation method = static_cast<approximation>(m);
+    for ( size_t i=0; i<distance.size(); ++i ) {
+      const double s =
+          approximate_distance(method,lat1[i],lon1[i],lat2[i],lon2[i]);
+      EXPECT_GE( approximation_error(method,distance[i],max_lat(i)),
+                 fabs(s-distance[i]) )
+          << "Method: " << m << " Index: " << i;
+    }
+  }
+}
+
+
+TEST_F(ApproximateTest, ToleranceIsMet) {
+  generate(20000);
+  const double tolerance[] = { 1e-4, 1e-2, 1.0, 10.0, 100.0, 1e4 };
+  for ( size_t k=0; k<sizeof(tolerance)/sizeof(tolerance[0]); ++k ) {
+    for ( size_t i=0; i<distance.size(); ++i ) {
+      const double s = get_distance(lat1[i],lon1[i],lat2[i],lon2[i],
+                                    tolerance[k]);
+      EXPECT_NEAR( distance[i], s, std::max(tolerance[k],1e-3) )
+          << "Tolerance: " << tolerance[k] << " Index: " << i;
+    }
+  }
+}
+
+
+TEST_F(ApproximateTest, CheapestMethodIsSelected) {
+  const double lat = to_rad(58.0);
+  EXPECT_EQ( approx_tangent_plane,   select_approximation(1e3,lat,1.0) );
+  EXPECT_EQ( approx_andoyer_lambert, select_approximation(1e5,lat,1.0) );
+  EXPECT_EQ( approx_haversine,       select_approximation(1e6,lat,1e4) );
+  EXPECT_EQ( approx_vincenty,        select_approximation(1e6,lat,1e-4) );
+
+  // Tangent plane is never used at the poles, nor Andoyer-Lambert near the
+  // antipode.
+  EXPECT_NE( approx_tangent_plane,   select_approximation(1e3,M_PI/2,1.0) );
+  EXPECT_EQ( approx_vincenty,        select_approximation(1.99e7,0,100.0) );
+  EXPECT_EQ( 0.0, get_distance(0.3,0.2,0.3,0.2,1.0) );
+}
+
+} // namespace end
@@ -0,0 +1,156 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/cells.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <gtest/gtest.h>
+
+using namespace vincenty;
+
+namespace Test {
+
+/**
+ * Testing class for the cells. Every position must be in the bounds of its
+ * cell, and the cells within a distance must hold every position at most
+ * that distance away.
+ */
+class CellsTest : public testing::Test
+{
+ protected:
+  vposition_vector positions;
+
+  CellsTest()
+      : positions()
+  {
+  }
+
+  // Spread over the globe, with some at the poles and on the antimeridian.
+  void generate( const size_t n ) {
+    srand48(8642);
+    for ( size_t i=0; i<n; ++i ) {
+      double lat = std::asin( 2*drand48() - 1 );
+      double lon = 2*M_PI * ( drand48() - 0.5 );
+      if ( i % 20 == 0 ) {
+        lat = ( i % 40 == 0 ? 1 : -1 ) * ( M_PI/2 - 1e-3 * drand48() );
+      } else if ( i % 20 == 1 ) {
+        lon = M_PI - 1e-4 * drand48();
+      }
+      positions.push_back( vposition(lat,lon) );
+    }
+  }
+};
+
+bool contains( const std::vector<cell_id>& cells, const cell_id cell ) {
+  return std::binary_search( cells.begin(), cells.end(), cell );
+}
+
+
+TEST_F(CellsTest, Encoding) {
+  EXPECT_EQ( 1u, to_cell( vposition(0.3,0.2), 0 ) );
+  EXPECT_EQ( 7u, to_cell( vposition(0.3,0.2), 1 ) );
+  EXPECT_EQ( 4u, to_cell( vposition(-0.3,-0.2), 1 ) );
+  EXPECT_EQ( to_cell( vposition(0.1,-M_PI), 8 ),
+             to_cell( vposition(0.1,M_PI), 8 ) ) << "Longitudes wrap";
+
+  generate(2000);
+  std::vector<double> lat, lon;
+  for ( size_t i=0; i<positions.size(); ++i ) {
+    lat.push_back( positions[i].coords.a[0] );
+    lon.push_back( positions[i].coords.a[1] );
+  }
+  std::vector<cell_id> cells( positions.size() );
+  to_cells( &lat[0], &lon[0], &cells[0], cells.size(), 17 );
+
+  for ( size_t i=0; i<positions.size(); ++i ) {
+    const vposition& pos = positions[i];
+    const cell_id cell = to_cell( pos, 17 );
+    ASSERT_EQ( cells[i], cell );
+    ASSERT_EQ( 17u, cell_level(cell) );
+    ASSERT_EQ( to_cell( pos, 9 ), cell_parent( cell, 9 ) );
+    ASSERT_EQ( cell, to_cell( cell_center(cell), 17 ) );
+
+    vposition sw, ne;
+    cell_bounds( cell, &sw, &ne );
+    ASSERT_LE( sw.coords.a[0], pos.coords.a[0] );
+    ASSERT_GE( ne.coords.a[0], pos.coords.a[0] );
+    ASSERT_LE( sw.coords.a[1], pos.coords.a[1] );
+    ASSERT_GE( ne.coords.a[1], pos.coords.a[1] );
+  }
+
+  std::vector<double> clat( cells.size() ), clon( cells.size() );
+  cell_centers( &cells[0], &clat[0], &clon[0], cells.size() );
+  EXPECT_EQ( cell_center(cells[5]).coords.a[0], clat[5] );
+  EXPECT_EQ( cell_center(cells[5]).coords.a[1], clon[5] );
+}
+
+TEST_F(CellsTest, Neighbours) {
+  const cell_id cell = to_cell( vposition(0.3,0.2), 10 );
+  const std::vector<cell_id> around = cell_neighbours(cell);
+  EXPECT_EQ( 8u, around.size() );
+  EXPECT_FALSE( contains( around, cell ) );
+  EXPECT_TRUE( contains( around, to_cell( vposition(0.3,0.2+M_PI/512), 10 ) ) );
+
+  // Over the antimeridian, and at a pole.
+  const std::vector<cell_id> wrap =
+      cell_neighbours( to_cell( vposition(0.3,M_PI-1e-9), 10 ) );
+  EXPECT_EQ( 8u, wrap.size() );
+  EXPECT_TRUE( contains( wrap, to_cell( vposition(0.3,-M_PI+1e-9), 10 ) ) );
+  EXPECT_EQ( 5u, cell_neighbours( to_cell( vposition(M_PI/2,0.2), 10 ) ).size() );
+}
+
+TEST_F(CellsTest, WithinHoldsEveryGeodesic) {
+  generate(300);
+  const double distances[] = { 200, 5000, 300000 };
+  for ( size_t d=0; d<sizeof(distances)/sizeof(distances[0]); ++d ) {
+    const unsigned int level = cell_level_for( distances[d] );
+    for ( size_t i=0; i<positions.size(); ++i ) {
+      const cell_id cell = to_cell( positions[i], level );
+      const std::vector<cell_id> cells = cells_within( cell, distances[d] );
+      ASSERT_TRUE( contains( cells, cell ) );
+      for ( int k=0; k<20; ++k ) {
+        const vposition pos = direct( positions[i], 2*M_PI * drand48(),
+                                      distances[d] * drand48() );
+        ASSERT_TRUE( contains( cells, to_cell( pos, level ) ) )
+            << positions[i] << " to " << pos << ", distance " << distances[d];
+      }
+    }
+  }
+
+  // A cell is at least the distance tall, away from the poles there are
+  // nine cells or a few more.
+  const unsigned int level = cell_level_for(1000);
+  EXPECT_GE( 15u, cells_within( to_cell( vposition(0.8,0.1), level ),
+                                1000 ).size() );
+}
+
+TEST_F(CellsTest, Buckets) {
+  generate(5000);
+  const unsigned int level = 6;
+  const cell_buckets buckets( positions, level );
+  EXPECT_EQ( level, buckets.level() );
+
+  size_t total = 0;
+  for ( size_t k=0; k<buckets.size(); ++k ) {
+    ASSERT_LT( 0u, buckets.count(k) );
+    if ( k > 0 ) {
+      ASSERT_LT( buckets.cell(k-1), buckets.cell(k) );
+    }
+    ASSERT_EQ( k, buckets.find( buckets.cell(k) ) );
+    for ( const size_t* p=buckets.begin(k); p!=buckets.end(k); ++p ) {
+      ASSERT_EQ( buckets.cell(k), to_cell( positions[*p], level ) );
+      if ( p != buckets.begin(k) ) {
+        ASSERT_LT( *(p-1), *p );
+      }
+    }
+    total += buckets.count(k);
+  }
+  EXPECT_EQ( positions.size(), total );
+
+  const cell_buckets empty;
+  EXPECT_EQ( 0u, empty.size() );
+  EXPECT_EQ( 0u, empty.find( to_cell( positions[0], 3 ) ) );
+}
+
+}
@@ -0,0 +1,134 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/distance_join.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <gtest/gtest.h>
+
+using namespace vincenty;
+
+namespace Test {
+
+/**
+ * Testing class for the distance join. The pairs must be exactly those found
+ * by trying every pair with the inverse formula.
+ */
+class DistanceJoinTest : public testing::Test
+{
+ protected:
+  vposition_vector fixes;
+  vposition_vector places;
+
+  DistanceJoinTest()
+      : fixes(), places()
+  {
+  }
+
+  // Places in a few towns, one on the antimeridian and one at a pole, and
+  // fixes around them and anywhere.
+  void generate( const size_t n1, const size_t n2 ) {
+    srand48(97531);
+    const vposition towns[] = {
+      vposition( to_rad(59.33), to_rad(18.06) ),
+      vposition( to_rad(-17.7), to_rad(179.99) ),
+      vposition( to_rad(89.99), to_rad(0) ),
+      vposition( to_rad(0.01),  to_rad(-60) )
+    };
+    for ( size_t i=0; i<n2; ++i ) {
+      places.push_back( direct( towns[i%4], 2*M_PI * drand48(),
+                                20000 * drand48() ) );
+    }
+    for ( size_t i=0; i<n1; ++i ) {
+      if ( i % 10 == 0 ) {
+        fixes.push_back( vposition( std::asin( 2*drand48() - 1 ),
+                                    2*M_PI * ( drand48() - 0.5 ) ) );
+      } else {
+        fixes.push_back( direct( places[i % n2], 2*M_PI * drand48(),
+                                 3000 * drand48() ) );
+      }
+    }
+  }
+
+  std::vector<join_match> brute_force( const double radius ) const {
+    std::vector<join_match> all;
+    for ( size_t i=0; i<fixes.size(); ++i ) {
+      for ( size_t j=0; j<places.size(); ++j ) {
+        if ( inverse( fixes[i], places[j] ).distance <= radius ) {
+          all.push_back( join_match(i,j) );
+        }
+      }
+    }
+    return all;
+  }
+};
+
+struct counted
+{
+  size_t calls;
+  std::vector<join_match> matches;
+};
+
+void count_matches( void* context, const join_match* matches, size_t n )
+{
+  counted& c = *static_cast<counted*>(context);
+  ++c.calls;
+  c.matches.insert( c.matches.end(), matches, matches + n );
+}
+
+
+TEST_F(DistanceJoinTest, MatchesBruteForce) {
+  generate( 5000, 300 );
+  const double radii[] = { 200, 2500 };
+  for ( size_t r=0; r<sizeof(radii)/sizeof(radii[0]); ++r ) {
+    const std::vector<join_match> expected = brute_force( radii[r] );
+    ASSERT_LT( 100u, expected.size() );
+    EXPECT_EQ( expected, distance_join( fixes, places, radii[r], 1 ) )
+        << "radius " << radii[r];
+    EXPECT_EQ( expected, distance_join( fixes, places, radii[r], 3 ) )
+        << "radius " << radii[r];
+  }
+}
+
+TEST_F(DistanceJoinTest, Streaming) {
+  // More fixes than a block, so that the pairs come in several calls.
+  generate( 9000, 100 );
+  std::vector<double> lat1, lon1, lat2, lon2;
+  for ( size_t i=0; i<fixes.size(); ++i ) {
+    lat1.push_back( fixes[i].coords.a[0] );
+    lon1.push_back( fixes[i].coords.a[1] );
+  }
+  for ( size_t i=0; i<places.size(); ++i ) {
+    lat2.push_back( places[i].coords.a[0] );
+    lon2.push_back( places[i].coords.a[1] );
+  }
+
+  counted c = { 0, std::vector<join_match>() };
+  const size_t n = distance_join( &lat1[0], &lon1[0], lat1.size(),
+                                  &lat2[0], &lon2[0], lat2.size(),
+                                  1000, &count_matches, &c, 4 );
+  EXPECT_EQ( n, c.matches.size() );
+  EXPECT_LT( 1u, c.calls );
+  std::sort( c.matches.begin(), c.matches.end() );
+  EXPECT_EQ( distance_join( fixes, places, 1000 ), c.matches );
+}
+
+TEST_F(DistanceJoinTest, EmptyAndNegative) {
+  generate( 10, 10 );
+  EXPECT_TRUE( distance_join( vposition_vector(), places, 1e7 ).empty() );
+  EXPECT_TRUE( distance_join( fixes, vposition_vector(), 1e7 ).empty() );
+  EXPECT_TRUE( distance_join( fixes, places, -1 ).empty() );
+
+  // Every pair, from a single cell of the whole globe.
+  EXPECT_EQ( 100u, distance_join( fixes, places, 2.1e7 ).size() );
+
+  // At radius zero a set joined with itself gives the positions themselves.
+  const std::vector<join_match> self = distance_join( places, places, 0 );
+  for ( size_t i=0; i<places.size(); ++i ) {
+    EXPECT_TRUE( std::binary_search( self.begin(), self.end(),
+                                     join_match(i,i) ) ) << "place " << i;
+  }
+}
+
+}
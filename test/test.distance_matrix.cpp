@@ -0,0 +1,202 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/distance_matrix.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace vincenty;
+
+namespace Test {
+
+/**
+ * Testing class for the distance matrix. The tiles must give the same
+ * distances as one-to-many inverse formulas over the rows, whatever the
+ * number of threads and however the tiles were shared.
+ */
+class DistanceMatrixTest : public testing::Test
+{
+ protected:
+  vposition_vector from;
+  vposition_vector to;
+
+  DistanceMatrixTest()
+      : from(), to()
+  {
+  }
+
+  // Sizes which are not multiples of a tile, nor of the vector lanes.
+  void generate( const size_t m, const size_t n ) {
+    srand48(987654321);
+    for ( size_t i=0; i<m; ++i ) {
+      from.push_back( vposition( M_PI * ( drand48() - 0.5 ),
+                                 2*M_PI * ( drand48() - 0.5 ) ) );
+    }
+    for ( size_t j=0; j<n; ++j ) {
+      to.push_back( vposition( M_PI * ( drand48() - 0.5 ),
+                               2*M_PI * ( drand48() - 0.5 ) ) );
+    }
+  }
+
+  std::vector<double> expected() const {
+    std::vector<double> s( from.size() * to.size() );
+    for ( size_t i=0; i<from.size(); ++i ) {
+      inverse_one_to_many( prepared_position(from[i]), &to[0],
+                           &s[i*to.size()], to.size() );
+    }
+    return s;
+  }
+};
+
+
+TEST_F(DistanceMatrixTest, MatchesOneToMany) {
+  generate( 71, 1031 );
+  const std::vector<double> s = expected();
+  const prepared_sites rows(from);
+  const prepared_sites cols(&to[0],to.size());
+  ASSERT_EQ( from.size(), rows.size() );
+
+  const unsigned int threads[] = { 1, 3 };
+  for ( size_t t=0; t<sizeof(threads)/sizeof(threads[0]); ++t ) {
+    std::vector<double> matrix( s.size(), -1 );
+    distance_matrix( rows, cols, &matrix[0], threads[t] );
+    for ( size_t k=0; k<s.size(); ++k ) {
+      ASSERT_EQ( s[k], matrix[k] ) << "element " << k
+                                   << ", threads " << threads[t];
+    }
+  }
+}
+
+TEST_F(DistanceMatrixTest, FloatOutput) {
+  generate( 33, 517 );
+  const std::vector<double> s = expected();
+  std::vector<float> matrix( s.size() );
+  distance_matrix( prepared_sites(from), prepared_sites(to), &matrix[0], 2 );
+  for ( size_t k=0; k<s.size(); ++k ) {
+    ASSERT_EQ( static_cast<float>(s[k]), matrix[k] ) << "element " << k;
+  }
+}
+
+TEST_F(DistanceMatrixTest, SameSetHasZeroDiagonal) {
+  generate( 40, 0 );
+  std::vector<double> lat, lon;
+  for ( size_t i=0; i<from.size(); ++i ) {
+    lat.push_back( from[i].coords.a[0] );
+    lon.push_back( from[i].coords.a[1] );
+  }
+  const prepared_sites sites( &lat[0], &lon[0], lat.size() );
+  const size_t n = sites.size();
+  std::vector<double> matrix( n*n );
+  distance_matrix( sites, sites, &matrix[0] );
+  for ( size_t i=0; i<n; ++i ) {
+    EXPECT_EQ( 0.0, matrix[i*n+i] ) << "site " << i;
+    for ( size_t j=0; j<i; ++j ) {
+      ASSERT_NEAR( matrix[i*n+j], matrix[j*n+i], 1e-4 )
+          << "sites " << i << ", " << j;
+    }
+  }
+}
+
+TEST_F(DistanceMatrixTest, MappedFile) {
+  generate( 37, 600 );
+  const std::vector<double> s = expected();
+  char path[] = "/tmp/vincenty_matrix_XXXXXX";
+  const int fd = mkstemp(path);
+  ASSERT_NE( -1, fd );
+  close(fd);
+
+  ASSERT_TRUE( distance_matrix_file<float>( prepared_sites(from),
+                                            prepared_sites(to),
+                                            std::string(path), 2 ) );
+  std::vector<float> matrix( s.size() );
+  FILE* in = std::fopen( path, "rb" );
+  ASSERT_TRUE( in != 0 );
+  EXPECT_EQ( matrix.size(),
+             std::fread( &matrix[0], sizeof(float), matrix.size(), in ) );
+  EXPECT_EQ( EOF, std::fgetc(in) ) << "Nothing after the matrix";
+  std::fclose(in);
+  for ( size_t k=0; k<s.size(); ++k ) {
+    ASSERT_EQ( static_cast<float>(s[k]), matrix[k] ) << "element " << k;
+  }
+
+  // An existing file is truncated to the new matrix.
+  ASSERT_TRUE( distance_matrix_file<double>( prepared_sites(from),
+                                             prepared_sites(), path ) );
+  struct stat st;
+  ASSERT_EQ( 0, stat( path, &st ) );
+  EXPECT_EQ( 0, st.st_size );
+  std::remove(path);
+
+  EXPECT_FALSE( distance_matrix_file<double>( prepared_sites(from),
+                                              prepared_sites(to),
+                                              "/nonexistent/matrix.bin" ) );
+}
+
+
+TEST_F(DistanceMatrixTest, CondensedIndex) {
+  const size_t n = 5;
+  EXPECT_EQ( 10u, condensed_size(n) );
+  EXPECT_EQ( 0u,  condensed_size(1) );
+  EXPECT_EQ( 0u, condensed_index(0,1,n) );
+  EXPECT_EQ( 3u, condensed_index(0,4,n) );
+  EXPECT_EQ( 4u, condensed_index(1,2,n) );
+  EXPECT_EQ( 9u, condensed_index(3,4,n) );
+  for ( size_t i=0; i<n; ++i ) {
+    for ( size_t j=0; j<i; ++j ) {
+      EXPECT_EQ( condensed_index(j,i,n), condensed_index(i,j,n) );
+    }
+  }
+}
+
+TEST_F(DistanceMatrixTest, CondensedIsUpperTriangle) {
+  // More than two tiles of sites, the last one partial.
+  generate( 601, 0 );
+  const prepared_sites sites(from);
+  const size_t n = sites.size();
+  std::vector<double> matrix( n*n );
+  distance_matrix( sites, sites, &matrix[0] );
+
+  std::vector<double> condensed( condensed_size(n), -1 );
+  pairwise_distances( sites, &condensed[0], 3 );
+  std::vector<float> condensedf( condensed_size(n), -1 );
+  pairwise_distances( sites, &condensedf[0], 2 );
+  for ( size_t i=0; i<n; ++i ) {
+    for ( size_t j=i+1; j<n; ++j ) {
+      const size_t k = condensed_index(i,j,n);
+      ASSERT_EQ( matrix[i*n+j], condensed[k] ) << "pair " << i << ", " << j;
+      ASSERT_EQ( static_cast<float>(matrix[i*n+j]), condensedf[k] )
+          << "pair " << i << ", " << j;
+    }
+  }
+}
+
+TEST_F(DistanceMatrixTest, CondensedDirections) {
+  generate( 300, 0 );
+  const prepared_sites sites(from);
+  const condensed_matrix cm(sites);
+  ASSERT_EQ( from.size(), cm.size() );
+  ASSERT_EQ( condensed_size(from.size()), cm.distances().size() );
+  for ( size_t i=0; i<from.size(); i+=7 ) {
+    for ( size_t j=0; j<from.size(); j+=11 ) {
+      const vdirection dir = inverse( from[i], from[j] );
+      const vdirection got = cm.direction(i,j);
+      ASSERT_NEAR( dir.distance, got.distance, 1e-4 ) << i << ", " << j;
+      ASSERT_NEAR( dir.distance, cm.distance(i,j), 1e-4 ) << i << ", " << j;
+      if ( i != j ) {
+        ASSERT_NEAR( dir.bearing1, got.bearing1, 1e-9 ) << i << ", " << j;
+        ASSERT_NEAR( dir.bearing2, got.bearing2, 1e-9 ) << i << ", " << j;
+      }
+    }
+  }
+  EXPECT_EQ( 0.0, cm.distance(3,3) );
+  EXPECT_EQ( cm.direction(2,9).bearing1, cm.direction(9,2).bearing2 );
+
+  const condensed_matrix one( prepared_sites(&from[0],1) );
+  EXPECT_TRUE( one.distances().empty() );
+}
+
+}
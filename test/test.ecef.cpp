@@ -0,0 +1,143 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/ecef.h"
+
+#include <cstdlib>
+
+#include <gtest/gtest.h>
+
+using namespace vincenty;
+
+namespace Test {
+
+/**
+ * Testing class for the Earth-centered Earth-fixed coordinates and the
+ * distance bounds. The bounds must hold for every computed distance, and
+ * the predicates must agree with the inverse formula.
+ */
+class EcefTest : public testing::Test
+{
+ protected:
+  std::vector<double> lat;
+  std::vector<double> lon;
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> z;
+
+  EcefTest()
+      : lat(), lon(), x(), y(), z()
+  {
+  }
+
+  // Positions around a center, out to about distance.
+  void generate( const vposition& center, const double distance,
+                 const size_t n ) {
+    srand48(112358);
+    for ( size_t i=0; i<n; ++i ) {
+      const vposition pos = direct( center, 2*M_PI * drand48(),
+                                    distance * drand48() );
+      lat.push_back( pos.coords.a[0] );
+      lon.push_back( pos.coords.a[1] );
+    }
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    to_ecef( &lat[0], &lon[0], &x[0], &y[0], &z[0], n );
+  }
+};
+
+
+TEST_F(EcefTest, KnownPositions) {
+  double xyz[3];
+  to_ecef( vposition(0,0), xyz );
+  EXPECT_NEAR( wgs84::a(), xyz[0], 1e-6 );
+  EXPECT_NEAR( 0, xyz[1], 1e-6 );
+  EXPECT_NEAR( 0, xyz[2], 1e-6 );
+
+  to_ecef( vposition(0,M_PI/2), xyz );
+  EXPECT_NEAR( 0, xyz[0], 1e-6 );
+  EXPECT_NEAR( wgs84::a(), xyz[1], 1e-6 );
+
+  to_ecef( vposition(M_PI/2,0), xyz );
+  EXPECT_NEAR( 0, xyz[0], 1e-6 );
+  EXPECT_NEAR( wgs84::b(), xyz[2], 1e-3 );
+
+  // The batch gives the same coordinates, whatever the lane of a position.
+  generate( vposition(to_rad(45),to_rad(10)), 1e6, 13 );
+  for ( size_t i=0; i<lat.size(); ++i ) {
+    to_ecef( vposition(lat[i],lon[i]), xyz );
+    EXPECT_EQ( x[i], xyz[0] ) << "position " << i;
+    EXPECT_EQ( y[i], xyz[1] ) << "position " << i;
+    EXPECT_EQ( z[i], xyz[2] ) << "position " << i;
+  }
+}
+
+TEST_F(EcefTest, BoundsHold) {
+  srand48(31415);
+  for ( size_t i=0; i<20000; ++i ) {
+    const vposition pos1( std::asin( 2*drand48() - 1 ),
+                          2*M_PI * ( drand48() - 0.5 ) );
+    // Every scale of distance, and nearly antipodal positions.
+    vposition pos2;
+    if ( i % 4 == 0 ) {
+      pos2 = vposition( -pos1.coords.a[0] + 1e-2 * ( drand48() - 0.5 ),
+                        pos1.coords.a[1] + M_PI + 1e-2 * ( drand48() - 0.5 ) );
+    } else {
+      pos2 = direct( pos1, 2*M_PI * drand48(),
+                     std::pow( 10.0, 7.3 * drand48() ) );
+    }
+    const double s = inverse( pos1, pos2 ).distance;
+    ASSERT_LE( distance_lower_bound(pos1,pos2), s ) << pos1 << " " << pos2;
+    ASSERT_GE( distance_upper_bound(pos1,pos2), s ) << pos1 << " " << pos2;
+  }
+
+  // Pole to pole, and across the equator, are the longest geodesics.
+  const vposition north(M_PI/2,0), south(-M_PI/2,0);
+  const vposition east(0,M_PI/2), west(0,-M_PI/2);
+  EXPECT_GE( distance_upper_bound(north,south), inverse(north,south).distance );
+  EXPECT_GE( distance_upper_bound(east,west), inverse(east,west).distance );
+}
+
+TEST_F(EcefTest, BoundsAreTight) {
+  const vposition pos1( to_rad(57), to_rad(12) );
+  const double distances[] = { 100, 1e4, 1e5 };
+  for ( size_t i=0; i<sizeof(distances)/sizeof(distances[0]); ++i ) {
+    for ( int b=0; b<8; ++b ) {
+      const vposition pos2 = direct( pos1, b * M_PI/4, distances[i] );
+      EXPECT_LT( distance_upper_bound(pos1,pos2) -
+                 distance_lower_bound(pos1,pos2),
+                 2e-3 * distances[i] + 3e-3 );
+    }
+  }
+}
+
+TEST_F(EcefTest, WithinIsInverse) {
+  const vposition center( to_rad(-33.9), to_rad(151.2) );
+  generate( center, 30000, 5000 );
+  const double radii[] = { 0, 500, 10000, 20000, 30000 };
+  std::vector<unsigned char> within( lat.size() );
+  for ( size_t r=0; r<sizeof(radii)/sizeof(radii[0]); ++r ) {
+    const size_t count =
+        within_distance( center, &lat[0], &lon[0], &x[0], &y[0], &z[0],
+                         lat.size(), radii[r], &within[0] );
+    size_t expected = 0;
+    for ( size_t i=0; i<lat.size(); ++i ) {
+      const vposition pos( lat[i], lon[i] );
+      const bool in = inverse( center, pos ).distance <= radii[r];
+      expected += in;
+      ASSERT_EQ( in, within[i] == 1 ) << "position " << i
+                                      << ", radius " << radii[r];
+      ASSERT_EQ( in, within_distance( center, pos, radii[r] ) );
+    }
+    EXPECT_EQ( expected, count ) << "radius " << radii[r];
+  }
+
+  // On the position itself, and around the globe.
+  EXPECT_TRUE( within_distance( center, center, 0 ) );
+  EXPECT_FALSE( within_distance( center, center, -1 ) );
+  EXPECT_TRUE( within_distance( center, vposition(-center.coords.a[0],
+                                                  center.coords.a[1] - M_PI),
+                                2.1e7 ) );
+}
+
+}
@@ -0,0 +1,174 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/geodesic_index.h"
+#include "vincenty/metrics.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <pthread.h>
+
+#include <gtest/gtest.h>
+
+using namespace vincenty;
+
+namespace Test {
+
+/**
+ * Testing class for the geodesic index. Every search must find the same
+ * neighbours, at the same distances, as computing the distance to every
+ * position and sorting.
+ */
+class GeodesicIndexTest : public testing::Test
+{
+ protected:
+  vposition_vector positions;
+
+  GeodesicIndexTest()
+      : positions()
+  {
+  }
+
+  // Clustered around a few centers, with some duplicates and some spread
+  // over the whole globe.
+  void generate( const size_t n ) {
+    srand48(24680);
+    for ( size_t i=0; i<n; ++i ) {
+      if ( i % 10 == 0 ) {
+        positions.push_back( vposition( M_PI * ( drand48() - 0.5 ),
+                                        2*M_PI * ( drand48() - 0.5 ) ) );
+      } else if ( i % 97 == 1 ) {
+        positions.push_back( positions[i-1] );
+      } else {
+        const double lat = to_rad( 10.0 * ( i % 5 ) - 20 );
+        const double lon = to_rad( 30.0 * ( i % 7 ) - 90 );
+        positions.push_back( vposition( lat + 0.05 * ( drand48() - 0.5 ),
+                                        lon + 0.05 * ( drand48() - 0.5 ) ) );
+      }
+    }
+  }
+
+  neighbour_vector brute_force( const vposition& pos ) const {
+    neighbour_vector all;
+    for ( size_t i=0; i<positions.size(); ++i ) {
+      all.push_back( neighbour( i, inverse( pos, positions[i] ).distance ) );
+    }
+    std::sort( all.begin(), all.end() );
+    return all;
+  }
+};
+
+void expect_same( const neighbour_vector& expected,
+                  const neighbour_vector& found ) {
+  ASSERT_EQ( expected.size(), found.size() );
+  for ( size_t i=0; i<expected.size(); ++i ) {
+    ASSERT_EQ( expected[i].index, found[i].index ) << "neighbour " << i;
+    ASSERT_EQ( expected[i].distance, found[i].distance ) << "neighbour " << i;
+  }
+}
+
+struct concurrent_query
+{
+  const geodesic_index* index;
+  const vposition_vector* queries;
+  std::vector<neighbour_vector> results;
+};
+
+void* query_in_thread( void* arg )
+{
+  concurrent_query& q = *static_cast<concurrent_query*>(arg);
+  for ( size_t i=0; i<q.queries->size(); ++i ) {
+    q.results.push_back( q.index->nearest( (*q.queries)[i], 8 ) );
+  }
+  return 0;
+}
+
+
+TEST_F(GeodesicIndexTest, NearestIsBruteForce) {
+  generate(3000);
+  const geodesic_index index(positions);
+  ASSERT_EQ( positions.size(), index.size() );
+
+  const size_t ks[] = { 1, 5, 64 };
+  for ( size_t q=0; q<40; ++q ) {
+    // Queries both on indexed positions and anywhere.
+    const vposition pos = q % 2 ? positions[q*71] :
+        vposition( M_PI * ( drand48() - 0.5 ), 2*M_PI * ( drand48() - 0.5 ) );
+    const neighbour_vector all = brute_force(pos);
+    for ( size_t k=0; k<sizeof(ks)/sizeof(ks[0]); ++k ) {
+      const neighbour_vector expected( all.begin(), all.begin() + ks[k] );
+      expect_same( expected, index.nearest( pos, ks[k] ) );
+    }
+  }
+}
+
+TEST_F(GeodesicIndexTest, WithinIsBruteForce) {
+  generate(3000);
+  const geodesic_index index(positions);
+  const double radii[] = { 0, 1000, 50000, 2e6 };
+  for ( size_t q=0; q<20; ++q ) {
+    const vposition pos = positions[q*113];
+    const neighbour_vector all = brute_force(pos);
+    for ( size_t r=0; r<sizeof(radii)/sizeof(radii[0]); ++r ) {
+      neighbour_vector expected;
+      for ( size_t i=0; i<all.size() && all[i].distance <= radii[r]; ++i ) {
+        expected.push_back( all[i] );
+      }
+      expect_same( expected, index.within( pos, radii[r] ) );
+    }
+  }
+}
+
+TEST_F(GeodesicIndexTest, SmallAndEmpty) {
+  const geodesic_index empty;
+  EXPECT_TRUE( empty.nearest( vposition(0.1,0.2), 3 ).empty() );
+  EXPECT_TRUE( empty.within( vposition(0.1,0.2), 1e7 ).empty() );
+
+  generate(5);
+  const geodesic_index index(positions);
+  EXPECT_EQ( 5u, index.nearest( positions[2], 10 ).size() );
+  EXPECT_TRUE( index.nearest( positions[2], 0 ).empty() );
+  EXPECT_EQ( 2u, index.nearest( positions[2], 1 ).front().index );
+  EXPECT_EQ( 0.0, index.nearest( positions[2], 1 ).front().distance );
+}
+
+#ifndef VINCENTY_NO_METRICS
+TEST_F(GeodesicIndexTest, FewInverseFormulas) {
+  // Spread out, the nearest few are found after a small part of the set.
+  srand48(13579);
+  for ( size_t i=0; i<100000; ++i ) {
+    positions.push_back( vposition( std::asin( 2 * drand48() - 1 ),
+                                    2*M_PI * ( drand48() - 0.5 ) ) );
+  }
+  const geodesic_index index(positions);
+  const metrics_snapshot before = metrics();
+  const neighbour_vector found = index.nearest( vposition(0.3,0.4), 10 );
+  const metrics_snapshot after = metrics();
+  EXPECT_EQ( 10u, found.size() );
+  EXPECT_GT( 500u, after.inverse_calls - before.inverse_calls );
+}
+#endif
+
+TEST_F(GeodesicIndexTest, ConcurrentQueries) {
+  generate(5000);
+  const geodesic_index index(positions);
+  vposition_vector queries( positions.begin(), positions.begin() + 200 );
+
+  concurrent_query calls[4];
+  pthread_t threads[4];
+  for ( int t=0; t<4; ++t ) {
+    calls[t].index   = &index;
+    calls[t].queries = &queries;
+    ASSERT_EQ( 0, pthread_create( &threads[t], 0, &query_in_thread, &calls[t] ) );
+  }
+  for ( int t=0; t<4; ++t ) {
+    pthread_join( threads[t], 0 );
+  }
+  for ( size_t i=0; i<queries.size(); ++i ) {
+    const neighbour_vector expected = index.nearest( queries[i], 8 );
+    for ( int t=0; t<4; ++t ) {
+      expect_same( expected, calls[t].results[i] );
+    }
+  }
+}
+
+}
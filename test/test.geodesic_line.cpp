@@ -0,0 +1,102 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/geodesic_line.h"
+
+#include <cstdlib>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace vincenty;
+
+namespace Test {
+
+/**
+ * Testing class for geodesic_line. Every position along a line must be the
+ * same as from direct() with the origin, bearing and distance.
+ */
+class GeodesicLineTest : public testing::Test
+{
+ protected:
+  const vposition origin;
+
+  GeodesicLineTest()
+      : origin(to_rad(58.4),to_rad(15.6))
+  {
+    srand48(123456789);
+  }
+};
+
+
+TEST_F(GeodesicLineTest, PositionMatchesDirect) {
+  for ( int i=0; i<1000; ++i ) {
+    const double lat      =   M_PI * ( drand48() - 0.5 );
+    const double lon      = 2*M_PI * ( drand48() - 0.5 );
+    const double bearing  = 2*M_PI * drand48();
+    const geodesic_line line(lat,lon,bearing);
+    for ( int j=0; j<4; ++j ) {
+      const double distance = 2e7 * drand48();
+      const vposition p = direct(lat,lon,bearing,distance);
+      const vposition q = line.position(distance);
+      EXPECT_NEAR( p.coords.a[0], q.coords.a[0], 1e-14 ) << "Index: " << i;
+      EXPECT_NEAR( p.coords.a[1], q.coords.a[1], 1e-14 ) << "Index: " << i;
+    }
+  }
+}
+
+
+TEST_F(GeodesicLineTest, ZeroDistanceIsOrigin) {
+  const geodesic_line line(origin,direction::northeast);
+  EXPECT_TRUE( origin == line.position(0.0) );
+  EXPECT_TRUE( origin == line.origin() );
+  EXPECT_EQ( direction::northeast, line.bearing() );
+
+  double distance = 0.0, lat, lon;
+  line.positions(&distance,&lat,&lon,1);
+  EXPECT_EQ( origin.coords.a[0], lat );
+  EXPECT_EQ( origin.coords.a[1], lon );
+}
+
+
+// The batch positions against the scalar ones, for all tail sizes.
+TEST_F(GeodesicLineTest, PositionsMatchPosition) {
+  const geodesic_line line(origin,to_rad(73.0));
+  for ( size_t n=1; n<40; ++n ) {
+    std::vector<double> distance(n), lat(n+1,-1), lon(n+1,-1);
+    for ( size_t i=0; i<n; ++i ) {
+      distance[i] = i%5 == 0 ? 0.0 : 1.5e7 * drand48() - 5e6;
+    }
+    line.positions(&distance[0],&lat[0],&lon[0],n);
+    EXPECT_EQ( -1, lat[n] );
+    EXPECT_EQ( -1, lon[n] );
+    for ( size_t i=0; i<n; ++i ) {
+      const vposition p = line.position(distance[i]);
+      EXPECT_NEAR( p.coords.a[0], lat[i], 1e-12 ) << "Index: " << i;
+      EXPECT_NEAR( p.coords.a[1], lon[i], 1e-12 ) << "Index: " << i;
+    }
+  }
+}
+
+
+// Markers every 10km, the distance between neighbours must be 10km.
+TEST_F(GeodesicLineTest, DensifyRoute) {
+  const vposition destination(to_rad(40.7),to_rad(-74.0));
+  const vdirection dir = inverse(origin,destination);
+  const geodesic_line line(origin,dir.bearing1);
+
+  std::vector<double> distances;
+  for ( double s=0; s<dir.distance; s+=1e4 ) {
+    distances.push_back(s);
+  }
+  distances.push_back(dir.distance);
+
+  const vposition_vector route = line.positions(distances);
+  ASSERT_EQ( distances.size(), route.size() );
+  EXPECT_TRUE( origin == route.front() );
+  EXPECT_NEAR( 0.0, get_distance(destination,route.back()), 1e-3 );
+  for ( size_t i=1; i+1<route.size(); ++i ) {
+    EXPECT_NEAR( 1e4, get_distance(route[i-1],route[i]), 1e-3 );
+  }
+}
+
+} // namespace end
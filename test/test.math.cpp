@@ -0,0 +1,209 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/vincenty.h"
+
+// The kernels are internal to the library and only available as inlined
+// templates, test them through the internal header.
+#include "../src/vincenty_math.h"
+
+#include <cstdlib>
+#include <unistd.h>
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+namespace Test {
+
+// Distance in units in last place between x and the correctly rounded
+// reference value.
+double ulps( const double x, const long double ref ) {
+  const double r = double(ref);
+  if ( x == r ) {
+    return 0;
+  }
+  const double ulp = nextafter(fabs(r),HUGE_VAL) - fabs(r);
+  return fabs( (long double)x - ref ) / ulp;
+}
+
+// Same for floats, the double result is the reference.
+double ulpsf( const float x, const double ref ) {
+  const float r = float(ref);
+  if ( x == r ) {
+    return 0;
+  }
+  const double ulp = nextafterf(fabsf(r),HUGE_VALF) - fabsf(r);
+  return fabs( x - ref ) / ulp;
+}
+
+/**
+ * Testing class for the polynomial sin, cos, atan and atan2 kernels. The
+ * measured errors must stay within the bounds documented in
+ * src/vincenty_math.h.
+ */
+class MathTest : public testing::Test
+{
+ protected:
+  MathTest()
+  {
+    srand48(123456789);
+  }
+
+  // Random value in [lo,hi).
+  static double uniform( const double lo, const double hi ) {
+    return lo + ( hi - lo ) * drand48();
+  }
+};
+
+
+TEST_F(MathTest, SinCosUlpBound) {
+  double max_sin = 0, max_cos = 0;
+  for ( int i=0; i<200000; ++i ) {
+    const double x = i%2 ? uniform(-4*M_PI,4*M_PI) : uniform(-100,100);
+    double s, c;
+    vmath::sincos(x,&s,&c);
+    max_sin = std::max( max_sin, ulps(s,sinl(x)) );
+    max_cos = std::max( max_cos, ulps(c,cosl(x)) );
+  }
+  EXPECT_LT( max_sin, 1.0 );
+  EXPECT_LT( max_cos, 1.0 );
+  std::cout << " -- sin max ulp: " << max_sin << std::endl
+            << " -- cos max ulp: " << max_cos << std::endl;
+}
+
+
+TEST_F(MathTest, TanUlpBound) {
+  double max_tan = 0;
+  for ( int i=0; i<200000; ++i ) {
+    const double x = uniform(-1.5,1.5);
+    max_tan = std::max( max_tan, ulps(vmath::tan(x),tanl(x)) );
+  }
+  EXPECT_LT( max_tan, 2.5 );
+  std::cout << " -- tan max ulp: " << max_tan << std::endl;
+}
+
+
+TEST_F(MathTest, AtanUlpBound) {
+  double max_atan = 0;
+  for ( int i=0; i<200000; ++i ) {
+    const double x = i%2 ? uniform(-4,4) : uniform(-1e6,1e6);
+    max_atan = std::max( max_atan, ulps(vmath::atan(x),atanl(x)) );
+  }
+  EXPECT_LT( max_atan, 1.0 );
+  std::cout << " -- atan max ulp: " << max_atan << std::endl;
+}
+
+
+TEST_F(MathTest, Atan2UlpBound) {
+  double max_atan2 = 0;
+  for ( int i=0; i<200000; ++i ) {
+    const double y = uniform(-1,1);
+    const double x = uniform(-1,1);
+    max_atan2 = std::max( max_atan2, ulps(vmath::atan2(y,x),atan2l(y,x)) );
+  }
+  EXPECT_LT( max_atan2, 2.0 );
+  std::cout << " -- atan2 max ulp: " << max_atan2 << std::endl;
+}
+
+
+TEST_F(MathTest, SpecialValues) {
+  EXPECT_EQ( 0.0, vmath::sin(0.0) );
+  EXPECT_EQ( 1.0, vmath::cos(0.0) );
+  EXPECT_EQ( 0.0, vmath::atan(0.0) );
+  EXPECT_EQ( 0.0, vmath::atan2(0.0,0.0) );
+  EXPECT_DOUBLE_EQ(  M_PI_2, vmath::atan2( 1.0,0.0) );
+  EXPECT_DOUBLE_EQ( -M_PI_2, vmath::atan2(-1.0,0.0) );
+  EXPECT_DOUBLE_EQ(  M_PI,   vmath::atan2( 0.0,-1.0) );
+  EXPECT_DOUBLE_EQ( -M_PI,   vmath::atan2(-0.0,-1.0) );
+  // The signs of zeros pick the quadrant as in the C library.
+  const double y[] = { 1.0, -1.0, 0.0, -0.0, 0.0, -0.0, -0.0, 0.0, -0.0 };
+  const double x[] = { -0.0, -0.0, 0.0, 0.0, -0.0, -0.0, 1.0, -1.0, -1.0 };
+  for ( size_t i=0; i<sizeof(y)/sizeof(y[0]); ++i ) {
+    const double a = vmath::atan2(y[i],x[i]);
+    EXPECT_DOUBLE_EQ( atan2(y[i],x[i]), a ) << y[i] << ", " << x[i];
+    EXPECT_EQ( std::signbit(atan2(y[i],x[i])), std::signbit(a) )
+        << y[i] << ", " << x[i];
+    const float f = vmath::atan2(float(y[i]),float(x[i]));
+    EXPECT_FLOAT_EQ( atan2f(y[i],x[i]), f ) << y[i] << ", " << x[i];
+    EXPECT_EQ( std::signbit(atan2f(y[i],x[i])), std::signbit(f) )
+        << y[i] << ", " << x[i];
+  }
+  EXPECT_TRUE( std::signbit( vmath::atan(-0.0) ) );
+  EXPECT_DOUBLE_EQ(  M_PI_2, vmath::atan(HUGE_VAL) );
+  // Close to the pole the last bits of pi/2 in the reduction matters.
+  EXPECT_NEAR( tan(M_PI_2), vmath::tan(M_PI_2), 1e-14*tan(M_PI_2) );
+}
+
+
+TEST_F(MathTest, FloatUlpBounds) {
+  double max_sin = 0, max_cos = 0, max_tan = 0, max_atan = 0, max_atan2 = 0;
+  for ( int i=0; i<200000; ++i ) {
+    const float x = uniform(-4*M_PI,4*M_PI);
+    float s, c;
+    vmath::sincos(x,&s,&c);
+    max_sin = std::max( max_sin, ulpsf(s,sin(double(x))) );
+    max_cos = std::max( max_cos, ulpsf(c,cos(double(x))) );
+
+    const float t = uniform(-1.5,1.5);
+    max_tan = std::max( max_tan, ulpsf(vmath::tan(t),tan(double(t))) );
+
+    const float a = i%2 ? uniform(-4,4) : uniform(-1e6,1e6);
+    max_atan = std::max( max_atan, ulpsf(vmath::atan(a),atan(double(a))) );
+
+    const float y = uniform(-1,1);
+    max_atan2 = std::max( max_atan2,
+                          ulpsf(vmath::atan2(y,x),atan2(double(y),double(x))) );
+  }
+  EXPECT_LT( max_sin, 2.0 );
+  EXPECT_LT( max_cos, 2.0 );
+  EXPECT_LT( max_tan, 4.0 );
+  EXPECT_LT( max_atan, 3.0 );
+  EXPECT_LT( max_atan2, 3.5 );
+  std::cout << " -- sinf max ulp:   " << max_sin << std::endl
+            << " -- cosf max ulp:   " << max_cos << std::endl
+            << " -- tanf max ulp:   " << max_tan << std::endl
+            << " -- atanf max ulp:  " << max_atan << std::endl
+            << " -- atan2f max ulp: " << max_atan2 << std::endl;
+}
+
+
+// The vector operands must give exactly the same values as the scalar
+// versions, lane by lane.
+TEST_F(MathTest, VectorEqualsScalar) {
+  for ( int i=0; i<1000; ++i ) {
+    vdf x, y;
+    for ( int j=0; j<VINCENTY_LANES; ++j ) {
+      x[j] = uniform(-10,10);
+      y[j] = uniform(-10,10);
+    }
+    vdf s, c;
+    vmath::sincos(x,&s,&c);
+    const vdf t = vmath::atan2(y,x);
+    for ( int j=0; j<VINCENTY_LANES; ++j ) {
+      double sj, cj;
+      vmath::sincos(double(x[j]),&sj,&cj);
+      EXPECT_EQ( sj, s[j] );
+      EXPECT_EQ( cj, c[j] );
+      EXPECT_EQ( vmath::atan2(double(y[j]),double(x[j])), t[j] );
+    }
+  }
+  for ( int i=0; i<1000; ++i ) {
+    vsf x, y;
+    for ( int j=0; j<VINCENTY_FLOAT_LANES; ++j ) {
+      x[j] = uniform(-10,10);
+      y[j] = uniform(-10,10);
+    }
+    vsf s, c;
+    vmath::sincos(x,&s,&c);
+    const vsf t = vmath::atan2(y,x);
+    for ( int j=0; j<VINCENTY_FLOAT_LANES; ++j ) {
+      float sj, cj;
+      vmath::sincos(float(x[j]),&sj,&cj);
+      EXPECT_EQ( sj, s[j] );
+      EXPECT_EQ( cj, c[j] );
+      EXPECT_EQ( vmath::atan2(float(y[j]),float(x[j])), t[j] );
+    }
+  }
+}
+
+} // namespace end
@@ -0,0 +1,160 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/metrics.h"
+#include "vincenty/coordinate_grid.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+
+#include <pthread.h>
+
+#include <gtest/gtest.h>
+
+using namespace vincenty;
+
+namespace Test {
+
+/**
+ * Testing class for the metrics. The counters are global to the process, so
+ * every test compares two snapshots taken around the calls it makes.
+ */
+class MetricsTest : public testing::Test
+{
+ protected:
+  const vposition sw;
+  const vposition ne;
+
+  MetricsTest()
+      : sw(to_rad(55),to_rad(16)),
+        ne(to_rad(59.5),to_rad(16.5))
+  {
+  }
+};
+
+// Solves 100 inverse problems, the distances are added to sum.
+void* solve_in_thread( void* sum )
+{
+  for ( int i=0; i<100; ++i ) {
+    const vdirection dir = inverse( 0.1, 0.2, 0.3, 0.4 + i*1e-3 );
+    *static_cast<double*>(sum) += dir.distance;
+  }
+  return 0;
+}
+
+
+#ifndef VINCENTY_NO_METRICS
+TEST_F(MetricsTest, DirectAndInverseAreCounted) {
+  const metrics_snapshot before = metrics();
+  const vdirection dir = inverse( sw, ne );
+  const vposition pos = direct( sw, dir );
+  convergence info;
+  inverse( sw.coords.a[0], sw.coords.a[1], ne.coords.a[0], ne.coords.a[1],
+           default_accuracy, &info );
+  const metrics_snapshot after = metrics();
+
+  EXPECT_NEAR( ne.coords.a[0], pos.coords.a[0], 1e-12 );
+  EXPECT_EQ( 1u, after.direct_calls  - before.direct_calls );
+  EXPECT_EQ( 2u, after.inverse_calls - before.inverse_calls );
+  EXPECT_LE( 3u, after.iterations    - before.iterations );
+  EXPECT_EQ( 0u, after.not_converged - before.not_converged );
+}
+
+TEST_F(MetricsTest, BatchesAreCountedPerPair) {
+  const size_t n = 10;
+  std::vector<double> lat1(n,0.1), lon1(n,0.2), lat2(n,0.3), lon2(n);
+  std::vector<double> b1(n), s(n), b2(n);
+  for ( size_t i=0; i<n; ++i ) {
+    lon2[i] = 0.4 + i*1e-2;
+  }
+
+  const metrics_snapshot before = metrics();
+  iteration_histogram hist;
+  inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                 &b1[0], &s[0], &b2[0], n, default_accuracy, &hist );
+  direct_batch( &lat1[0], &lon1[0], &b1[0], &s[0],
+                &lat2[0], &lon2[0], n );
+  const metrics_snapshot after = metrics();
+
+  EXPECT_EQ( n, after.inverse_calls - before.inverse_calls );
+  EXPECT_EQ( n, after.direct_calls  - before.direct_calls );
+  EXPECT_EQ( n, hist.total() ) << "The caller's histogram is still filled";
+  EXPECT_LE( 2*n, after.iterations - before.iterations );
+}
+
+TEST_F(MetricsTest, ExitedThreadsAreMerged) {
+  const metrics_snapshot before = metrics();
+  pthread_t threads[4];
+  double sum[4] = { 0, 0, 0, 0 };
+  for ( int t=0; t<4; ++t ) {
+    ASSERT_EQ( 0, pthread_create( &threads[t], 0, &solve_in_thread, &sum[t] ) );
+  }
+  for ( int t=0; t<4; ++t ) {
+    pthread_join( threads[t], 0 );
+  }
+  const metrics_snapshot after = metrics();
+
+  EXPECT_EQ( 400u, after.inverse_calls - before.inverse_calls );
+  EXPECT_LT( 0.0, sum[0] + sum[1] + sum[2] + sum[3] );
+}
+
+TEST_F(MetricsTest, GridWorkIsCounted) {
+  const metrics_snapshot before = metrics();
+  coordinate::CoordinateGrid cg(sw,ne);
+  cg.setVirtualGridSize(8);
+  cg.split();
+  const vposition a = cg(1,1);
+  const vposition b = cg(2,3);
+  const metrics_snapshot after = metrics();
+
+  EXPECT_FALSE( a == b );
+  EXPECT_EQ( 1u,  after.grid_splits    - before.grid_splits );
+  EXPECT_EQ( 16u, after.grid_positions - before.grid_positions );
+  EXPECT_EQ( 2u,  after.grid_lookups   - before.grid_lookups );
+}
+#endif
+
+TEST_F(MetricsTest, PrometheusText) {
+  metrics_snapshot m;
+  m.inverse_calls = 42;
+  m.grid_lookups  = 7;
+
+  std::ostringstream os;
+  write_prometheus( os, m );
+  const std::string text = os.str();
+
+  EXPECT_NE( std::string::npos,
+             text.find("# TYPE vincenty_inverse_calls_total counter\n") );
+  EXPECT_NE( std::string::npos,
+             text.find("\nvincenty_inverse_calls_total 42\n") );
+  EXPECT_NE( std::string::npos,
+             text.find("\nvincenty_grid_lookups_total 7\n") );
+  EXPECT_NE( std::string::npos,
+             text.find("\nvincenty_not_converged_total 0\n") );
+}
+
+TEST_F(MetricsTest, PrometheusFile) {
+  char path[] = "/tmp/vincenty_metrics_XXXXXX";
+  const int fd = mkstemp(path);
+  ASSERT_NE( -1, fd );
+  close(fd);
+
+  metrics_snapshot m;
+  m.direct_calls = 3;
+  ASSERT_TRUE( write_prometheus( std::string(path), m ) );
+
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  EXPECT_NE( std::string::npos,
+             text.str().find("\nvincenty_direct_calls_total 3\n") );
+  EXPECT_FALSE( std::ifstream( (std::string(path) + ".tmp").c_str() ) )
+      << "The temporary file is renamed";
+  std::remove(path);
+
+  EXPECT_FALSE( write_prometheus( std::string("/nonexistent/x.prom"), m ) );
+}
+
+}
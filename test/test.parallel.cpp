@@ -0,0 +1,217 @@
+// -*- mode:c++; indent-tabs-mode:nil; -*-
+
+#include "vincenty/parallel.h"
+
+#include <cstdlib>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include <gtest/gtest.h>
+
+using namespace vincenty;
+
+namespace Test {
+
+/**
+ * Testing class for the multi-threaded batches. Every result must be the same
+ * as that of the single threaded batch functions, whatever the number of
+ * threads and however the chunks were stolen.
+ */
+class ParallelTest : public testing::Test
+{
+ protected:
+  std::vector<double> lat1;
+  std::vector<double> lon1;
+  std::vector<double> lat2;
+  std::vector<double> lon2;
+  vposition_vector pos1;
+  vposition_vector pos2;
+
+  ParallelTest()
+      : lat1(), lon1(), lat2(), lon2(), pos1(), pos2()
+  {
+  }
+
+  // Random pairs, every 50th nearly antipodal to make some chunks slow.
+  void generate( const size_t n ) {
+    srand48(123456789);
+    for ( size_t i=0; i<n; ++i ) {
+      const double lat = M_PI * ( drand48() - 0.5 );
+      const double lon = 2*M_PI * ( drand48() - 0.5 );
+      lat1.push_back( lat );
+      lon1.push_back( lon );
+      if ( i % 50 == 0 ) {
+        lat2.push_back( -lat + 1e-3 * drand48() );
+        lon2.push_back( lon + M_PI - 1e-3 * drand48() );
+      } else {
+        lat2.push_back( M_PI * ( drand48() - 0.5 ) );
+        lon2.push_back( 2*M_PI * ( drand48() - 0.5 ) );
+      }
+      pos1.push_back( vposition( lat1[i], lon1[i] ) );
+      pos2.push_back( vposition( lat2[i], lon2[i] ) );
+    }
+  }
+};
+
+struct concurrent_call
+{
+  const double* lat1;
+  const double* lon1;
+  const double* lat2;
+  const double* lon2;
+  std::vector<double>* distance;
+};
+
+
+TEST_F(ParallelTest, InverseMatchesBatch) {
+  const size_t n = 20011;
+  generate(n);
+  std::vector<double> b1(n), s(n), b2(n);
+  inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                 &b1[0], &s[0], &b2[0], n );
+
+  const unsigned int threads[] = { 1, 2, 3, 8 };
+  for ( size_t t=0; t<sizeof(threads)/sizeof(threads[0]); ++t ) {
+    std::vector<double> pb1(n), ps(n,-1), pb2(n);
+    parallel::inverse( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                       &pb1[0], &ps[0], &pb2[0], n, threads[t] );
+    for ( size_t i=0; i<n; ++i ) {
+      ASSERT_EQ( s[i],  ps[i] )  << "pair " << i << ", threads " << threads[t];
+      ASSERT_EQ( b1[i], pb1[i] ) << "pair " << i << ", threads " << threads[t];
+      ASSERT_EQ( b2[i], pb2[i] ) << "pair " << i << ", threads " << threads[t];
+    }
+  }
+
+  // Outputs which are not wanted may be null.
+  std::vector<double> ps(n);
+  parallel::inverse( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                     0, &ps[0], 0, n, 4 );
+  EXPECT_EQ( s, ps );
+}
+
+TEST_F(ParallelTest, DirectMatchesBatch) {
+  const size_t n = 10007;
+  generate(n);
+  std::vector<double> lat(n), lon(n), plat(n), plon(n);
+  direct_batch( &lat1[0], &lon1[0], &lon2[0], &lat2[0],
+                &lat[0], &lon[0], n );
+  parallel::direct( &lat1[0], &lon1[0], &lon2[0], &lat2[0],
+                    &plat[0], &plon[0], n, 4 );
+  EXPECT_EQ( lat, plat );
+  EXPECT_EQ( lon, plon );
+}
+
+TEST_F(ParallelTest, OneToManyMatchesSerial) {
+  const size_t n = 9001;
+  generate(n);
+  const prepared_position origin( pos1[0] );
+  std::vector<double> s(n), ps(n);
+  vdirection_vector dirs(n), pdirs(n);
+  inverse_one_to_many( origin, &pos2[0], &s[0], n );
+  inverse_one_to_many( origin, &pos2[0], &dirs[0], n );
+  parallel::inverse_one_to_many( pos1[0], &pos2[0], &ps[0], n, 4 );
+  parallel::inverse_one_to_many( pos1[0], &pos2[0], &pdirs[0], n, 4 );
+  EXPECT_EQ( s, ps );
+  for ( size_t i=0; i<n; ++i ) {
+    ASSERT_EQ( dirs[i].distance, pdirs[i].distance ) << "target " << i;
+    ASSERT_EQ( dirs[i].bearing1, pdirs[i].bearing1 ) << "target " << i;
+  }
+}
+
+TEST_F(ParallelTest, PairwiseRowsAreOneToMany) {
+  // Rows shorter and longer than a chunk, so that chunks span rows.
+  const size_t m = 7;
+  const size_t n = 3001;
+  generate(n);
+  std::vector<double> matrix(m*n);
+  parallel::inverse_pairwise( &pos1[0], m, &pos2[0], n, &matrix[0], 3 );
+  for ( size_t i=0; i<m; ++i ) {
+    std::vector<double> row(n);
+    inverse_one_to_many( prepared_position(pos1[i]), &pos2[0], &row[0], n );
+    for ( size_t j=0; j<n; ++j ) {
+      ASSERT_EQ( row[j], matrix[i*n+j] ) << "row " << i << ", column " << j;
+    }
+  }
+}
+
+TEST_F(ParallelTest, EmptyAndTiny) {
+  generate(3);
+  parallel::inverse( 0, 0, 0, 0, 0, 0, 0, 0, 4 );
+  std::vector<double> s(3);
+  parallel::inverse( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                     0, &s[0], 0, 3, 64 );
+  for ( size_t i=0; i<3; ++i ) {
+    EXPECT_EQ( get_distance( pos1[i], pos2[i] ), s[i] );
+  }
+  EXPECT_LE( 1u, parallel::default_threads() );
+}
+
+void* call_parallel( void* arg )
+{
+  concurrent_call& c = *static_cast<concurrent_call*>(arg);
+  const size_t n = c.distance->size();
+  parallel::inverse( c.lat1, c.lon1, c.lat2, c.lon2,
+                     0, &(*c.distance)[0], 0, n, 4 );
+  return 0;
+}
+
+TEST_F(ParallelTest, ConcurrentCallers) {
+  const size_t n = 50000;
+  generate(n);
+  std::vector<double> s(n);
+  inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0], 0, &s[0], 0, n );
+
+  // The pool runs one call at a time, the others run on their own threads.
+  const int callers = 4;
+  std::vector< std::vector<double> > results( callers, std::vector<double>(n) );
+  concurrent_call calls[callers];
+  pthread_t threads[callers];
+  for ( int t=0; t<callers; ++t ) {
+    calls[t].lat1     = &lat1[0];
+    calls[t].lon1     = &lon1[0];
+    calls[t].lat2     = &lat2[0];
+    calls[t].lon2     = &lon2[0];
+    calls[t].distance = &results[t];
+    ASSERT_EQ( 0, pthread_create( &threads[t], 0, &call_parallel, &calls[t] ) );
+  }
+  for ( int t=0; t<callers; ++t ) {
+    pthread_join( threads[t], 0 );
+    EXPECT_EQ( s, results[t] ) << "caller " << t;
+  }
+}
+
+TEST_F(ParallelTest, ForkedChild) {
+  const size_t n = 20011;
+  generate(n);
+  std::vector<double> s(n), ps(n);
+  inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0], 0, &s[0], 0, n );
+
+  // The pool threads are running, the child has none of them and must start
+  // its own. A hanging child is killed by the alarm.
+  parallel::inverse( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                     0, &ps[0], 0, n, 4 );
+  const pid_t child = fork();
+  ASSERT_LE( 0, child );
+  if ( child == 0 ) {
+    alarm( 10 );
+    std::vector<double> cs(n);
+    parallel::inverse( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                       0, &cs[0], 0, n, 4 );
+    parallel::inverse( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                       0, &cs[0], 0, n, 4 );
+    _exit( cs == s ? 0 : 1 );
+  }
+  int status = 0;
+  ASSERT_EQ( child, waitpid( child, &status, 0 ) );
+  EXPECT_TRUE( WIFEXITED(status) ) << "signal " << WTERMSIG(status);
+  EXPECT_EQ( 0, WEXITSTATUS(status) );
+
+  // The pool of the parent is still there.
+  parallel::inverse( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                     0, &ps[0], 0, n, 4 );
+  EXPECT_EQ( s, ps );
+}
+
+}
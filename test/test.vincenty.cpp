@@ -431,6 +431,151 @@ TEST_F(VincentyBasicTest, AritmeticOperatorsAreOk) {
       << "Traveling along two paths should have resulted in same position!";
 }
 
+
+// The prepared overloads shall give the same result as the plain inverse.
+TEST_F(VincentyBasicTest, PreparedPositionsMatchInverse) {
+  const vposition pos[] = { p1, p2, sweden, la00lo00, la10lo10,
+                            northpole, southpole };
+  const size_t n = sizeof(pos)/sizeof(pos[0]);
+  for ( size_t i=0; i<n; ++i ) {
+    const prepared_position from(pos[i]);
+    for ( size_t j=0; j<n; ++j ) {
+      const vdirection d1 = inverse(pos[i],pos[j]);
+      const vdirection d2 = inverse(from,prepared_position(pos[j]));
+      const vdirection d3 = inverse(from,pos[j]);
+      EXPECT_NEAR( d1.distance, d2.distance, 1e-6 ) << i << " " << j;
+      EXPECT_NEAR( d1.bearing1, d2.bearing1, 1e-12 ) << i << " " << j;
+      EXPECT_NEAR( d1.bearing2, d2.bearing2, 1e-12 ) << i << " " << j;
+      EXPECT_EQ( d2.distance, d3.distance ) << i << " " << j;
+    }
+  }
+}
+
+
+// A prepared position is still the position it was created from.
+TEST_F(VincentyBasicTest, PreparedPositionKeepsPosition) {
+  const prepared_position pp(sweden);
+  EXPECT_EQ( sweden, pp.position );
+  EXPECT_NEAR( 1.0, pp.sin_U*pp.sin_U + pp.cos_U*pp.cos_U, 1e-15 );
+  EXPECT_EQ( 0.0, inverse(pp,pp).distance );
+
+  const prepared_position origin;
+  EXPECT_EQ( 0.0, origin.sin_U );
+  EXPECT_EQ( 1.0, origin.cos_U );
+}
+
+// The WGS84 instantiation is the plain function, a runtime WGS84 object must
+// give the same result.
+TEST_F(VincentyBasicTest, EllipsoidWgs84IsDefault) {
+  const ellipsoid wgs(( wgs84() ));
+  const double lat1 = p1.coords.a[0], lon1 = p1.coords.a[1];
+  const double lat2 = p2.coords.a[0], lon2 = p2.coords.a[1];
+  const vdirection d = inverse(lat1,lon1,lat2,lon2);
+  EXPECT_EQ( d.distance, inverse<wgs84>(lat1,lon1,lat2,lon2).distance );
+  EXPECT_NEAR( d.distance, inverse(wgs,lat1,lon1,lat2,lon2).distance, 1e-6 );
+  EXPECT_NEAR( d.bearing1, inverse(wgs,lat1,lon1,lat2,lon2).bearing1, 1e-12 );
+
+  const vposition p = direct(lat1,lon1,d.bearing1,d.distance);
+  EXPECT_EQ( p, direct<wgs84>(lat1,lon1,d.bearing1,d.distance) );
+  EXPECT_EQ( p, direct(wgs,lat1,lon1,d.bearing1,d.distance) );
+
+  const ellipsoid published = ellipsoid::from_flattening(6378137,298.257223563);
+  EXPECT_NEAR( wgs84::b(), published.b(), 1e-3 );
+  EXPECT_NEAR( wgs84::f(), published.f(), 1e-10 );
+}
+
+
+// On a sphere the geodesic is a great circle, compare with haversine.
+TEST_F(VincentyBasicTest, EllipsoidSphere) {
+  const double R = 6371000;
+  const ellipsoid sphere(R,R);
+  const vposition pos[] = { p1, p2, sweden, la10lo10 };
+  for ( size_t i=0; i<4; ++i ) {
+    const vposition& q = i ? pos[i-1] : la00lo00;
+    const double dlat = pos[i].coords.a[0] - q.coords.a[0];
+    const double dlon = pos[i].coords.a[1] - q.coords.a[1];
+    const double h =
+        sin(dlat/2)*sin(dlat/2) +
+        cos(q.coords.a[0])*cos(pos[i].coords.a[0])*sin(dlon/2)*sin(dlon/2);
+    const double s = 2*R*asin(sqrt(h));
+    EXPECT_NEAR( s, inverse(sphere,q.coords.a[0],q.coords.a[1],
+                            pos[i].coords.a[0],pos[i].coords.a[1]).distance,
+                 1e-6 ) << "Index: " << i;
+  }
+}
+
+
+// Direct and inverse must be each others inverse on the other ellipsoids,
+// and the batch functions agree with the scalar ones.
+TEST_F(VincentyBasicTest, EllipsoidRoundTrip) {
+  const ellipsoid ells[] = { ellipsoid(grs80()), ellipsoid(bessel1841()) };
+  for ( size_t k=0; k<2; ++k ) {
+    const ellipsoid& e = ells[k];
+    const double lat1 = sweden.coords.a[0], lon1 = sweden.coords.a[1];
+    const double lat2 = p1.coords.a[0], lon2 = p1.coords.a[1];
+    const vdirection d = inverse(e,lat1,lon1,lat2,lon2);
+    const vposition p = direct(e,lat1,lon1,d.bearing1,d.distance);
+    EXPECT_NEAR( lat2, p.coords.a[0], 1e-12 );
+    EXPECT_NEAR( lon2, p.coords.a[1], 1e-12 );
+
+    double b1, s, b2, la, lo;
+    inverse_batch(e,&lat1,&lon1,&lat2,&lon2,&b1,&s,&b2,1);
+    direct_batch(e,&lat1,&lon1,&b1,&s,&la,&lo,1);
+    EXPECT_NEAR( d.distance, s, 1e-6 );
+    EXPECT_NEAR( d.bearing1, b1, 1e-12 );
+    EXPECT_NEAR( lat2, la, 1e-12 );
+    EXPECT_NEAR( lon2, lo, 1e-12 );
+  }
+
+  // Bessel is a smaller ellipsoid, GRS80 and WGS84 differs by 0.1 mm in b.
+  const double wgs = get_distance(sweden,p1);
+  EXPECT_NEAR( wgs, inverse<grs80>(sweden.coords.a[0],sweden.coords.a[1],
+                                   p1.coords.a[0],p1.coords.a[1]).distance,
+               1e-3 );
+  EXPECT_GT( wgs, inverse<bessel1841>(sweden.coords.a[0],sweden.coords.a[1],
+                                      p1.coords.a[0],p1.coords.a[1]).distance );
+}
+
+// A datum the library knows nothing about, computed through an ellipsoid.
+struct clarke1866 : ellipsoid_traits<clarke1866>
+{
+  static double a() { return 6378206.4; }
+  static double b() { return 6356583.8; }
+};
+
+template <typename E> void
+expect_traits_match_ellipsoid( const vposition& q1, const vposition& q2 ) {
+  const ellipsoid e = ellipsoid(E());
+  const double lat1 = q1.coords.a[0], lon1 = q1.coords.a[1];
+  const double lat2 = q2.coords.a[0], lon2 = q2.coords.a[1];
+
+  const vdirection d = inverse(e,lat1,lon1,lat2,lon2);
+  const vdirection t = inverse<E>(lat1,lon1,lat2,lon2);
+  EXPECT_NEAR( d.distance, t.distance, 1e-8 );
+  EXPECT_NEAR( d.bearing1, t.bearing1, 1e-14 );
+  EXPECT_NEAR( d.bearing2, t.bearing2, 1e-14 );
+  const vposition p = direct(e,lat1,lon1,d.bearing1,d.distance);
+  const vposition tp = direct<E>(lat1,lon1,d.bearing1,d.distance);
+  EXPECT_NEAR( p.coords.a[0], tp.coords.a[0], 1e-14 );
+  EXPECT_NEAR( p.coords.a[1], tp.coords.a[1], 1e-14 );
+
+  double b1, s, b2, la, lo;
+  inverse_batch<E>(&lat1,&lon1,&lat2,&lon2,&b1,&s,&b2,1);
+  direct_batch<E>(&lat1,&lon1,&b1,&s,&la,&lo,1);
+  EXPECT_NEAR( t.distance, s, 1e-6 );
+  EXPECT_NEAR( t.bearing1, b1, 1e-12 );
+  EXPECT_NEAR( lat2, la, 1e-12 );
+  EXPECT_NEAR( lon2, lo, 1e-12 );
+}
+
+// The traits with folded constants agree with the ellipsoid objects.
+TEST_F(VincentyBasicTest, EllipsoidTraits) {
+  expect_traits_match_ellipsoid<wgs84>(sweden,p1);
+  expect_traits_match_ellipsoid<grs80>(sweden,p1);
+  expect_traits_match_ellipsoid<bessel1841>(sweden,p1);
+  expect_traits_match_ellipsoid<clarke1866>(sweden,p1);
+}
+
 // ---------------------------------------------------------------------------
 
 /**
@@ -635,143 +780,561 @@ TEST_F(VincentyVerificationTest, InverseReciprocity) {
 }
 
 
+TEST_F(VincentyVerificationTest, IterationsAreReported) {
+  convergence info;
+  const vdirection d = inverse( uddevalla.coords.a[0], uddevalla.coords.a[1],
+                                stockholm.coords.a[0], stockholm.coords.a[1],
+                                default_accuracy, &info );
+  EXPECT_EQ( d, inverse(uddevalla,stockholm) );
+  EXPECT_TRUE( info.converged );
+  EXPECT_LE( 1u, info.iterations );
+  EXPECT_GE( 8u, info.iterations );
+
+  // A finer accuracy never takes fewer iterations.
+  convergence coarse;
+  convergence fine;
+  inverse( uddevalla.coords.a[0], uddevalla.coords.a[1],
+           stockholm.coords.a[0], stockholm.coords.a[1], 1e-6, &coarse );
+  inverse( uddevalla.coords.a[0], uddevalla.coords.a[1],
+           stockholm.coords.a[0], stockholm.coords.a[1], 1e-14, &fine );
+  EXPECT_LE( coarse.iterations, fine.iterations );
+
+  const vposition p = direct( uddevalla.coords.a[0], uddevalla.coords.a[1],
+                              d.bearing1, d.distance, default_accuracy,
+                              &info );
+  EXPECT_EQ( p, direct(uddevalla,d) );
+  EXPECT_TRUE( info.converged );
+  EXPECT_LE( 1u, info.iterations );
+  EXPECT_GE( 6u, info.iterations );
+
+  // Nothing to iterate.
+  inverse( uddevalla.coords.a[0], uddevalla.coords.a[1],
+           uddevalla.coords.a[0], uddevalla.coords.a[1],
+           default_accuracy, &info );
+  EXPECT_EQ( 0u, info.iterations );
+  EXPECT_TRUE( info.converged );
+  direct( uddevalla.coords.a[0], uddevalla.coords.a[1], 1.0, 0.0,
+          default_accuracy, &info );
+  EXPECT_EQ( 0u, info.iterations );
+
+  // Lambda stops at its limit for nearly antipodal positions.
+  inverse( 0, 0, to_rad(0.5), to_rad(179.5), default_accuracy, &info );
+  EXPECT_FALSE( info.converged );
+  EXPECT_EQ( 8u, info.iterations );
+}
+
+
+TEST_F(VincentyVerificationTest, NearlyAntipodalConverges) {
+  // Lambda does not converge for any of these.
+  const double pairs[][4] = { {  0.0,   0.0,   0.0, 180.0   },
+                              {  0.0,   0.0,   0.0, 179.5   },
+                              {  0.0,   0.0,   0.5, 179.5   },
+                              { 10.0,   0.0, -10.0, 179.8   },
+                              {-30.0,  20.0,  30.2, -160.3  },
+                              { 45.0,   0.0, -45.0, 179.9999} };
+  for ( size_t i=0; i<sizeof(pairs)/sizeof(pairs[0]); ++i ) {
+    const vposition p1(to_rad(pairs[i][0]),to_rad(pairs[i][1]));
+    const vposition p2(to_rad(pairs[i][2]),to_rad(pairs[i][3]));
+    inverse_status status;
+    const vdirection d = inverse( p1.coords.a[0], p1.coords.a[1],
+                                  p2.coords.a[0], p2.coords.a[1],
+                                  default_accuracy, &status );
+    EXPECT_EQ( inverse_fallback, status ) << "Index: " << i;
+    EXPECT_EQ( d, inverse(p1,p2) ) << "Index: " << i;
+    // No longer than half a meridian, and the geodesic really ends in p2.
+    EXPECT_LT( d.distance, 20003931.459 ) << "Index: " << i;
+    const vposition q = direct(p1,d);
+    EXPECT_NEAR( p2.coords.a[0], q.coords.a[0], 1e-10 ) << "Index: " << i;
+    EXPECT_NEAR( 0, remainder(p2.coords.a[1]-q.coords.a[1],2*M_PI), 1e-10 )
+        << "Index: " << i;
+  }
+
+  // Over the pole, shorter than along the equator.
+  EXPECT_NEAR( 20003931.4586, inverse(0,0,0,M_PI).distance, 1e-3 );
+  EXPECT_LT( inverse(0,0,0,to_rad(179.5)).distance, M_PI*6378137*179.5/180 );
+
+  // Ordinary pairs are not affected.
+  inverse_status status;
+  inverse( uddevalla.coords.a[0], uddevalla.coords.a[1],
+           stockholm.coords.a[0], stockholm.coords.a[1],
+           default_accuracy, &status );
+  EXPECT_EQ( inverse_converged, status );
+}
+
+
+// Reference values from GeographicLib. Past the equatorial geodesic there are
+// two more roots on one side of 90 degrees, the opposite meridian is shortest
+// for any latitude off the equator.
+TEST_F(VincentyVerificationTest, NearlyAntipodalMatchesReference) {
+  const double pairs[][6] = {
+    // lat1,  lon1,   lat2,   lon2,    distance,       bearing1
+    { 0.0,   0.0,  0.0,   179.4,   19970715.5166, 83.826290 },
+    { 0.0,   0.0,  0.0,   179.405, 19971266.5841, 80.376993 },
+    { 0.001, 0.0, -0.001, 180.0,   20003931.4586,  0.0      },
+    { 0.01,  0.0, -0.01,  180.0,   20003931.4586,  0.0      } };
+  for ( size_t i=0; i<sizeof(pairs)/sizeof(pairs[0]); ++i ) {
+    inverse_status status;
+    const vdirection d = inverse( to_rad(pairs[i][0]), to_rad(pairs[i][1]),
+                                  to_rad(pairs[i][2]), to_rad(pairs[i][3]),
+                                  default_accuracy, &status );
+    EXPECT_EQ( inverse_fallback, status ) << "Index: " << i;
+    EXPECT_NEAR( pairs[i][4], d.distance, 1e-3 ) << "Index: " << i;
+    // Symmetric about the equator, 180 less the bearing is as short.
+    EXPECT_NEAR( sin(to_rad(pairs[i][5])), sin(d.bearing1), 1e-7 )
+        << "Index: " << i;
+  }
+}
+
+
+// ---------------------------------------------------------------------------
 
 /**
- * Testing class for pure performance estimates.
+ * Testing class for the batch functions. The batch functions must give the
+ * same results as the scalar functions they replace.
  */
-class VincentyPerformanceTest : public testing::Test
+class VincentyBatchTest : public testing::Test
 {
  protected:
-  vposition northpole;
-  vposition southpole;
+  std::vector<double> lat1;
+  std::vector<double> lon1;
+  std::vector<double> lat2;
+  std::vector<double> lon2;
 
-  vposvec positions;
-  vdirvec directions;
-
-  VincentyPerformanceTest()
-      : northpole( M_PI/2,0),
-        southpole(-M_PI/2,0),
-        positions(),
-        directions()
+  VincentyBatchTest()
+      : lat1(), lon1(), lat2(), lon2()
   {
   }
 
-  virtual void SetUp() {
-    // Setup things, which might throw.
+  // Random positions, same distribution as the basic tests.
+  void generate( const size_t n ) {
+    srand48(123456789);
+    for ( size_t i=0; i<n; ++i ) {
+      lat1.push_back( 2*M_PI * ( drand48() - 0.5 ) );
+      lon1.push_back(   M_PI * ( drand48() - 0.5 ) );
+      lat2.push_back( 2*M_PI * ( drand48() - 0.5 ) );
+      lon2.push_back(   M_PI * ( drand48() - 0.5 ) );
+    }
   }
 
-  virtual void TearDown() {
-    // Remove things setup by SetUp.
+  // Compares all pairs against the scalar inverse().
+  void expect_inverse_batch_equal( const double accuracy = default_accuracy ) {
+    const size_t n = lat1.size();
+    std::vector<double> b1(n), s(n), b2(n);
+    inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                   &b1[0], &s[0], &b2[0], n, accuracy );
+    for ( size_t i=0; i<n; ++i ) {
+      const vdirection d = inverse(lat1[i],lon1[i],lat2[i],lon2[i],accuracy);
+      EXPECT_NEAR( d.distance, s[i], 1e-6 ) << "Index: " << i;
+      EXPECT_NEAR( d.bearing1, b1[i], 1e-9 ) << "Index: " << i;
+      EXPECT_NEAR( d.bearing2, b2[i], 1e-9 ) << "Index: " << i;
+    }
   }
 };
 
 
-TEST_F(VincentyPerformanceTest,PerformanceTest) {
-  // Workout the amount of memory we have available.
-  const long numpages = sysconf(_SC_PHYS_PAGES);
-  const long pagesize = sysconf(_SC_PAGE_SIZE);
+TEST_F(VincentyBatchTest, InverseBatchMatchesInverse) {
+  generate(1000);
+  expect_inverse_batch_equal();
+  expect_inverse_batch_equal(1e-16);
+}
+
+
+// Sizes which are not a multiple of the vector width must not touch anything
+// outside the arrays.
+TEST_F(VincentyBatchTest, InverseBatchTailSizes) {
+  for ( size_t n=1; n<12; ++n ) {
+    lat1.clear(); lon1.clear(); lat2.clear(); lon2.clear();
+    generate(n);
+    std::vector<double> b1(n+1,-1), s(n+1,-1), b2(n+1,-1);
+    inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                   &b1[0], &s[0], &b2[0], n );
+    EXPECT_EQ( -1, b1[n] );
+    EXPECT_EQ( -1, s[n] );
+    EXPECT_EQ( -1, b2[n] );
+    expect_inverse_batch_equal();
+  }
+}
+
+
+// Positions along the equator takes the cos2_alpha == 0 path, mix them with
+// ordinary ones and identical positions in the same vector.
+TEST_F(VincentyBatchTest, InverseBatchEquatorialAndIdentical) {
+  for ( int i=0; i<16; ++i ) {
+    switch ( i%4 ) {
+      case 0: // Equator
+        lat1.push_back(0); lon1.push_back(0.1*(i+1));
+        lat2.push_back(0); lon2.push_back(-0.05*(i+1));
+        break;
+      case 1: // Identical
+        lat1.push_back(0.3); lon1.push_back(0.2*i);
+        lat2.push_back(0.3); lon2.push_back(0.2*i);
+        break;
+      default:
+        lat1.push_back(to_rad(58.4)); lon1.push_back(to_rad(15.6));
+        lat2.push_back(to_rad(59.3+i)); lon2.push_back(to_rad(18.1-i));
+    }
+  }
+  expect_inverse_batch_equal();
+
+  const size_t n = lat1.size();
+  std::vector<double> b1(n), s(n), b2(n);
+  inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                 &b1[0], &s[0], &b2[0], n );
+  for ( size_t i=1; i<n; i+=4 ) {
+    EXPECT_EQ( 0.0, s[i] ) << "Distance to self must be zero";
+  }
+}
+
+
+TEST_F(VincentyBatchTest, InverseBatchPositionVectors) {
+  generate(37);
+  vposition_vector pos1, pos2;
+  for ( size_t i=0; i<lat1.size(); ++i ) {
+    pos1.push_back(vposition(lat1[i],lon1[i]));
+    pos2.push_back(vposition(lat2[i],lon2[i]));
+  }
+  const vdirection_vector dirs = inverse_batch(pos1,pos2);
+  ASSERT_EQ( pos1.size(), dirs.size() );
+  for ( size_t i=0; i<dirs.size(); ++i ) {
+    const vdirection d = inverse(pos1[i],pos2[i]);
+    EXPECT_NEAR( d.distance, dirs[i].distance, 1e-6 );
+    EXPECT_NEAR( d.bearing1, dirs[i].bearing1, 1e-9 );
+    EXPECT_NEAR( d.bearing2, dirs[i].bearing2, 1e-9 );
+  }
+}
+
+
+// One origin against many targets, the origin itself is among the targets.
+TEST_F(VincentyBatchTest, InverseOneToManyMatchesInverse) {
+  generate(37);
+  const vposition origin(lat1[0],lon1[0]);
+  vposition_vector targets;
+  for ( size_t i=0; i<lat2.size(); ++i ) {
+    targets.push_back(vposition(lat2[i],lon2[i]));
+  }
+  targets[5] = origin;
+
+  const size_t n = targets.size();
+  const vdirection_vector dirs = inverse_one_to_many(origin,targets);
+  std::vector<double> s(n+1,-1);
+  inverse_one_to_many( prepared_position(origin), &targets[0], &s[0], n );
+  ASSERT_EQ( n, dirs.size() );
+  EXPECT_EQ( -1, s[n] );
+  for ( size_t i=0; i<n; ++i ) {
+    const vdirection d = inverse(origin,targets[i]);
+    EXPECT_NEAR( d.distance, dirs[i].distance, 1e-6 ) << "Index: " << i;
+    EXPECT_NEAR( d.bearing1, dirs[i].bearing1, 1e-9 ) << "Index: " << i;
+    EXPECT_NEAR( d.bearing2, dirs[i].bearing2, 1e-9 ) << "Index: " << i;
+    EXPECT_EQ( dirs[i].distance, s[i] ) << "Index: " << i;
+  }
+  EXPECT_EQ( 0.0, s[5] );
+}
+
+
+// The distance and bearing only functions must agree with inverse(),
+// identical and equatorial pairs included.
+TEST_F(VincentyBatchTest, DistanceAndBearingOnly) {
+  generate(101);
+  lat2[3] = lat1[3];
+  lon2[3] = lon1[3];
+  lat1[4] = lat2[4] = 0;
+  const size_t n = lat1.size();
+  std::vector<double> s(n+1,-1), b(n+1,-1);
+  get_distance( &lat1[0], &lon1[0], &lat2[0], &lon2[0], &s[0], n );
+  get_bearing( &lat1[0], &lon1[0], &lat2[0], &lon2[0], &b[0], n );
+  EXPECT_EQ( -1, s[n] );
+  EXPECT_EQ( -1, b[n] );
+  for ( size_t i=0; i<n; ++i ) {
+    const vposition p1(lat1[i],lon1[i]);
+    const vposition p2(lat2[i],lon2[i]);
+    const vdirection d = inverse(p1,p2);
+    EXPECT_NEAR( d.distance, get_distance(p1,p2), 1e-6 ) << "Index: " << i;
+    EXPECT_NEAR( d.bearing1, get_bearing(p1,p2), 1e-9 ) << "Index: " << i;
+    EXPECT_NEAR( d.distance, s[i], 1e-6 ) << "Index: " << i;
+    EXPECT_NEAR( d.bearing1, b[i], 1e-9 ) << "Index: " << i;
+  }
+  EXPECT_EQ( 0.0, s[3] );
+  EXPECT_EQ( 0.0, b[3] );
+}
+
 
-  // Approx amount of memory needed.
-  const unsigned int datasize = sizeof(vposition);
+// The fixed iteration versions must be within their documented error, and
+// the batch version agree with the scalar one.
+TEST_F(VincentyBatchTest, InverseFixedIterations) {
+  generate(1001);
+  const size_t n = lat1.size();
+  for ( size_t i=0; i<n; ++i ) {
+    // Keep the pairs within 1000 km.
+    const vposition p = direct(lat1[i],lon1[i],lon2[i]+M_PI,1e6*drand48());
+    lat2[i] = p.coords.a[0];
+    lon2[i] = p.coords.a[1];
+  }
+  lat2[7] = lat1[7];
+  lon2[7] = lon1[7];
+
+  std::vector<double> b1(n), s(n), b2(n);
+  inverse_batch_fixed<4>( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                          &b1[0], &s[0], &b2[0], n );
+  for ( size_t i=0; i<n; ++i ) {
+    const vdirection d = inverse(lat1[i],lon1[i],lat2[i],lon2[i]);
+    const vdirection f4 = inverse_fixed<4>(lat1[i],lon1[i],lat2[i],lon2[i]);
+    const vdirection f2 = inverse_fixed<2>(lat1[i],lon1[i],lat2[i],lon2[i]);
+    EXPECT_NEAR( d.distance, f4.distance, 2e-4 ) << "Index: " << i;
+    EXPECT_NEAR( d.distance, f2.distance, 12.0 ) << "Index: " << i;
+    EXPECT_NEAR( f4.distance, s[i], 1e-6 ) << "Index: " << i;
+    EXPECT_NEAR( f4.bearing1, b1[i], 1e-9 ) << "Index: " << i;
+    EXPECT_NEAR( f4.bearing2, b2[i], 1e-9 ) << "Index: " << i;
+  }
+  EXPECT_EQ( 0.0, s[7] );
+  EXPECT_EQ( 0.0, inverse_fixed<8>(lat1[7],lon1[7],lat2[7],lon2[7]).distance );
+}
+
+
+TEST_F(VincentyBatchTest, InverseBatchNearlyAntipodal) {
+  generate(1001);
+  const size_t n = lat1.size();
+  for ( size_t i=0; i<n; ++i ) {
+    // Every other pair is within a few kilometers of the antipode.
+    if ( i%2 ) {
+      lat2[i] = -lat1[i] + 1e-3 * ( drand48() - 0.5 );
+      lon2[i] =  lon1[i] + M_PI - 1e-3 * drand48();
+    }
+  }
+  std::vector<double> b1(n), s(n), b2(n);
+  inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                 &b1[0], &s[0], &b2[0], n );
+  for ( size_t i=0; i<n; ++i ) {
+    const vdirection d = inverse(lat1[i],lon1[i],lat2[i],lon2[i]);
+    EXPECT_NEAR( d.distance, s[i], 1e-6 ) << "Index: " << i;
+    EXPECT_NEAR( d.bearing1, b1[i], 1e-9 ) << "Index: " << i;
+    EXPECT_NEAR( d.bearing2, b2[i], 1e-9 ) << "Index: " << i;
+  }
+}
+
+
+TEST_F(VincentyBatchTest, IterationHistograms) {
+  generate(1001);
+  const size_t n = lat1.size();
+  lat2[3] = lat1[3];
+  lon2[3] = lon1[3];
+  lat2[5] = -lat1[5];
+  lon2[5] =  lon1[5] + M_PI - 1e-4;
+
+  // The batch histogram is the sum of what the scalar calls reports.
+  iteration_histogram expected;
+  for ( size_t i=0; i<n; ++i ) {
+    convergence info;
+    inverse(lat1[i],lon1[i],lat2[i],lon2[i],default_accuracy,&info);
+    if ( info.converged ) {
+      ++expected.converged[info.iterations];
+    } else {
+      ++expected.capped;
+    }
+  }
+  std::vector<double> b1(n), s(n), b2(n);
+  iteration_histogram hist;
+  inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                 &b1[0], &s[0], &b2[0], n, default_accuracy, &hist );
+  EXPECT_EQ( n, hist.total() );
+  EXPECT_EQ( expected.capped, hist.capped );
+  EXPECT_LE( 1u, hist.capped );
+  EXPECT_LE( 1u, hist.converged[0] );
+  for ( size_t k=0; k<iteration_histogram::bins; ++k ) {
+    EXPECT_EQ( expected.converged[k], hist.converged[k] ) << "Bin: " << k;
+  }
+  EXPECT_DOUBLE_EQ( expected.mean(), hist.mean() );
+
+  // Counts are added, and the histogram does not change the results.
+  std::vector<double> t(n);
+  inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                 0, &t[0], 0, n, default_accuracy, &hist );
+  EXPECT_EQ( 2*n, hist.total() );
+  for ( size_t i=0; i<n; ++i ) {
+    EXPECT_EQ( s[i], t[i] ) << "Index: " << i;
+  }
+
+  std::vector<double> bearing(n), distance(n), lat(n), lon(n);
+  iteration_histogram dexpected;
+  for ( size_t i=0; i<n; ++i ) {
+    bearing[i]  = 2*M_PI * drand48();
+    distance[i] = i%7 == 0 ? 0.0 : 2e7 * drand48();
+    convergence info;
+    direct(lat1[i],lon1[i],bearing[i],distance[i],default_accuracy,&info);
+    if ( info.converged ) {
+      ++dexpected.converged[info.iterations];
+    } else {
+      ++dexpected.capped;
+    }
+  }
+  iteration_histogram dhist;
+  direct_batch( &lat1[0], &lon1[0], &bearing[0], &distance[0],
+                &lat[0], &lon[0], n, default_accuracy, &dhist );
+  EXPECT_EQ( n, dhist.total() );
+  EXPECT_EQ( dexpected.capped, dhist.capped );
+  for ( size_t k=0; k<iteration_histogram::bins; ++k ) {
+    EXPECT_EQ( dexpected.converged[k], dhist.converged[k] ) << "Bin: " << k;
+  }
+}
 
-  // Large amount of positions?
-  size_t numpositions = 2e5;
 
-  unsigned long memsize;
-  if ( numpages > 0 && pagesize > 0 ) {
-    std::cout << " -- Detected " << ((numpages*pagesize)>>20)
-              << "MiB of memory" << std::endl;
-    memsize = numpages*pagesize;
-  } else {
-    std::cout << " -- Could not detect available memory!"
-              << " Assuming there is at least 128MiB" << std::endl;
-    memsize = 128*1024*1024;
+TEST_F(VincentyBatchTest, DirectBatchMatchesDirect) {
+  generate(1001);
+  const size_t n = lat1.size();
+  std::vector<double> bearing(n), distance(n), lat(n), lon(n);
+  for ( size_t i=0; i<n; ++i ) {
+    bearing[i]  = 2*M_PI * drand48();
+    distance[i] = i%7 == 0 ? 0.0 : 2e7 * drand48();
+  }
+  direct_batch( &lat1[0], &lon1[0], &bearing[0], &distance[0],
+                &lat[0], &lon[0], n );
+  for ( size_t i=0; i<n; ++i ) {
+    const vposition p = direct(lat1[i],lon1[i],bearing[i],distance[i]);
+    EXPECT_NEAR( p.coords.a[0], lat[i], 1e-12 ) << "Index: " << i;
+    EXPECT_NEAR( p.coords.a[1], lon[i], 1e-12 ) << "Index: " << i;
   }
+}
+
 
-  if ( numpositions*datasize > memsize/2 ) {
-    numpositions = memsize/datasize;
-    std::cout << " -- Available memory not enough for 2e6 datapoints!" << std::endl;
+TEST_F(VincentyBatchTest, DirectBatchPositionVectors) {
+  generate(13);
+  vposition_vector pos;
+  vdirection_vector dirs;
+  for ( size_t i=0; i<lat1.size(); ++i ) {
+    pos.push_back(vposition(lat1[i],lon1[i]));
+    dirs.push_back(vdirection(lat2[i]+M_PI,1e3*i));
   }
+  const vposition_vector dest = direct_batch(pos,dirs);
+  ASSERT_EQ( pos.size(), dest.size() );
+  EXPECT_TRUE( pos[0] == dest[0] ) << "Traveling 0.0m must not change position!";
+  for ( size_t i=0; i<dest.size(); ++i ) {
+    const vposition p = direct(pos[i],dirs[i]);
+    EXPECT_NEAR( p.coords.a[0], dest[i].coords.a[0], 1e-12 );
+    EXPECT_NEAR( p.coords.a[1], dest[i].coords.a[1], 1e-12 );
+  }
+}
 
-  std::cout << " -- Using " << numpositions << " datapoints "
-            << "(" << (numpositions*datasize>>20) << "MiB)" << std::endl;
 
-  // Reserve space.
-  positions.reserve(numpositions);
 
-  // Generate a lot of random positions.
+TEST_F(VincentyBatchTest, IsaSelection) {
+  const isa_level initial = get_isa();
+  EXPECT_LE( initial, get_best_isa() );
+  EXPECT_TRUE( set_isa(isa_sse2) );
+  EXPECT_EQ( isa_sse2, get_isa() );
+  EXPECT_STREQ( "sse2", isa_name(isa_sse2) );
+  EXPECT_STREQ( "avx2", isa_name(isa_avx2) );
+  EXPECT_STREQ( "avx512", isa_name(isa_avx512) );
+  EXPECT_TRUE( set_isa(initial) );
+  EXPECT_EQ( initial, get_isa() );
+}
+
+
+// Every level the host supports must agree with the baseline, apart from the
+// last bits (FMA contracts some of the products).
+TEST_F(VincentyBatchTest, IsaLevelsAgree) {
+  generate(103);
+  const size_t n = lat1.size();
+  const isa_level initial = get_isa();
+
+  ASSERT_TRUE( set_isa(isa_sse2) );
+  std::vector<double> b1(n), s(n), b2(n), lat(n), lon(n);
+  inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                 &b1[0], &s[0], &b2[0], n );
+  direct_batch( &lat1[0], &lon1[0], &lat2[0], &s[0], &lat[0], &lon[0], n );
+
+  for ( int level=isa_avx2; level<=get_best_isa(); ++level ) {
+    ASSERT_TRUE( set_isa(isa_level(level)) );
+    std::vector<double> vb1(n), vs(n), vb2(n), vlat(n), vlon(n);
+    inverse_batch( &lat1[0], &lon1[0], &lat2[0], &lon2[0],
+                   &vb1[0], &vs[0], &vb2[0], n );
+    direct_batch( &lat1[0], &lon1[0], &lat2[0], &s[0], &vlat[0], &vlon[0], n );
+    for ( size_t i=0; i<n; ++i ) {
+      const vdirection d = inverse(lat1[i],lon1[i],lat2[i],lon2[i]);
+      EXPECT_NEAR( s[i], d.distance, 1e-6 ) << isa_name(get_isa()) << " " << i;
+      EXPECT_NEAR( s[i], vs[i], 1e-6 ) << isa_name(get_isa()) << " " << i;
+      EXPECT_NEAR( b1[i], vb1[i], 1e-9 ) << isa_name(get_isa()) << " " << i;
+      EXPECT_NEAR( b2[i], vb2[i], 1e-9 ) << isa_name(get_isa()) << " " << i;
+      EXPECT_NEAR( lat[i], vlat[i], 1e-12 ) << isa_name(get_isa()) << " " << i;
+      EXPECT_NEAR( lon[i], vlon[i], 1e-12 ) << isa_name(get_isa()) << " " << i;
+    }
+  }
+  set_isa(initial);
+}
+
+
+// The single precision functions against the double ones, the bounds are the
+// documented worst case errors.
+TEST_F(VincentyBatchTest, FloatInverseWithinDocumentedError) {
   srand48(123456789);
-  for ( size_t i=0; i<numpositions; ++i ) {
-    const double lat = 2*M_PI * ( drand48() - 0.5 );
-    const double lon =   M_PI * ( drand48() - 0.5 );
-    positions.push_back(vposition(lat,lon));
-  }
-
-  // Assert that we have enough positions.
-  ASSERT_GT( positions.size(), 1 );
-
-  // Compute "sibling" vdirection using inverse formula. Use the distance
-  // computed for a calculation so that the compiler does not optimize away
-  // anything.
-  struct timeval tm_start, tm_stop;
-  double avg_distance = 0.0;
-  std::vector<vposition>::const_iterator first, second;
-  size_t i;
-  gettimeofday( &tm_start, 0 );
-  for ( first = positions.begin(), second = positions.begin()+1, i=1;
-        second != positions.end();
-        ++first, ++second, ++i )
-  {
-    const vdirection dir = inverse(*first,*second);
-    avg_distance = ( avg_distance * i + dir.distance ) / ( i + 1 );
+  const size_t n = 20000;
+  std::vector<float> la1(n), lo1(n), la2(n), lo2(n), b1(n), s(n), b2(n);
+  for ( size_t i=0; i<n; ++i ) {
+    la1[i] =   M_PI * ( drand48() - 0.5 );
+    lo1[i] = 2*M_PI * ( drand48() - 0.5 );
+    // Every fourth pair is short, below 10km.
+    la2[i] = i%4 ? M_PI   * ( drand48() - 0.5 ) : la1[i] + 1e-3*drand48();
+    lo2[i] = i%4 ? 2*M_PI * ( drand48() - 0.5 ) : lo1[i] + 1e-3*drand48();
+  }
+  inverse_batchf( &la1[0], &lo1[0], &la2[0], &lo2[0],
+                  &b1[0], &s[0], &b2[0], n );
+  for ( size_t i=0; i<n; ++i ) {
+    const vdirection d = inverse(la1[i],lo1[i],la2[i],lo2[i]);
+    if ( d.distance > 19.9e6 ) {
+      continue; // Nearly antipodal.
+    }
+    const vdirection f = inversef(la1[i],lo1[i],la2[i],lo2[i]);
+    const double bound = d.distance < 1e5 ? 2.0 : 8.0;
+    EXPECT_NEAR( d.distance, f.distance, bound ) << "Index: " << i;
+    EXPECT_NEAR( d.distance, s[i], bound ) << "Index: " << i;
+    if ( d.distance > 1e4 ) {
+      EXPECT_NEAR( 0, remainder(d.bearing1-f.bearing1,2*M_PI), 1e-4 );
+      EXPECT_NEAR( 0, remainder(d.bearing2-f.bearing2,2*M_PI), 1e-4 );
+      EXPECT_NEAR( 0, remainder(d.bearing1-b1[i],2*M_PI), 1e-4 );
+      EXPECT_NEAR( 0, remainder(d.bearing2-b2[i],2*M_PI), 1e-4 );
+    }
   }
-  gettimeofday( &tm_stop, 0 );
 
-  const double inv_seconds =
-      ( ( tm_stop.tv_sec  - tm_start.tv_sec  ) +
-        ( tm_stop.tv_usec - tm_start.tv_usec ) / 1.e6 );
+  // Identical positions gives zero.
+  EXPECT_EQ( 0.0, inversef(la1[0],lo1[0],la1[0],lo1[0]).distance );
+}
 
 
-  const double dirs[2] = {direction::east,direction::west};
+TEST_F(VincentyBatchTest, FloatDirectWithinDocumentedError) {
+  srand48(123456789);
+  const size_t n = 20000;
+  std::vector<float> la(n), lo(n), bearing(n), distance(n), la2(n), lo2(n);
+  for ( size_t i=0; i<n; ++i ) {
+    la[i]       =   M_PI * ( drand48() - 0.5 );
+    lo[i]       = 2*M_PI * ( drand48() - 0.5 );
+    bearing[i]  = 2*M_PI * drand48();
+    distance[i] = i%7 == 0 ? 0.0 : 2e7 * drand48();
+  }
+  direct_batchf( &la[0], &lo[0], &bearing[0], &distance[0],
+                 &la2[0], &lo2[0], n );
+  for ( size_t i=0; i<n; ++i ) {
+    const vposition d = direct(la[i],lo[i],bearing[i],distance[i]);
+    const vposition f = directf(la[i],lo[i],bearing[i],distance[i]);
+    EXPECT_GT( 8.0, get_distance(d,f) ) << "Index: " << i;
+    EXPECT_GT( 8.0, get_distance(d,vposition(la2[i],lo2[i])) ) << "Index: " << i;
+  }
+}
 
-  // Compute a "jump" and use the vposition.
-  double avg_latitude = 0.0;
-  double avg_longitude = 0.0;
-  gettimeofday( &tm_start, 0 );
-  for ( first = positions.begin(), i=1;
-        first != positions.end();
-        ++first, ++i )
-  {
-    const vposition pos = direct(*first,dirs[i%2],1e5);
-    avg_latitude  = ( avg_latitude  * i + pos.coords.a[0] ) / ( i + 1 );
-    avg_longitude = ( avg_longitude * i + pos.coords.a[1] ) / ( i + 1 );
-  }
-  gettimeofday( &tm_stop, 0 );
-
-  const double dir_seconds =
-      ( ( tm_stop.tv_sec  - tm_start.tv_sec  ) +
-        ( tm_stop.tv_usec - tm_start.tv_usec ) / 1.e6 );
-
-  const double inv_performance = (numpositions-1)/(inv_seconds*1000);
-  const double dir_performance = (numpositions  )/(dir_seconds*1000);
-
-  std::cout.setf(std::ios::fixed,std::ios::floatfield);
-  std::cout.precision(3);
-  std::cout
-      << " -- inverse()/sec: " << std::setw(8) << inv_performance << "k" << std::endl
-      << " -- direct()/sec:  " << std::setw(8) << dir_performance << "k" << std::endl
-      << " -- Inverse time:  " << std::setw(8) << inv_seconds << "s" << std::endl
-      << " -- Direct time:   " << std::setw(8) << dir_seconds << "s" << std::endl
-      << " -- Avg dist:      " << std::setw(8) << avg_distance/1000 << "km" << std::endl
-      << " -- Avg lat:       " << std::setprecision(8) << avg_latitude << std::endl
-      << " -- Avg lon:       " << std::setprecision(8) << avg_longitude << std::endl;
-
-  // This is highly machine dependent and should perhaps not be performed as a
-  // test like this.
-  //EXPECT_LT(750 ,inv_performance)
-  //    << "Performance is suspiciously low! Check accuracy or other anomalies.";
-  //EXPECT_LT(1200,dir_performance)
-  //    << "Performance is suspiciously low! Check accuracy or other anomalies.";
+
+TEST_F(VincentyBatchTest, FloatVectorOperands) {
+  v4sf_u la1, lo1, la2, lo2;
+  for ( int j=0; j<4; ++j ) {
+    la1.a[j] = to_rad(58.4);
+    lo1.a[j] = to_rad(15.6);
+    la2.a[j] = to_rad(57.7+j);
+    lo2.a[j] = to_rad(11.9+j);
+  }
+  v4sf_u b1, s, b2;
+  inverse_batchf( la1.v, lo1.v, la2.v, lo2.v, &b1.v, &s.v, &b2.v );
+  for ( int j=0; j<4; ++j ) {
+    const vdirection f = inversef(la1.a[j],lo1.a[j],la2.a[j],lo2.a[j]);
+    EXPECT_NEAR( f.distance, s.a[j], 2.0 );
+    EXPECT_NEAR( f.bearing1, b1.a[j], 1e-4 );
+    EXPECT_NEAR( f.bearing2, b2.a[j], 1e-4 );
+  }
 }
 
 } // namespace end